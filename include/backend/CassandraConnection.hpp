@@ -1,7 +1,9 @@
 #ifndef CASSANDRACONNECTION_HPP
 #define CASSANDRACONNECTION_HPP
 
+#include <backend/async/Async.hpp>
 #include <cassandra.h>
+#include <memory>
 #include <string>
 
 class CassandraConnection {
@@ -15,7 +17,10 @@ protected:
     std::string contact_points_;
     std::string username_;
     std::string password_;
-    
+
+    // Runs `statement` without waiting and frees it. The result is completed on a driver I/O
+    // thread, or failed with std::runtime_error; the connection must outlive it.
+    indiepub::Async<std::shared_ptr<const CassResult>> executeAsync(CassStatement* statement);
 
 public:
     CassandraConnection(const std::string& contact_points, const std::string& username, const std::string& password);
@@ -0,0 +1,31 @@
+#ifndef INDIEPUB_ENVIRONMENT_HPP
+#define INDIEPUB_ENVIRONMENT_HPP
+
+#include <chrono>
+#include <limits>
+#include <string>
+
+namespace indiepub
+{
+    // INDIEBACK_* variables overriding the config.h defaults. A value that does not parse or is
+    // out of range throws std::invalid_argument naming the variable, so a bad setting stops the
+    // server at startup instead of turning into a surprising limit.
+    namespace env
+    {
+        // The variable, or `fallback` when it is unset or empty.
+        std::string text(const char *name, const std::string &fallback);
+
+        // 1, true, on, yes or 0, false, off, no.
+        bool flag(const char *name, bool fallback);
+
+        // A whole number within [min, max].
+        long long number(const char *name, long long fallback, long long min = 0,
+                         long long max = std::numeric_limits<long long>::max());
+
+        std::chrono::milliseconds milliseconds(const char *name, long long fallback);
+
+        std::chrono::seconds seconds(const char *name, long long fallback);
+    }
+}
+
+#endif // INDIEPUB_ENVIRONMENT_HPP
@@ -0,0 +1,115 @@
+#ifndef INDIEPUB_ADMISSION_HPP
+#define INDIEPUB_ADMISSION_HPP
+
+#include <backend/api/RequestContext.hpp>
+#include <backend/api/Router.hpp>
+#include <http/Response.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace indiepub
+{
+    // Bounds how many requests of each RouteClass run at once, in front of the handlers.
+    //
+    // A request over its class limit, or over the limit shared by all classes, waits up to its
+    // class deadline for a slot and is otherwise turned away with 503 and Retry-After, as is
+    // one that finds its class queue full. Freed slots go to waiting classes in priority order:
+    // admin, writes, auth, reads; so browsing cannot starve writes.
+    //
+    // A waiting request holds its HTTP worker, so the shared limit must stay below the number of
+    // workers: the workers left over are where requests wait and priority picks who runs next.
+    class Admission
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t CLASSES = 4;
+
+        // Upper bounds of the queue wait histogram, in seconds.
+        static constexpr std::array<double, 7> WAIT_BUCKETS = {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0};
+
+        struct Limits
+        {
+            size_t concurrency;
+            size_t queue;                       // waiting requests; more are shed at once
+            std::chrono::milliseconds deadline; // longest wait for a slot
+        };
+
+        struct Options
+        {
+            size_t limit;                       // running requests of every class together
+            std::array<Limits, CLASSES> classes;
+            std::chrono::seconds retry_after;
+
+            // The config.h defaults, with the shared limit derived from `workers`, the HTTP worker
+            // threads of every listener together.
+            static Options defaults(size_t workers);
+
+            // defaults(), overridden by INDIEBACK_ADMISSION_* environment variables
+            static Options fromEnvironment(size_t workers);
+        };
+
+        explicit Admission(const Options &options);
+
+        Admission(const Admission &) = delete;
+        Admission &operator=(const Admission &) = delete;
+
+        // Sets the options instance() is built with; RESTfulAPI calls it at startup with the
+        // options it parsed, and it throws std::logic_error once instance() has been used.
+        static void configure(const Options &options);
+
+        // Built on first use from the configured options, or from the config.h defaults.
+        static Admission &instance();
+
+        static const char *name(RouteClass routeClass);
+
+        // ADMISSION_WORKER_PERCENT of `workers`, and at least one.
+        static size_t limitFor(size_t workers);
+
+        // Takes a slot for `routeClass`, waiting up to its deadline; false when shed.
+        bool admit(RouteClass routeClass);
+
+        void release(RouteClass routeClass);
+
+        // Middleware: admits the request for the class of its route and frees the slot when the
+        // request is over, or answers 503.
+        bool admit(RequestContext &context, HttpResponse &response);
+
+        // Prometheus text exposition of running and queued requests, sheds and queue waits.
+        std::string exposition() const;
+
+        const Options &options() const;
+
+    private:
+        struct Counters
+        {
+            std::atomic<std::uint64_t> admitted{0};
+            std::atomic<std::uint64_t> shed_full{0};
+            std::atomic<std::uint64_t> shed_deadline{0};
+            std::atomic<std::uint64_t> wait_us{0};
+            std::array<std::atomic<std::uint64_t>, WAIT_BUCKETS.size()> buckets{};
+        };
+
+        // With the lock held.
+        bool runnable(size_t index) const;
+
+        void record(size_t index, Clock::duration wait);
+
+        Options options_;
+
+        mutable std::mutex mutex_;
+        std::array<std::condition_variable, CLASSES> ready_;
+        std::array<size_t, CLASSES> running_{};
+        std::array<size_t, CLASSES> waiting_{};
+        size_t total_ = 0;
+
+        std::array<Counters, CLASSES> counters_;
+    };
+}
+
+#endif // INDIEPUB_ADMISSION_HPP
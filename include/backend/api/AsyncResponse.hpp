@@ -0,0 +1,63 @@
+#ifndef INDIEPUB_ASYNC_RESPONSE_HPP
+#define INDIEPUB_ASYNC_RESPONSE_HPP
+
+#include <http/Response.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace indiepub
+{
+    // Completion handle passed to asynchronous handlers. Copies share one response; whichever
+    // thread finishes the request, a driver callback or a crypto worker, calls complete() once
+    // and later calls are ignored.
+    class AsyncResponse
+    {
+    public:
+        AsyncResponse();
+
+        // Only before complete().
+        void setHeader(const std::string &name, const std::string &value);
+
+        bool complete(int status, const std::string &body);
+
+        // Status, status message and body of a response written by a handler; headers go
+        // through setHeader().
+        bool complete(const HttpResponse &response);
+
+        bool completed() const;
+
+        // Waits at most `timeout` for complete() and copies the outcome into `response`.
+        // Past the timeout the request is answered with 504 and a late complete() is dropped.
+        bool deliver(HttpResponse &response, std::chrono::milliseconds timeout);
+
+        // Runs `done` once the handler has called complete(), at once if it already has; a 504
+        // from deliver() does not count.
+        void whenComplete(std::function<void()> done);
+
+    private:
+        struct State
+        {
+            std::mutex mutex;
+            std::condition_variable ready;
+            bool done = false;
+            bool completed = false;     // by the handler, which may come after a 504
+            int status = 0;
+            std::string status_msg;
+            std::string body;
+            std::vector<std::pair<std::string, std::string>> headers;
+            std::vector<std::function<void()>> after;
+        };
+
+        bool complete(int status, const std::string &statusMsg, const std::string &body);
+
+        std::shared_ptr<State> state_;
+    };
+}
+
+#endif // INDIEPUB_ASYNC_RESPONSE_HPP
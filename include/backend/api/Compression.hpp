@@ -0,0 +1,65 @@
+#ifndef INDIEPUB_COMPRESSION_HPP
+#define INDIEPUB_COMPRESSION_HPP
+
+#include <backend/api/RequestContext.hpp>
+#include <http/Response.hpp>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace indiepub
+{
+    // gzip / deflate response bodies for clients that send Accept-Encoding.
+    //
+    // Used as a response filter: bodies below the size threshold, error responses and bodies a
+    // handler already encoded are left alone. Handlers serving a cached body can keep its
+    // compressed form next to it and mark the context, so the hot path does no zlib work.
+    class Compression
+    {
+    public:
+        struct Options
+        {
+            int level;          // zlib level 1-9; 0 turns compression off
+            size_t min_size;    // smaller bodies go out as they are
+
+            static Options defaults();
+
+            // defaults(), overridden by INDIEBACK_HTTP_COMPRESSION_* environment variables
+            static Options fromEnvironment();
+        };
+
+        explicit Compression(const Options &options);
+
+        // Sets the options instance() is built with; RESTfulAPI calls it at startup with the
+        // options it parsed, and it throws std::logic_error once instance() has been used.
+        static void configure(const Options &options);
+
+        // Built on first use from the configured options, or from the config.h defaults.
+        static const Compression &instance();
+
+        // The encoding the client prefers among gzip and deflate, or identity when it accepts
+        // neither; q=0 refuses an encoding.
+        static ContentEncoding negotiate(std::string_view acceptEncoding);
+
+        static const char *name(ContentEncoding encoding);
+
+        // gzip or zlib-wrapped deflate, the framing HTTP calls deflate. Empty on failure.
+        static std::string compress(std::string_view data, ContentEncoding encoding, int level);
+
+        // What this request gets: identity when compression is off.
+        ContentEncoding choose(const RequestContext &context) const;
+
+        std::string compress(std::string_view data, ContentEncoding encoding) const;
+
+        // Encodes the body when the client accepts it; while compression is on every response
+        // carries Vary: Accept-Encoding, compressed or not.
+        void apply(const RequestContext &context, HttpResponse &response) const;
+
+        const Options &options() const;
+
+    private:
+        Options options_;
+    };
+}
+
+#endif // INDIEPUB_COMPRESSION_HPP
@@ -2,19 +2,26 @@
 #define INDIEPUB_ENDPOINTS_HPP
 
 #include <http/Method.hpp>
-#include <http/Path.hpp>
 #include <http/Response.hpp>
 #include <http/Request.hpp>
 #include <crypto/AuthCrypto.hpp>
+#include <backend/api/AsyncResponse.hpp>
+#include <backend/api/RequestContext.hpp>
+#include <backend/api/Router.hpp>
+#include <backend/async/Task.hpp>
 #include <backend/controllers/CredentialsController.hpp>
 #include <backend/controllers/UsersController.hpp>
 #include <backend/controllers/EventController.hpp>
 #include <backend/controllers/VenuesController.hpp>
 #include <backend/controllers/VenueMembersController.hpp>
+#include <backend/cache/Caches.hpp>
 #include <string>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 class Endpoints
 {
@@ -24,54 +31,200 @@ private:
     
     static bool isValidPassword(const std::string &password);
 
-    static indiepub::CredentialsController getCredentialsController();
+    // Set once by configureAdmin before the server starts.
+    static std::string &adminToken();
+
+    // One connection per controller for the life of the process; the driver sessions are thread
+    // safe and coroutine handlers hold on to them across suspensions.
+    static indiepub::CredentialsController &getCredentialsController();
     
-    static indiepub::UsersController getUsersController();
+    static indiepub::UsersController &getUsersController();
+
+    static indiepub::EventController &getEventController();
+
+    static indiepub::VenuesController &getVenuesController();
+
+    static indiepub::VenueMembersController &getVenueMembersController();
+
+    static std::optional<indiepub::Credentials> loadCredentials(const std::string &token);
+
+    static std::optional<indiepub::User> loadUser(const std::string &user_id);
+
+    static std::optional<indiepub::Venue> loadVenue(const std::string &venue_id);
+
+    static std::optional<std::vector<indiepub::EventByVenue>> loadEvents(const std::string &window);
+
+    static indiepub::Credentials findCredentialsByToken(const std::string &token);
+
+    static indiepub::User findUserById(const std::string &user_id);
+
+    static indiepub::Venue findVenueById(const std::string &venue_id);
+
+    static std::vector<indiepub::EventByVenue> findEvents(bool upcomingOnly);
+
+    static indiepub::Async<std::optional<indiepub::Credentials>> loadCredentialsAsync(const std::string &token);
+
+    static indiepub::Async<std::optional<indiepub::User>> loadUserAsync(const std::string &user_id);
+
+    static indiepub::Async<std::optional<indiepub::Venue>> loadVenueAsync(const std::string &venue_id);
+
+    static indiepub::Async<std::optional<std::vector<indiepub::EventByVenue>>> loadEventsAsync(const std::string &window);
+
+    // `key` is a window, optionally followed by ":gzip" or ":deflate" for the encoded body.
+    static indiepub::Async<std::optional<std::string>> loadFeedAsync(const std::string &key);
+
+    // Like the blocking find* functions, a failed query reads as not found.
+    static indiepub::Task<indiepub::Credentials> findCredentialsByTokenAsync(std::string token);
+
+    static indiepub::Task<indiepub::User> findUserByIdAsync(std::string user_id);
+
+    static indiepub::Task<indiepub::Venue> findVenueByIdAsync(std::string venue_id);
+
+    static indiepub::Task<std::vector<indiepub::EventByVenue>> findEventsAsync(bool upcomingOnly);
+
+    static indiepub::Task<std::string> findFeedAsync(std::string key);
+
+    // Empty once the bearer token and x-user-id are checked and the context holds the
+    // credentials and user, otherwise why the request is not authenticated.
+    static indiepub::Task<std::string> authenticateAsync(indiepub::RequestContext &context);
+
+    static bool unauthorized(HttpResponse &response, const std::string &error);
+
+    // How the fields of a request body are protected.
+    struct BodyEncoding
+    {
+        bool sealed = false;
+        std::string key_id;             // x-key-id: backend key the RSA fields were encrypted to
+        std::string signature_key_id;   // x-signature-key-id: frontend key that signed the password
+    };
+
+    // Without a key id the current backend key is tried first, then each retired one.
+    static std::string rsaDecrypt(const std::string &value, const std::string &keyId);
+
+    // RSA decrypts run on the CryptoExecutor and throw CryptoOverloaded when its queue is full.
+    static std::string decryptMessage(const std::string &value, const std::string &keyId = "");
+
+    static std::vector<std::string> decryptMessages(const std::vector<std::string> &values, const std::string &keyId = "");
 
-    static indiepub::EventController getEventController();
+    // Checks a frontend signature with the named key, or with each published frontend key.
+    static bool checkSignature(const std::string &message, const std::vector<unsigned char> &signature, const std::string &keyId);
 
-    static indiepub::VenuesController getVenuesController();
+    static bool verifySignature(const std::string &message, const std::vector<unsigned char> &signature, const std::string &keyId);
 
-    static indiepub::VenueMembersController getVenueMembersController();
+    static indiepub::Async<bool> verifySignatureAsync(const std::string &message, const std::vector<unsigned char> &signature, const std::string &keyId);
 
-    static bool validateTokenAndId(const HttpRequest &request, HttpResponse &response, Path *path, indiepub::Credentials &creds, indiepub::User &user);
+    // Request body as JSON text. A body sealed with the client's session key (x-encryption: aes-256-gcm)
+    // is opened here and its fields arrive in clear; otherwise fields are RSA-encrypted one by one.
+    // Responds 401 and returns false when the session is unknown or the body fails authentication.
+    static bool readBody(const indiepub::RequestContext &context, HttpResponse &response, std::string &body, BodyEncoding &encoding);
 
-    static std::string decryptMessage(const std::string &value);
+    static std::string fieldValue(const std::string &value, const BodyEncoding &encoding);
+
+    static std::vector<std::string> fieldValues(const std::vector<std::string> &values, const BodyEncoding &encoding);
+
+    static indiepub::Async<std::string> fieldValueAsync(const std::string &value, const BodyEncoding &encoding);
+
+    using Coroutine = indiepub::Task<void> (*)(const indiepub::RequestContext &context, HttpResponse &response);
+
+    // Runs `handler` on a context over copies of the request and its params, off the HTTP worker,
+    // and completes `response` with what it wrote; an exception escaping the handler answers 500.
+    static void respond(const indiepub::RequestContext &context, indiepub::AsyncResponse response, Coroutine handler);
+
+    static indiepub::Task<void> reply(HttpRequest request, indiepub::RouteParams params, const indiepub::RequestContext &origin, indiepub::AsyncResponse response, Coroutine handler);
+
+    // A user by email and, when there is one, their credentials.
+    using Account = std::pair<indiepub::User, indiepub::Credentials>;
+
+    static indiepub::Task<Account> findAccount(std::string email);
+
+    static indiepub::Task<void> signIn(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static indiepub::Task<void> signUp(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static indiepub::Task<void> fetchEvents(const indiepub::RequestContext &context, HttpResponse &response);
+
+    // The JSON body of GET /events for "week" or "all".
+    static indiepub::Task<std::string> renderFeed(std::string window);
+
+    static indiepub::Task<void> fetchEvent(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static indiepub::Task<void> fetchVenue(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static indiepub::Task<void> fetchVenueEvents(const indiepub::RequestContext &context, HttpResponse &response);
+
+    // An event as listed in the events feed, located at `venue`.
+    static std::string eventJson(const indiepub::EventByVenue &event, const indiepub::Venue &venue);
 
 public:
     Endpoints(/* args */);
 
+    // Reloads entries restored from a cache snapshot so stale ones do not outlive the warm start.
+    static void revalidateCaches(const indiepub::Caches::Restored &restored);
+
     ~Endpoints();
 
-    static void signInHandler(const HttpRequest &request, HttpResponse &response, Path *path);
+    static void signInHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response);
 
     static std::string tokenGenerator(std::string &pwHash);
 
-    static void signUpHandler(const HttpRequest &request, HttpResponse &response, Path *path);
+    static void signUpHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response);
 
     static std::string hashing(std::string &value);
 
-    static void validateHeaders(const HttpRequest &request, HttpResponse &response, Path *path);
+    // Middleware: authenticates a request once for the whole chain. A route that requires it is
+    // answered 401 when that fails; on other routes a token is optional and a bad one is ignored.
+    // Waits for authenticateAsync on the HTTP worker, which only blocks on a cache miss.
+    static bool authenticate(indiepub::RequestContext &context, HttpResponse &response);
+
+    // The token authorizeAdmin expects; empty closes the ADMIN routes. RESTfulAPI calls it at
+    // startup with INDIEBACK_ADMIN_TOKEN, and it throws std::invalid_argument for a token shorter
+    // than ADMIN_TOKEN_MIN_LENGTH.
+    static void configureAdmin(const std::string &token);
+
+    // Middleware: ADMIN routes answer 401 unless the bearer token is the configured admin token,
+    // and are closed while there is none. Runs before admission so anonymous calls take no admin
+    // slot.
+    static bool authorizeAdmin(indiepub::RequestContext &context, HttpResponse &response);
+
+    static void validateHeaders(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static void fetchEventsHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response);
+
+    static void fetchEventHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response);
 
-    static void fetchEventsHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    static void fetchVenueHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response);
 
-    static void createEventHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    static void fetchVenueEventsHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response);
 
-    static void fetchPostsHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    static void createEventHandler(const indiepub::RequestContext &context, HttpResponse &response);
 
-    static void createPostHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    static void fetchPostsHandler(const indiepub::RequestContext &context, HttpResponse &response);
 
-    static void fetchUserInfoHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    static void createPostHandler(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static void fetchUserInfoHandler(const indiepub::RequestContext &context, HttpResponse &response);
     
-    static void updateUserInfoHandler(const HttpRequest &request, HttpResponse &response, Path *path);
+    static void updateUserInfoHandler(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static void addVenueProfileHandler(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static void fetchVenueProfileHandler(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static void addBandProfileHandler(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static void fetchBandProfileHandler(const indiepub::RequestContext &context, HttpResponse &response);
+
+    static void metricsHandler(const indiepub::RequestContext &context, HttpResponse &response);
 
-    static void addVenueProfileHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    // The Prometheus exposition /metrics answers with.
+    static std::string metrics();
 
-    static void fetchVenueProfileHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    static void logoutHandler(const indiepub::RequestContext &context, HttpResponse &response);
 
-    static void addBandProfileHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    static void sessionKeyHandler(const indiepub::RequestContext &context, HttpResponse &response);
 
-    static void fetchBandProfileHandler(const HttpRequest &request, HttpResponse &response, Path* path);
+    // Public backend keys by id, current first, so clients can follow a rotation.
+    static void keysHandler(const indiepub::RequestContext &context, HttpResponse &response);
 };
 
 #endif // INDIEPUB_ENDPOINTS_HPP
\ No newline at end of file
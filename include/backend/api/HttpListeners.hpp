@@ -0,0 +1,113 @@
+#ifndef INDIEPUB_HTTP_LISTENERS_HPP
+#define INDIEPUB_HTTP_LISTENERS_HPP
+
+#include <backend/api/AsyncResponse.hpp>
+#include <backend/api/Router.hpp>
+#include <http/Server.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace indiepub
+{
+    // One or more HttpServer instances on the same address, each with its own accept loop and
+    // worker threads.
+    //
+    // Several listeners would need HttpServer to open its socket with SO_REUSEPORT, which it does
+    // not, so for now a single listener is run whatever is asked for. With CPU pinning each
+    // listener runs on its own share of the CPUs, and the HttpServer workers it starts inherit
+    // that affinity; Linux only.
+    class HttpListeners
+    {
+    public:
+        using Handler = Router::Handler;
+
+        // Returns once the work is started and finishes through the AsyncResponse from whatever
+        // thread completes it. The context is only valid until the handler returns, so later
+        // stages must capture copies of what they need.
+        using AsyncHandler = std::function<void(const RequestContext &, AsyncResponse)>;
+
+        struct Options
+        {
+            std::string host;
+            std::string port;
+            int backlog;
+            int workers;        // per listener
+            int listeners;      // 0 for one per available CPU; more than one needs port reuse
+            bool pin_cpus;
+            std::chrono::milliseconds async_timeout;    // 504 after this long
+
+            // config.h defaults, overridden by INDIEBACK_HTTP_* environment variables
+            static Options fromEnvironment();
+        };
+
+        explicit HttpListeners(const Options &options);
+
+        HttpListeners(const HttpListeners &) = delete;
+        HttpListeners &operator=(const HttpListeners &) = delete;
+
+        // Added to the router shared by every listener; `pattern` may capture `{name}` segments.
+        void setHttpHandler(HttpMethod method, const std::string &pattern, Handler handler, RouteMeta meta = RouteMeta());
+
+        // Runs for every route before its handler; see Router::Middleware.
+        void use(Router::Middleware middleware);
+
+        // Runs for every route after its handler; see Router::Filter.
+        void after(Router::Filter filter);
+
+        // HttpServer writes the response when its handler returns, so the worker waits on the
+        // AsyncResponse; the database and crypto work of the request run, and overlap, off the
+        // worker. A handler that throws before completing answers 500. One that is still running
+        // after async_timeout is answered 504, and what was deferred on the context, its
+        // admission slot among it, is released only when it completes.
+        void setAsyncHandler(HttpMethod method, const std::string &pattern, AsyncHandler handler, RouteMeta meta = RouteMeta());
+
+        // Starts the listeners and blocks until all of them return or the server has drained.
+        void run();
+
+        // Runs the route matched by HttpServer, or answers 503 with Connection: close once the
+        // server is draining.
+        void handle(HttpMethod method, const HttpRequest &request, HttpResponse &response);
+
+        // Refuses new requests and waits up to `timeout` for those being handled to be answered;
+        // true when they all were. run() returns afterwards. HttpServer has no way to close its
+        // listening socket, so that is left to the process exit.
+        bool drain(std::chrono::milliseconds timeout);
+
+        bool draining() const;
+
+        // Requests being handled by a worker.
+        size_t inFlight() const;
+
+        const Options &options() const;
+
+        const Router &router() const;
+
+        // CPUs of the process affinity mask, in order.
+        static std::vector<int> availableCpus();
+
+        // The CPUs listener `index` of `count` is pinned to: every count-th available CPU.
+        static std::vector<int> cpusFor(int index, int count, const std::vector<int> &cpus);
+
+    private:
+        void listen(int index);
+
+        void finished();
+
+        Options options_;
+        Router router_;
+
+        mutable std::mutex mutex_;
+        mutable std::condition_variable changed_;
+        int running_ = 0;
+        bool stopped_ = false;
+        std::atomic<bool> draining_{false};
+        std::atomic<size_t> in_flight_{0};
+    };
+}
+
+#endif // INDIEPUB_HTTP_LISTENERS_HPP
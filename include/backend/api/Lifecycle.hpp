@@ -0,0 +1,73 @@
+#ifndef INDIEPUB_LIFECYCLE_HPP
+#define INDIEPUB_LIFECYCLE_HPP
+
+#include <backend/api/HttpListeners.hpp>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace indiepub
+{
+    // Shutdown and restart of the server process.
+    //
+    // SIGTERM or SIGINT drain the listeners: the requests being served get until the drain
+    // deadline to finish before run() returns. SIGUSR2 starts a new copy of the program that
+    // inherits one end of a socket pair, so no other process can pose as it. The successor loads
+    // its keys and warm starts while this process still serves; once it reports ready, this
+    // process drains and exits, and the successor listens as soon as the pair closes with it.
+    // HttpServer can neither share nor hand over its listening socket, so connections arriving
+    // between the two are refused. If the successor does not report ready, this process
+    // carries on.
+    class Lifecycle
+    {
+    public:
+        struct Options
+        {
+            std::chrono::milliseconds drain_timeout;
+            std::chrono::milliseconds handoff_timeout;  // for the successor to report ready
+
+            // config.h defaults, overridden by INDIEBACK_DRAIN_TIMEOUT / INDIEBACK_HANDOFF_*
+            static Options fromEnvironment();
+        };
+
+        // Set in the environment of a successor to its descriptor of the socket pair.
+        static constexpr const char *HANDOFF_VARIABLE = "INDIEBACK_HANDOFF_FD";
+
+        Lifecycle(HttpListeners &listeners, const Options &options);
+
+        ~Lifecycle();
+
+        Lifecycle(const Lifecycle &) = delete;
+        Lifecycle &operator=(const Lifecycle &) = delete;
+
+        // In a process started by SIGUSR2, takes the socket pair to its predecessor. False when
+        // there is no predecessor.
+        bool adopt();
+
+        // Tells the predecessor this process is ready and waits until it has exited; call right
+        // before the listeners run. True at once without a predecessor, false when it is still
+        // there after its drain and handoff timeouts.
+        bool takeOver();
+
+        // Installs the signal handlers and acts on them from a thread of its own. `checkpoint`
+        // runs before a successor is started, so it can warm start from what was saved.
+        void start(std::function<void()> checkpoint);
+
+        // Starts a new process; true once it is ready to take over, after which this process
+        // must drain and exit.
+        bool restart();
+
+    private:
+        void run();
+
+        HttpListeners &listeners_;
+        Options options_;
+        std::function<void()> checkpoint_;
+        int predecessor_ = -1;      // inherited end of the pair; closes when the predecessor exits
+        int successor_ = -1;        // left open: the successor listens once this process has exited
+        int signals_[2] = {-1, -1};
+        std::thread worker_;
+    };
+}
+
+#endif // INDIEPUB_LIFECYCLE_HPP
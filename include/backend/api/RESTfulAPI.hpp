@@ -1,7 +1,11 @@
 #ifndef INDIEPUB_SERVER_HPP
 #define INDIEPUB_SERVER_HPP
 
-#include <http/Server.hpp>
+#include <backend/api/HttpListeners.hpp>
+#include <backend/api/Lifecycle.hpp>
+#include <backend/auth/KeyRotation.hpp>
+#include <backend/cache/InvalidationChannel.hpp>
+#include <backend/cache/CacheSnapshotter.hpp>
 #include <csignal>
 #include <memory>
 #include <cstdlib>
@@ -11,7 +15,11 @@
 class RESTfulAPI 
 {
 private:
-    std::unique_ptr<HttpServer> apiServer;
+    std::unique_ptr<indiepub::HttpListeners> apiServer;
+    std::unique_ptr<indiepub::InvalidationChannel> invalidationChannel;
+    std::unique_ptr<indiepub::CacheSnapshotter> cacheSnapshotter;
+    std::unique_ptr<indiepub::KeyRotation> keyRotation;
+    std::unique_ptr<indiepub::Lifecycle> lifecycle;
 
     RESTfulAPI();
 
@@ -0,0 +1,112 @@
+#ifndef INDIEPUB_RATE_LIMITER_HPP
+#define INDIEPUB_RATE_LIMITER_HPP
+
+#include <backend/api/RequestContext.hpp>
+#include <http/Response.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace indiepub
+{
+    // Token buckets per route and client address, and per route and signed-in user.
+    //
+    // Client addresses come from proxy headers, and only with trusted_proxy set; HttpServer does
+    // not hand out the peer address. A request without one is not limited per client at all, as
+    // a bucket shared by every client would let any one of them lock the others out.
+    //
+    // A route with a rate_limit of n gets buckets of n tokens refilled at n per minute. The
+    // buckets are spread over independently locked stripes. Each stripe files its buckets on a
+    // timing wheel of one-second slots and drops a bucket once it has been idle long enough to
+    // be full again, so memory follows the clients seen in the last minute or so. The wheels are
+    // turned by the requests themselves, each also turning one other stripe so quiet stripes
+    // age too; no thread is involved.
+    class RateLimiter
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Options
+        {
+            size_t stripes;
+            size_t wheel_slots;     // seconds the wheel covers before it wraps
+            bool trusted_proxy;     // X-Forwarded-For / X-Real-IP are set by a proxy we run
+
+            static Options defaults();
+
+            // defaults(), overridden by INDIEBACK_RATE_LIMIT_* environment variables
+            static Options fromEnvironment();
+        };
+
+        explicit RateLimiter(const Options &options);
+
+        RateLimiter(const RateLimiter &) = delete;
+        RateLimiter &operator=(const RateLimiter &) = delete;
+
+        // Sets the options instance() is built with; RESTfulAPI calls it at startup with the
+        // options it parsed, and it throws std::logic_error once instance() has been used.
+        static void configure(const Options &options);
+
+        // Built on first use from the configured options, or from the config.h defaults.
+        static RateLimiter &instance();
+
+        // Takes a token from the bucket of `key`; zero when there was one, otherwise how long
+        // until there will be.
+        std::chrono::milliseconds take(const std::string &key, int perMinute, Clock::time_point now = Clock::now());
+
+        // Middleware for the route's limit per client address, passing requests whose address is
+        // unknown; runs before authentication and before the handler reads the body.
+        bool limitClient(RequestContext &context, HttpResponse &response);
+
+        // Middleware for the route's limit per signed-in user; runs after authentication.
+        bool limitUser(RequestContext &context, HttpResponse &response);
+
+        // The last X-Forwarded-For entry, the one the proxy in front of the server added, or
+        // X-Real-IP; empty when the request came without either or the proxy is not trusted.
+        std::string_view clientAddress(const RequestContext &context) const;
+
+        // Buckets currently held.
+        size_t size() const;
+
+        // Prometheus text exposition of held buckets and limited requests.
+        std::string exposition() const;
+
+    private:
+        struct Bucket
+        {
+            double tokens;
+            Clock::time_point updated;
+            std::uint64_t expires;      // tick at which the bucket is full again
+        };
+
+        struct Stripe
+        {
+            mutable std::mutex mutex;
+            std::unordered_map<std::string, Bucket> buckets;
+            std::vector<std::vector<std::string>> wheel;
+            std::uint64_t tick = 0;
+        };
+
+        std::uint64_t tickOf(Clock::time_point now) const;
+
+        // With the stripe locked: expires buckets of the slots passed since the last turn.
+        void turn(Stripe &stripe, std::uint64_t now);
+
+        bool reject(std::chrono::milliseconds wait, HttpResponse &response) const;
+
+        Options options_;
+        Clock::time_point start_;
+        std::vector<Stripe> stripes_;
+
+        std::atomic<size_t> sweep_{0};
+        std::atomic<std::uint64_t> limited_client_{0};
+        std::atomic<std::uint64_t> limited_user_{0};
+        std::atomic<bool> warned_{false};
+    };
+}
+
+#endif // INDIEPUB_RATE_LIMITER_HPP
@@ -0,0 +1,111 @@
+#ifndef INDIEPUB_REQUEST_CONTEXT_HPP
+#define INDIEPUB_REQUEST_CONTEXT_HPP
+
+#include <backend/models/Credentials.hpp>
+#include <backend/models/User.hpp>
+#include <http/Request.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace indiepub
+{
+    class RouteParams;
+    struct RouteMeta;
+
+    enum class ContentEncoding
+    {
+        IDENTITY,
+        GZIP,
+        DEFLATE
+    };
+
+    // Everything the middleware chain learns about a request, handed on to its handler.
+    //
+    // The headers are read from the request once; header values, the bearer token and the
+    // claimed user id are trimmed views into that copy. Authentication fills in the credentials
+    // and user so a handler never repeats the lookups.
+    class RequestContext
+    {
+    public:
+        using Headers = std::remove_cvref_t<decltype(std::declval<const HttpRequest &>().getHeaders())>;
+
+        RequestContext(const HttpRequest &request, const RouteParams &params, const RouteMeta &meta);
+
+        // The same context over copies of the request and params that outlive the HTTP worker.
+        RequestContext(const RequestContext &other, const HttpRequest &request, const RouteParams &params);
+
+        // Runs what was deferred, last first.
+        ~RequestContext();
+
+        RequestContext(const RequestContext &) = delete;
+        RequestContext &operator=(const RequestContext &) = delete;
+
+        const HttpRequest &request() const;
+
+        const RouteParams &params() const;
+
+        const RouteMeta &meta() const;
+
+        // Without surrounding whitespace; empty when the header is missing.
+        std::string_view header(const std::string &name) const;
+
+        bool hasHeader(const std::string &name) const;
+
+        // The Authorization value after "Bearer "; empty for any other scheme.
+        std::string_view bearerToken() const;
+
+        std::string_view userId() const;
+
+        bool authenticated() const;
+
+        const Credentials &credentials() const;
+
+        const User &user() const;
+
+        void authenticate(Credentials credentials, User user);
+
+        // Set by a handler whose body is already encoded, such as one served precompressed from a
+        // cache, so the response filters only label it. Shared with rebound contexts.
+        void setContentEncoding(ContentEncoding encoding) const;
+
+        ContentEncoding contentEncoding() const;
+
+        // Runs `done` once the request is over, after the response filters, however the chain
+        // ended. Not carried over to rebound contexts.
+        void defer(std::function<void()> done);
+
+        // Takes what was deferred away from this context, for a request that is still running
+        // when the context goes; the result runs it, last first. Const like
+        // setContentEncoding, since handlers only see a const context.
+        std::function<void()> detachDeferred() const;
+
+    private:
+        struct Shared
+        {
+            explicit Shared(Headers headers) : headers(std::move(headers)) {}
+
+            const Headers headers;
+            std::atomic<ContentEncoding> encoding{ContentEncoding::IDENTITY};
+        };
+
+        const HttpRequest *request_;
+        const RouteParams *params_;
+        const RouteMeta *meta_;
+        // shared with contexts rebound to a copy of the request, so the views stay valid
+        std::shared_ptr<Shared> shared_;
+        std::string_view token_;
+        std::string_view user_id_;
+        bool authenticated_ = false;
+        Credentials credentials_;
+        User user_;
+        mutable std::vector<std::function<void()>> deferred_;
+    };
+}
+
+#endif // INDIEPUB_REQUEST_CONTEXT_HPP
@@ -0,0 +1,134 @@
+#ifndef INDIEPUB_ROUTER_HPP
+#define INDIEPUB_ROUTER_HPP
+
+#include <backend/api/RequestContext.hpp>
+#include <http/Method.hpp>
+#include <http/Request.hpp>
+#include <http/Response.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace indiepub
+{
+    // What a request costs the server, for rate limits and admission.
+    enum class RouteClass
+    {
+        AUTH,       // password hashing and RSA work
+        READ,
+        WRITE,
+        ADMIN
+    };
+
+    struct RouteMeta
+    {
+        bool auth_required = false;     // 401 before the handler unless the request authenticates
+        RouteClass route_class = RouteClass::READ;
+        int cache_seconds = 0;          // Cache-Control max-age; 0 answers no-store
+        int rate_limit = 0;             // requests per minute per client and per user; 0 for none
+    };
+
+    // Values captured by the `{name}` segments of a route, in pattern order.
+    class RouteParams
+    {
+    public:
+        void add(std::string_view name, std::string value);
+
+        // Empty when the route has no such parameter.
+        const std::string &get(std::string_view name) const;
+
+        bool has(std::string_view name) const;
+
+        size_t size() const;
+
+    private:
+        // the names point into the router that matched
+        std::vector<std::pair<std::string_view, std::string>> values_;
+    };
+
+    // Maps a method and path to a handler with one walk of a trie of path segments.
+    //
+    // Patterns are made of literal segments and `{name}` captures, e.g. `/venues/{venue_id}/events`.
+    // At each position a literal segment is tried before a capture. Routes are added while the
+    // server is set up; matching afterwards takes no lock.
+    class Router
+    {
+    public:
+        using Handler = std::function<void(const RequestContext &, HttpResponse &)>;
+
+        // Runs before the handler, in the order added; returns false once it has answered the
+        // request, which ends the chain.
+        using Middleware = std::function<bool(RequestContext &, HttpResponse &)>;
+
+        // Runs after the handler, in the order added, to rework the response it wrote.
+        using Filter = std::function<void(const RequestContext &, HttpResponse &)>;
+
+        struct Route
+        {
+            HttpMethod method;
+            std::string pattern;
+            RouteMeta meta;
+            Handler handler;
+        };
+
+        struct Match
+        {
+            const Route *route = nullptr;
+            RouteParams params;
+
+            explicit operator bool() const
+            {
+                return route != nullptr;
+            }
+        };
+
+        Router();
+
+        ~Router();
+
+        Router(const Router &) = delete;
+        Router &operator=(const Router &) = delete;
+
+        // Throws std::invalid_argument for a malformed pattern or one already routed for `method`.
+        const Route &add(HttpMethod method, const std::string &pattern, RouteMeta meta, Handler handler);
+
+        void use(Middleware middleware);
+
+        void after(Filter filter);
+
+        // The query string and a trailing slash are ignored.
+        Match match(HttpMethod method, std::string_view path) const;
+
+        // Methods some route accepts for `path`, in the order they were added; empty when no
+        // route matches it at all.
+        std::vector<HttpMethod> allowed(std::string_view path) const;
+
+        // Runs the middleware chain, the handler of the matching route and the filters. Answers
+        // 405 with Allow when only other methods are routed for the path, and 404 when none is.
+        // A 2xx answer of the handler gets Cache-Control from the route metadata, any other
+        // no-store.
+        void dispatch(HttpMethod method, const HttpRequest &request, HttpResponse &response) const;
+
+        // In the order they were added.
+        const std::vector<std::unique_ptr<Route>> &routes() const;
+
+    private:
+        struct Node;
+
+        using Captures = std::vector<std::pair<std::string_view, std::string_view>>;
+
+        const Route *find(const Node &node, const std::vector<std::string_view> &segments, size_t depth, HttpMethod method, Captures &captures) const;
+
+        void collect(const Node &node, const std::vector<std::string_view> &segments, size_t depth, std::vector<const Route *> &found) const;
+
+        std::unique_ptr<Node> root_;
+        std::vector<std::unique_ptr<Route>> routes_;
+        std::vector<Middleware> middlewares_;
+        std::vector<Filter> filters_;
+    };
+}
+
+#endif // INDIEPUB_ROUTER_HPP
@@ -0,0 +1,334 @@
+#ifndef INDIEPUB_ASYNC_HPP
+#define INDIEPUB_ASYNC_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace indiepub
+{
+    template <typename T>
+    class Promise;
+
+    template <typename T>
+    class Async;
+
+    namespace detail
+    {
+        template <typename T, typename F>
+        struct ThenResult
+        {
+            using type = std::invoke_result_t<F, const T &>;
+        };
+
+        template <typename F>
+        struct ThenResult<void, F>
+        {
+            using type = std::invoke_result_t<F>;
+        };
+    }
+
+    // A value produced on another thread: a Cassandra driver callback, the CryptoExecutor.
+    //
+    // Callbacks run on the thread that completes the value, or immediately when it is already
+    // complete, so they should be short or hand the rest of the work to an executor. Copies
+    // share one state.
+    template <typename T>
+    class Async
+    {
+    public:
+        using Callback = std::function<void(const Async<T> &)>;
+
+        template <typename U = T>
+            requires(!std::is_void_v<U>)
+        static Async<T> value(U value)
+        {
+            Promise<T> promise;
+            promise.set(std::move(value));
+            return promise.async();
+        }
+
+        static Async<T> value()
+            requires std::is_void_v<T>
+        {
+            Promise<T> promise;
+            promise.set();
+            return promise.async();
+        }
+
+        static Async<T> failure(std::exception_ptr error)
+        {
+            Promise<T> promise;
+            promise.fail(error);
+            return promise.async();
+        }
+
+        bool ready() const
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            return state_->done;
+        }
+
+        bool failed() const
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            return state_->done && state_->error != nullptr;
+        }
+
+        // nullptr unless failed.
+        std::exception_ptr error() const
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            return state_->error;
+        }
+
+        // Blocks until complete and rethrows a failure. The value lives as long as any copy.
+        decltype(auto) get() const
+        {
+            std::unique_lock<std::mutex> lock(state_->mutex);
+            state_->ready.wait(lock, [this]() { return state_->done; });
+            if (state_->error != nullptr)
+                std::rethrow_exception(state_->error);
+            if constexpr (std::is_void_v<T>)
+                return;
+            else
+                return static_cast<const T &>(*state_->value);
+        }
+
+        template <typename Rep, typename Period>
+        bool waitFor(std::chrono::duration<Rep, Period> timeout) const
+        {
+            std::unique_lock<std::mutex> lock(state_->mutex);
+            return state_->ready.wait_for(lock, timeout, [this]() { return state_->done; });
+        }
+
+        void onComplete(Callback callback) const
+        {
+            {
+                std::lock_guard<std::mutex> lock(state_->mutex);
+                if (!state_->done)
+                {
+                    state_->callbacks.push_back(std::move(callback));
+                    return;
+                }
+            }
+            callback(*this);
+        }
+
+        // Async of `f(value)`; a failure, or an exception thrown by `f`, is passed along.
+        template <typename F>
+        auto then(F f) const -> Async<typename detail::ThenResult<T, F>::type>
+        {
+            using U = typename detail::ThenResult<T, F>::type;
+            Promise<U> next;
+            onComplete([next, f = std::move(f)](const Async<T> &done) mutable {
+                try
+                {
+                    if constexpr (std::is_void_v<T> && std::is_void_v<U>)
+                    {
+                        done.get();
+                        f();
+                        next.set();
+                    }
+                    else if constexpr (std::is_void_v<T>)
+                    {
+                        done.get();
+                        next.set(f());
+                    }
+                    else if constexpr (std::is_void_v<U>)
+                    {
+                        f(done.get());
+                        next.set();
+                    }
+                    else
+                    {
+                        next.set(f(done.get()));
+                    }
+                }
+                catch (...)
+                {
+                    next.fail(std::current_exception());
+                }
+            });
+            return next.async();
+        }
+
+    private:
+        friend class Promise<T>;
+
+        using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        struct State
+        {
+            std::mutex mutex;
+            std::condition_variable ready;
+            bool done = false;
+            std::optional<Stored> value;
+            std::exception_ptr error;
+            std::vector<Callback> callbacks;
+        };
+
+        explicit Async(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+        std::shared_ptr<State> state_;
+    };
+
+    // Completes an Async exactly once; later set() / fail() calls return false.
+    template <typename T>
+    class Promise
+    {
+    public:
+        Promise() : state_(std::make_shared<typename Async<T>::State>()) {}
+
+        Async<T> async() const
+        {
+            return Async<T>(state_);
+        }
+
+        template <typename U = T>
+            requires(!std::is_void_v<U>)
+        bool set(U value)
+        {
+            return complete([&value](typename Async<T>::State &state) { state.value.emplace(std::move(value)); });
+        }
+
+        bool set()
+            requires std::is_void_v<T>
+        {
+            return complete([](typename Async<T>::State &state) { state.value.emplace(); });
+        }
+
+        bool fail(std::exception_ptr error)
+        {
+            return complete([&error](typename Async<T>::State &state) { state.error = error; });
+        }
+
+    private:
+        template <typename Store>
+        bool complete(Store store)
+        {
+            std::vector<typename Async<T>::Callback> callbacks;
+            {
+                std::lock_guard<std::mutex> lock(state_->mutex);
+                if (state_->done)
+                    return false;
+                store(*state_);
+                state_->done = true;
+                callbacks.swap(state_->callbacks);
+            }
+            state_->ready.notify_all();
+            Async<T> done(state_);
+            for (auto &callback : callbacks)
+                callback(done);
+            return true;
+        }
+
+        std::shared_ptr<typename Async<T>::State> state_;
+    };
+
+    namespace detail
+    {
+        template <typename... T>
+        struct TupleJoin
+        {
+            std::mutex mutex;
+            std::tuple<std::optional<T>...> values;
+            size_t pending = sizeof...(T);
+            Promise<std::tuple<T...>> promise;
+        };
+
+        template <size_t I, typename... T>
+        void joinPart(const std::shared_ptr<TupleJoin<T...>> &join, const Async<std::tuple_element_t<I, std::tuple<T...>>> &part)
+        {
+            part.onComplete([join](const auto &done) {
+                if (done.failed())
+                {
+                    join->promise.fail(done.error());
+                    return;
+                }
+                bool last;
+                {
+                    std::lock_guard<std::mutex> lock(join->mutex);
+                    std::get<I>(join->values).emplace(done.get());
+                    last = --join->pending == 0;
+                }
+                if (last)
+                {
+                    join->promise.set(std::apply([](auto &...values) { return std::tuple<T...>(std::move(*values)...); },
+                                                 join->values));
+                }
+            });
+        }
+
+        template <typename... T, size_t... I>
+        Async<std::tuple<T...>> joinAll(std::index_sequence<I...>, const Async<T> &...parts)
+        {
+            auto join = std::make_shared<TupleJoin<T...>>();
+            (joinPart<I>(join, parts), ...);
+            return join->promise.async();
+        }
+    }
+
+    // Completes once every part has, with their values in order, or fails with the first failure
+    // to arrive. The parts are already running, so the wait is the slowest of them, not the sum.
+    template <typename... T>
+    Async<std::tuple<T...>> whenAll(const Async<T> &...parts)
+    {
+        return detail::joinAll(std::index_sequence_for<T...>{}, parts...);
+    }
+
+    template <typename T>
+    Async<std::vector<T>> whenAll(const std::vector<Async<T>> &parts)
+    {
+        struct Join
+        {
+            std::mutex mutex;
+            std::vector<std::optional<T>> values;
+            size_t pending;
+            Promise<std::vector<T>> promise;
+        };
+        if (parts.empty())
+            return Async<std::vector<T>>::value(std::vector<T>());
+        auto join = std::make_shared<Join>();
+        join->values.resize(parts.size());
+        join->pending = parts.size();
+        for (size_t i = 0; i < parts.size(); ++i)
+        {
+            parts[i].onComplete([join, i](const Async<T> &done) {
+                if (done.failed())
+                {
+                    join->promise.fail(done.error());
+                    return;
+                }
+                bool last;
+                {
+                    std::lock_guard<std::mutex> lock(join->mutex);
+                    join->values[i].emplace(done.get());
+                    last = --join->pending == 0;
+                }
+                if (last)
+                {
+                    std::vector<T> values;
+                    values.reserve(join->values.size());
+                    for (auto &value : join->values)
+                        values.push_back(std::move(*value));
+                    join->promise.set(std::move(values));
+                }
+            });
+        }
+        return join->promise.async();
+    }
+}
+
+#endif // INDIEPUB_ASYNC_HPP
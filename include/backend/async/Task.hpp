@@ -0,0 +1,264 @@
+#ifndef INDIEPUB_TASK_HPP
+#define INDIEPUB_TASK_HPP
+
+#include <backend/async/Async.hpp>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace indiepub
+{
+    template <typename T = void>
+    class Task;
+
+    namespace detail
+    {
+        template <typename T>
+        struct TaskPromiseBase
+        {
+            // Hands control back to the awaiting coroutine when the body finishes.
+            struct Final
+            {
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                template <typename P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+                {
+                    std::coroutine_handle<> continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            Final final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception()
+            {
+                error = std::current_exception();
+            }
+
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+        };
+
+        template <typename T>
+        struct TaskPromise : TaskPromiseBase<T>
+        {
+            Task<T> get_return_object();
+
+            void return_value(T result)
+            {
+                value.emplace(std::move(result));
+            }
+
+            T result()
+            {
+                if (this->error != nullptr)
+                    std::rethrow_exception(this->error);
+                return std::move(*value);
+            }
+
+            std::optional<T> value;
+        };
+
+        template <>
+        struct TaskPromise<void> : TaskPromiseBase<void>
+        {
+            Task<void> get_return_object();
+
+            void return_void() {}
+
+            void result()
+            {
+                if (error != nullptr)
+                    std::rethrow_exception(error);
+            }
+        };
+    }
+
+    // Coroutine type for request handlers and multi-step queries.
+    //
+    // A Task starts when it is awaited, or when start() runs it; it then continues on whichever
+    // thread completes the Async it is waiting for: a Cassandra I/O thread after a query, a pool
+    // thread after crypto work. Work that would block belongs behind another co_await.
+    template <typename T>
+    class [[nodiscard]] Task
+    {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+        Task &operator=(Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle_)
+                    handle_.destroy();
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+            return *this;
+        }
+
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        ~Task()
+        {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        auto operator co_await() && noexcept
+        {
+            struct Awaiter
+            {
+                std::coroutine_handle<promise_type> handle;
+
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+                {
+                    handle.promise().continuation = caller;
+                    return handle;
+                }
+
+                T await_resume()
+                {
+                    return handle.promise().result();
+                }
+            };
+            return Awaiter{handle_};
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object()
+        {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object()
+        {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+
+        // Eager coroutine that owns itself and frees its frame when it finishes.
+        struct Detached
+        {
+            struct promise_type
+            {
+                Detached get_return_object() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never initial_suspend() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never final_suspend() noexcept
+                {
+                    return {};
+                }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept
+                {
+                    std::terminate();
+                }
+            };
+        };
+
+        template <typename T>
+        Detached drive(Task<T> task, Promise<T> promise)
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    co_await std::move(task);
+                    promise.set();
+                }
+                else
+                {
+                    promise.set(co_await std::move(task));
+                }
+            }
+            catch (...)
+            {
+                promise.fail(std::current_exception());
+            }
+        }
+    }
+
+    // Runs `task` without an awaiting coroutine; the calling thread returns at its first
+    // suspension and the result arrives through the Async.
+    template <typename T>
+    Async<T> start(Task<T> task)
+    {
+        Promise<T> promise;
+        Async<T> result = promise.async();
+        detail::drive(std::move(task), promise);
+        return result;
+    }
+
+    // `co_await async` suspends until the value is complete and resumes on the completing thread.
+    template <typename T>
+    auto operator co_await(Async<T> async)
+    {
+        struct Awaiter
+        {
+            Async<T> async;
+
+            bool await_ready() const
+            {
+                return async.ready();
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const
+            {
+                // a local copy: the callback may resume, finish and free the frame holding *this
+                Async<T> pending = async;
+                pending.onComplete([handle](const Async<T> &) { handle.resume(); });
+            }
+
+            T await_resume() const
+            {
+                if constexpr (std::is_void_v<T>)
+                    async.get();
+                else
+                    return async.get();
+            }
+        };
+        return Awaiter{std::move(async)};
+    }
+}
+
+#endif // INDIEPUB_TASK_HPP
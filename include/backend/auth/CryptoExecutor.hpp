@@ -0,0 +1,151 @@
+#ifndef INDIEPUB_CRYPTO_EXECUTOR_HPP
+#define INDIEPUB_CRYPTO_EXECUTOR_HPP
+
+#include <backend/async/Async.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace indiepub
+{
+    // Thrown when the crypto queue has no room; handlers answer 503.
+    class CryptoOverloaded : public std::runtime_error
+    {
+    public:
+        CryptoOverloaded() : std::runtime_error("crypto queue is full") {}
+    };
+
+    // Fixed pool of threads for RSA and hashing work, kept apart from the HTTP workers.
+    //
+    // The queue is bounded: a burst of logins is turned away with 503 instead of piling up
+    // behind the workers that serve cheap reads. Jobs of one request are admitted all or none.
+    class CryptoExecutor
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Upper bounds of the job latency histogram, in seconds.
+        static constexpr std::array<double, 9> LATENCY_BUCKETS = {0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0};
+
+        // Sized from INDIEBACK_CRYPTO_THREADS / INDIEBACK_CRYPTO_QUEUE or CRYPTO_THREADS / CRYPTO_QUEUE_SIZE.
+        static CryptoExecutor &instance();
+
+        CryptoExecutor(size_t threads, size_t capacity);
+
+        ~CryptoExecutor();
+
+        CryptoExecutor(const CryptoExecutor &) = delete;
+        CryptoExecutor &operator=(const CryptoExecutor &) = delete;
+
+        // Queues `jobs` together; throws CryptoOverloaded when they do not all fit.
+        // Called from a pool thread, the jobs run inline so a job can never wait on the queue.
+        template <typename F>
+        std::vector<std::future<std::invoke_result_t<F>>> submitAll(std::vector<F> jobs)
+        {
+            using R = std::invoke_result_t<F>;
+            std::vector<std::future<R>> futures;
+            std::vector<Job> queued;
+            futures.reserve(jobs.size());
+            queued.reserve(jobs.size());
+            for (auto &job : jobs)
+            {
+                auto task = std::make_shared<std::packaged_task<R()>>(std::move(job));
+                futures.push_back(task->get_future());
+                queued.push_back({[task]() { (*task)(); }, Clock::now()});
+            }
+            if (inWorker())
+            {
+                for (auto &job : queued)
+                    job.run();
+                return futures;
+            }
+            enqueue(queued);
+            return futures;
+        }
+
+        // Runs `job` on the pool and waits for its result.
+        template <typename F>
+        std::invoke_result_t<F> run(F job)
+        {
+            std::vector<F> jobs;
+            jobs.push_back(std::move(job));
+            return submitAll(std::move(jobs)).front().get();
+        }
+
+        // Queues `job` without waiting for it; the result is completed on the pool thread.
+        // Throws CryptoOverloaded when the queue is full.
+        template <typename F>
+        Async<std::invoke_result_t<F>> submit(F job)
+        {
+            using R = std::invoke_result_t<F>;
+            Promise<R> promise;
+            std::vector<Job> queued;
+            queued.push_back({[promise, job = std::move(job)]() mutable {
+                                  try
+                                  {
+                                      promise.set(job());
+                                  }
+                                  catch (...)
+                                  {
+                                      promise.fail(std::current_exception());
+                                  }
+                              },
+                              Clock::now()});
+            if (inWorker())
+                queued.front().run();
+            else
+                enqueue(queued);
+            return promise.async();
+        }
+
+        size_t depth() const;
+
+        size_t capacity() const;
+
+        // Prometheus text exposition of queue depth, rejections and job latency.
+        std::string exposition() const;
+
+    private:
+        struct Job
+        {
+            std::function<void()> run;
+            Clock::time_point queued;
+        };
+
+        static bool inWorker();
+
+        void enqueue(std::vector<Job> &jobs);
+
+        void work();
+
+        void record(Clock::duration wait, Clock::duration total);
+
+        size_t capacity_;
+        std::vector<std::thread> workers_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable ready_;
+        std::deque<Job> queue_;
+        bool stopping_ = false;
+
+        std::atomic<std::uint64_t> completed_{0};
+        std::atomic<std::uint64_t> rejected_{0};
+        std::atomic<std::uint64_t> wait_us_{0};
+        std::atomic<std::uint64_t> latency_us_{0};
+        std::array<std::atomic<std::uint64_t>, LATENCY_BUCKETS.size()> buckets_{};
+    };
+}
+
+#endif // INDIEPUB_CRYPTO_EXECUTOR_HPP
@@ -0,0 +1,56 @@
+#ifndef INDIEPUB_KEY_ROTATION_HPP
+#define INDIEPUB_KEY_ROTATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace indiepub
+{
+    // Picks up rotated keys without a restart.
+    //
+    // On SIGHUP, or when a key file under the archives changes, a background thread re-reads the
+    // RSA key sets and the session token keys and swaps them in. Request threads keep reading the
+    // previous keys until the swap and never wait for the reload. Move keys into place with a
+    // rename so a half-written file is not picked up.
+    class KeyRotation
+    {
+    public:
+        struct Options
+        {
+            std::chrono::seconds interval;  // 0 reloads on SIGHUP only
+
+            // config.h default, overridden by INDIEBACK_KEY_WATCH_INTERVAL
+            static Options fromEnvironment();
+        };
+
+        explicit KeyRotation(const Options &options);
+
+        ~KeyRotation();
+
+        KeyRotation(const KeyRotation &) = delete;
+        KeyRotation &operator=(const KeyRotation &) = delete;
+
+        // Installs the SIGHUP handler and starts the watcher; one instance per process.
+        bool start();
+
+        void stop();
+
+        // False when a key set kept its previous keys.
+        static bool reloadNow();
+
+    private:
+        void run();
+
+        // names, sizes and modification times of the key files
+        static std::string fingerprint();
+
+        Options options_;
+        std::thread worker_;
+        int wake_[2] = {-1, -1};
+        std::atomic<bool> stopping_{false};
+    };
+}
+
+#endif // INDIEPUB_KEY_ROTATION_HPP
@@ -0,0 +1,59 @@
+#ifndef INDIEPUB_PASSWORD_HASHER_HPP
+#define INDIEPUB_PASSWORD_HASHER_HPP
+
+#include <backend/auth/CryptoExecutor.hpp>
+#include <cstdint>
+#include <string>
+
+namespace indiepub
+{
+    // Salted scrypt password hashes, stored in credentials.pw_hash as
+    //   $scrypt$ln=<log2 N>,r=<block size>,p=<parallelism>$<base64 salt>$<base64 hash>
+    // so every row carries the cost it was hashed with and the cost can be raised over time.
+    // Rows from before this format hold the legacy hex SHA-256 and are upgraded on the next login.
+    class PasswordHasher
+    {
+    public:
+        struct Params
+        {
+            std::uint32_t log_n;
+            std::uint32_t r;
+            std::uint32_t p;
+
+            bool operator==(const Params &other) const
+            {
+                return log_n == other.log_n && r == other.r && p == other.p;
+            }
+        };
+
+        // Costs from INDIEBACK_PASSWORD_SCRYPT_LN / _R / _P or PASSWORD_SCRYPT_LN / _R / _P.
+        static PasswordHasher &instance();
+
+        explicit PasswordHasher(Params params);
+
+        std::string hash(const std::string &password) const;
+
+        // `rehash` is set when the password matched but was stored with other costs or the legacy format.
+        bool verify(const std::string &password, const std::string &stored, bool &rehash) const;
+
+        const Params &params() const;
+
+        // Memory one hash needs, 128 * r * N bytes.
+        static std::uint64_t memory(const Params &params);
+
+        // Unsalted SHA-256 hex of the first releases, kept only to check old rows.
+        static std::string legacyHash(const std::string &password);
+
+        // Pool that runs the KDF, sized by PASSWORD_HASH_THREADS / PASSWORD_HASH_QUEUE.
+        static CryptoExecutor &executor();
+
+    private:
+        static bool derive(const std::string &password, const std::string &salt, const Params &params, std::string &out);
+
+        static bool parse(const std::string &stored, Params &params, std::string &salt, std::string &hash);
+
+        Params params_;
+    };
+}
+
+#endif // INDIEPUB_PASSWORD_HASHER_HPP
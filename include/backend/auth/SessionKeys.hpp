@@ -0,0 +1,49 @@
+#ifndef INDIEPUB_SESSION_KEYS_HPP
+#define INDIEPUB_SESSION_KEYS_HPP
+
+#include <crypto/SessionCipher.hpp>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace indiepub
+{
+    // AES-256-GCM keys a client agreed on through one RSA exchange.
+    //
+    // The session id handed back to the client is the key itself, sealed with a secret derived
+    // from the session token key. Any rest_api process can recover the key from the id with one
+    // AES operation, so nothing has to be stored or replicated between processes. Ids sealed under
+    // a retired session token key keep opening after a rotation.
+    class SessionKeys
+    {
+    public:
+        // Secrets derived from the SessionToken key files.
+        static SessionKeys &instance();
+
+        SessionKeys(const std::vector<unsigned char> &secret, std::chrono::seconds ttl,
+                    const std::vector<std::vector<unsigned char>> &retired = {});
+
+        // New ids are sealed under `secret`; ids sealed under `retired` ones still open.
+        void rotate(const std::vector<unsigned char> &secret, const std::vector<std::vector<unsigned char>> &retired);
+
+        // Returns the session id for `key`; empty when the key is not SessionCipher::KEY_SIZE bytes.
+        std::string establish(const std::string &key, std::time_t &expires_at) const;
+
+        std::string establish(const std::string &key, std::time_t &expires_at, std::time_t now) const;
+
+        // The client's cipher, or nothing when the id is forged or expired.
+        std::optional<SessionCipher> find(const std::string &session_id) const;
+
+        std::optional<SessionCipher> find(const std::string &session_id, std::time_t now) const;
+
+    private:
+        // current ticket key first
+        std::shared_ptr<const std::vector<SessionCipher>> tickets_;
+        std::chrono::seconds ttl_;
+    };
+}
+
+#endif // INDIEPUB_SESSION_KEYS_HPP
@@ -0,0 +1,107 @@
+#ifndef INDIEPUB_SESSION_TOKEN_HPP
+#define INDIEPUB_SESSION_TOKEN_HPP
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace indiepub
+{
+    // Stateless bearer tokens: v1.<user_id>.<issued_at>.<expires_at>.<key_id>.<token_id>.<hmac>
+    //
+    // The HMAC-SHA256 over everything before the last dot is keyed with a secret shared by the
+    // rest_api processes, so a token is checked in memory without reading credentials.
+    // Logged-out tokens are kept in a revocation set until they would have expired anyway. The
+    // set is also written to a file shared by the processes on the host, so a restart or a new
+    // process loads it before serving instead of accepting logged-out tokens again.
+    //
+    // New tokens are signed with the current key; tokens signed with a retired key (`<key file>.<tag>`)
+    // keep verifying, so rotating the key does not log anybody out. rotate() swaps the key set in
+    // one pointer store and never blocks verify().
+    class SessionToken
+    {
+    public:
+        struct Claims
+        {
+            std::string user_id;
+            std::time_t issued_at;
+            std::time_t expires_at;
+            std::string key_id;
+            std::string token_id;
+        };
+
+        // Keys from keyFile(), the current one generated on first use, and the revocations in
+        // revocationFile().
+        static SessionToken &instance();
+
+        // INDIEBACK_SESSION_KEY_FILE or SESSION_KEY_FILE.
+        static std::string keyFile();
+
+        // INDIEBACK_SESSION_REVOKED_FILE or SESSION_REVOKED_FILE.
+        static std::string revocationFile();
+
+        SessionToken(const std::vector<unsigned char> &key, std::chrono::seconds ttl,
+                     const std::vector<std::vector<unsigned char>> &retired = {});
+
+        std::string issue(const std::string &user_id) const;
+
+        std::string issue(const std::string &user_id, std::time_t now) const;
+
+        // Checks format, key id, MAC, expiry and revocation. Retired keys are accepted.
+        bool verify(const std::string &token, Claims &claims) const;
+
+        bool verify(const std::string &token, Claims &claims, std::time_t now) const;
+
+        // In this process only; see logout().
+        void revoke(const std::string &token_id, std::time_t expires_at);
+
+        // Revokes the token here, in the revocation file and, through the invalidation bus, in
+        // the other processes.
+        void logout(const Claims &claims);
+
+        // Loads the revocations in `path` that have not expired, drops the others from the file,
+        // and has logout() append to it from now on. Returns how many were loaded.
+        size_t persistRevocations(const std::string &path);
+
+        bool isRevoked(const std::string &token_id) const;
+
+        // Makes `key` current; tokens of the `retired` keys stay valid.
+        void rotate(const std::vector<unsigned char> &key, const std::vector<std::vector<unsigned char>> &retired);
+
+        // Id of the current key.
+        std::string keyId() const;
+
+        static std::string keyId(const std::vector<unsigned char> &key);
+
+        // Tokens issued before this format are opaque strings checked against the database.
+        static bool isSessionToken(const std::string &token);
+
+        static std::vector<unsigned char> loadOrCreateKey(const std::string &path);
+
+        // Throws when the key file is missing or not a whole key; never creates one.
+        static std::vector<unsigned char> loadKey(const std::string &path);
+
+        // Keys in `<path>.<tag>` files, newest tag first.
+        static std::vector<std::vector<unsigned char>> loadRetiredKeys(const std::string &path);
+
+    private:
+        struct Keys
+        {
+            std::string current_id;
+            std::unordered_map<std::string, std::vector<unsigned char>> by_id;
+        };
+
+        std::shared_ptr<const Keys> keys_;
+        std::chrono::seconds ttl_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::time_t> revoked_;
+        std::string revocation_path_;       // guarded by mutex_
+    };
+}
+
+#endif // INDIEPUB_SESSION_TOKEN_HPP
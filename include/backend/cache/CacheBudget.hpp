@@ -0,0 +1,99 @@
+#ifndef INDIEPUB_CACHE_BUDGET_HPP
+#define INDIEPUB_CACHE_BUDGET_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace indiepub
+{
+    // Byte and hit counters of one cache, updated by the cache and read by the budget.
+    struct CacheAccount
+    {
+        std::atomic<size_t> bytes{0};
+        std::atomic<size_t> limit{SIZE_MAX};
+        std::atomic<size_t> entries{0};
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::uint64_t> evictions{0};
+
+        // asks the owning cache to evict down to a lowered limit
+        std::function<void()> trim;
+    };
+
+    // One memory budget shared by all named in-process caches.
+    //
+    // Each cache starts with a weighted share of the budget. rebalance() then moves a fixed
+    // step from the cache with the fewest recent hits per byte to the one with the most,
+    // as long as the receiver is actually short of memory and the donor keeps its floor.
+    class CacheBudget
+    {
+    public:
+        struct Gauge
+        {
+            std::string name;
+            size_t bytes;
+            size_t limit;
+            size_t entries;
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::uint64_t evictions;
+        };
+
+        static CacheBudget &instance();
+
+        explicit CacheBudget(size_t total);
+
+        ~CacheBudget();
+
+        CacheBudget(const CacheBudget &) = delete;
+        CacheBudget &operator=(const CacheBudget &) = delete;
+
+        void enroll(const std::string &name, std::shared_ptr<CacheAccount> account, double weight);
+
+        void withdraw(const std::string &name);
+
+        // Returns true when memory moved between caches.
+        bool rebalance();
+
+        void start(std::chrono::seconds interval);
+
+        void stop();
+
+        size_t total() const;
+
+        std::vector<Gauge> gauges() const;
+
+        // Prometheus text exposition of the gauges.
+        std::string exposition() const;
+
+    private:
+        struct Member
+        {
+            std::string name;
+            std::shared_ptr<CacheAccount> account;
+            double weight;
+            std::uint64_t last_hits;
+            std::uint64_t last_evictions;
+        };
+
+        void assignShares();
+
+        size_t total_;
+        mutable std::mutex mutex_;
+        std::vector<Member> members_;
+
+        std::thread worker_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+    };
+}
+
+#endif // INDIEPUB_CACHE_BUDGET_HPP
@@ -0,0 +1,59 @@
+#ifndef INDIEPUB_CACHE_SNAPSHOT_HPP
+#define INDIEPUB_CACHE_SNAPSHOT_HPP
+
+#include <backend/cache/InvalidationBus.hpp>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace indiepub
+{
+    // On-disk image of the read caches so a restarted process starts warm.
+    //
+    // Layout: fixed header (magic, format version, creation time, section count, body length,
+    // crc32 of the body) followed by one section per entity type holding length-prefixed
+    // key / EntityCodec value pairs. The file is memory-mapped read-only when restored.
+    class CacheSnapshot
+    {
+    public:
+        static constexpr std::uint32_t FORMAT_VERSION = 1;
+
+        struct Section
+        {
+            EntityType entity;
+            std::vector<std::pair<std::string, std::string>> entries;
+        };
+
+        using Visitor = std::function<void(std::string_view key, std::string_view value)>;
+
+        // Writes to a temporary file and renames it over `path`, so readers never see a partial file.
+        static bool write(const std::string &path, const std::vector<Section> &sections);
+
+        // Returns nullptr when the file is missing, corrupt, from another format version or older than max_age.
+        static std::unique_ptr<CacheSnapshot> open(const std::string &path, std::chrono::seconds max_age);
+
+        ~CacheSnapshot();
+
+        CacheSnapshot(const CacheSnapshot &) = delete;
+        CacheSnapshot &operator=(const CacheSnapshot &) = delete;
+
+        // Visits every entry of `entity`; returns how many were visited.
+        size_t forEach(EntityType entity, const Visitor &visitor) const;
+
+        std::time_t createdAt() const;
+
+    private:
+        CacheSnapshot(void *base, size_t length);
+
+        void *base_;
+        size_t length_;
+    };
+}
+
+#endif // INDIEPUB_CACHE_SNAPSHOT_HPP
@@ -0,0 +1,59 @@
+#ifndef INDIEPUB_CACHE_SNAPSHOTTER_HPP
+#define INDIEPUB_CACHE_SNAPSHOTTER_HPP
+
+#include <backend/cache/Caches.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace indiepub
+{
+    // Restores the caches from the last snapshot at startup, revalidates what was restored
+    // in the background and keeps the snapshot fresh until shutdown.
+    class CacheSnapshotter
+    {
+    public:
+        struct Options
+        {
+            std::string path;               // empty disables snapshots
+            std::chrono::seconds interval;  // 0 only writes on shutdown
+            std::chrono::seconds max_age;
+
+            // config.h defaults, overridden by INDIEBACK_SNAPSHOT_* environment variables
+            static Options fromEnvironment();
+        };
+
+        using Revalidator = std::function<void(const Caches::Restored &restored)>;
+
+        explicit CacheSnapshotter(const Options &options);
+
+        ~CacheSnapshotter();
+
+        CacheSnapshotter(const CacheSnapshotter &) = delete;
+        CacheSnapshotter &operator=(const CacheSnapshotter &) = delete;
+
+        // Returns the number of restored entries.
+        size_t start(Revalidator revalidator);
+
+        // Stops the background thread and writes a final snapshot.
+        void stop();
+
+        // Safe to call from any thread; one snapshot is written at a time.
+        bool saveNow();
+
+    private:
+        void run(Caches::Restored restored, Revalidator revalidator);
+
+        Options options_;
+        std::thread worker_;
+        std::mutex mutex_;
+        std::mutex save_mutex_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+    };
+}
+
+#endif // INDIEPUB_CACHE_SNAPSHOTTER_HPP
@@ -0,0 +1,61 @@
+#ifndef INDIEPUB_CACHES_HPP
+#define INDIEPUB_CACHES_HPP
+
+#include <backend/cache/EntityCache.hpp>
+#include <backend/models/Credentials.hpp>
+#include <backend/models/User.hpp>
+#include <backend/models/Venue.hpp>
+#include <backend/models/EventByVenue.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace indiepub
+{
+    // Process-wide read caches, kept coherent through InvalidationBus.
+    class Caches
+    {
+    public:
+        // auth token -> credentials
+        static EntityCache<Credentials> &auth();
+
+        // user_id -> user
+        static EntityCache<User> &users();
+
+        // venue_id -> venue
+        static EntityCache<Venue> &venues();
+
+        // "all" / "week" -> event list, dropped on any event change
+        static EntityCache<std::vector<EventByVenue>> &eventCatalog();
+
+        // "all" / "week", optionally ":gzip" / ":deflate" -> rendered event feed, dropped with the
+        // catalog; rebuilt cheaply, so neither shared nor snapshotted
+        static EntityCache<std::string> &eventFeeds();
+
+        // Backs every cache above with the host-wide segment when INDIEBACK_SHARED_CACHE=on.
+        static bool enableShared();
+
+        static SharedCache *shared();
+
+        // keys restored from a snapshot, to be revalidated against the database
+        struct Restored
+        {
+            std::vector<std::string> auth;
+            std::vector<std::string> venues;
+            std::vector<std::string> events;
+
+            size_t size() const;
+        };
+
+        // Persists the auth, venue and event catalog caches.
+        static bool saveSnapshot(const std::string &path);
+
+        static Restored loadSnapshot(const std::string &path, std::chrono::seconds max_age);
+
+    private:
+        static std::unique_ptr<SharedCache> &segment();
+    };
+}
+
+#endif // INDIEPUB_CACHES_HPP
@@ -0,0 +1,378 @@
+#ifndef INDIEPUB_ENTITY_CACHE_HPP
+#define INDIEPUB_ENTITY_CACHE_HPP
+
+#include <backend/async/Async.hpp>
+#include <backend/cache/CacheBudget.hpp>
+#include <backend/cache/EntityCodec.hpp>
+#include <backend/cache/EntitySize.hpp>
+#include <backend/cache/InvalidationBus.hpp>
+#include <backend/cache/SharedCache.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace indiepub
+{
+    // LRU + TTL read cache that evicts itself from InvalidationBus events.
+    // Optionally backed by a SharedCache segment that other processes on the host also fill.
+    // Entries are costed in approximate bytes so a CacheBudget can bound the cache by memory.
+    template <typename V>
+    class EntityCache
+    {
+    public:
+        // Decides whether a cached value is affected by a change to `key` when the cache
+        // is not keyed by the entity id (e.g. credentials cached by auth token).
+        using Matcher = std::function<bool(const V &value, const std::string &key)>;
+        using Loader = std::function<std::optional<V>()>;
+        using AsyncLoader = std::function<Async<std::optional<V>>()>;
+        // Entity key a value depends on, used to tag shared entries; empty means every key.
+        using Owner = std::function<std::string(const V &value, const std::string &key)>;
+
+        EntityCache(EntityType entity, size_t capacity, std::chrono::seconds ttl, Matcher matcher = nullptr)
+            : entity_(entity), capacity_(capacity), ttl_(ttl), matcher_(std::move(matcher)),
+              account_(std::make_shared<CacheAccount>())
+        {
+            account_->trim = [this]() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                evictOverflow();
+            };
+            subscription_ = InvalidationBus::instance().subscribe(entity_, [this](const ChangeEvent &event) {
+                invalidate(event);
+            });
+        }
+
+        ~EntityCache()
+        {
+            InvalidationBus::instance().unsubscribe(subscription_);
+            if (budget_ != nullptr)
+                budget_->withdraw(name_);
+        }
+
+        EntityCache(const EntityCache &) = delete;
+        EntityCache &operator=(const EntityCache &) = delete;
+
+        // Must be called before the cache is shared between threads.
+        template <typename Codec = EntityCodec>
+        void attachShared(SharedCache *shared, Owner owner = nullptr)
+        {
+            shared_ = shared;
+            owner_ = std::move(owner);
+            encode_ = [](const V &value, std::string &out) { Codec::encode(value, out); };
+            decode_ = [](std::string_view in, V &value) { return Codec::decode(in, value); };
+        }
+
+        // Puts the cache under `budget` as `name`; returns true so it can initialize a static.
+        bool enroll(CacheBudget &budget, const std::string &name, double weight)
+        {
+            budget_ = &budget;
+            name_ = name;
+            budget.enroll(name, account_, weight);
+            return true;
+        }
+
+        std::shared_ptr<const CacheAccount> account() const
+        {
+            return account_;
+        }
+
+        std::optional<V> get(const std::string &key)
+        {
+            if (auto local = getLocal(key))
+            {
+                account_->hits.fetch_add(1, std::memory_order_relaxed);
+                return local;
+            }
+            std::string bytes;
+            V value;
+            std::uint64_t generation = generation_snapshot();
+            if (shared_ == nullptr || !shared_->get(entity_, key, bytes) || !decode_(bytes, value))
+            {
+                account_->misses.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+            account_->hits.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (generation == generation_)
+                store(key, value);
+            return value;
+        }
+
+        void put(const std::string &key, const V &value)
+        {
+            std::uint32_t shared = sharedGeneration();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                store(key, value);
+            }
+            putShared(key, value, shared);
+        }
+
+        // Values loaded while an invalidation was in flight are returned but not cached.
+        std::optional<V> getOrLoad(const std::string &key, const Loader &loader)
+        {
+            if (auto cached = get(key))
+                return cached;
+            std::uint64_t generation = generation_snapshot();
+            std::uint32_t shared = sharedGeneration();
+            std::optional<V> loaded = loader();
+            if (loaded)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (generation != generation_)
+                        return loaded;
+                    store(key, *loaded);
+                }
+                putShared(key, *loaded, shared);
+            }
+            return loaded;
+        }
+
+        // getOrLoad for loaders that complete on another thread; a hit completes immediately.
+        Async<std::optional<V>> getOrLoadAsync(const std::string &key, const AsyncLoader &loader)
+        {
+            if (auto cached = get(key))
+                return Async<std::optional<V>>::value(std::move(cached));
+            std::uint64_t generation = generation_snapshot();
+            std::uint32_t shared = sharedGeneration();
+            return loader().then([this, key, generation, shared](const std::optional<V> &loaded) {
+                if (loaded)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (generation != generation_)
+                            return loaded;
+                        store(key, *loaded);
+                    }
+                    putShared(key, *loaded, shared);
+                }
+                return loaded;
+            });
+        }
+
+        // Reloads `key` regardless of what is cached; a key the loader no longer finds is dropped.
+        void refresh(const std::string &key, const Loader &loader)
+        {
+            std::uint64_t generation = generation_snapshot();
+            std::uint32_t shared = sharedGeneration();
+            std::optional<V> loaded = loader();
+            if (!loaded)
+            {
+                erase(key);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (generation != generation_)
+                    return;
+                store(key, *loaded);
+            }
+            putShared(key, *loaded, shared);
+        }
+
+        // Unexpired entries, most recently used first.
+        std::vector<std::pair<std::string, V>> entries() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<std::pair<std::string, V>> result;
+            result.reserve(index_.size());
+            auto now = Clock::now();
+            for (const auto &entry : lru_)
+            {
+                if (entry.expires > now)
+                    result.emplace_back(entry.key, entry.value);
+            }
+            return result;
+        }
+
+        void erase(const std::string &key)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++generation_;
+            auto it = index_.find(key);
+            if (it != index_.end())
+                remove(it->second);
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++generation_;
+            lru_.clear();
+            index_.clear();
+            bytes_ = 0;
+            publishUsage();
+        }
+
+        // Approximate bytes held, including keys and per-entry bookkeeping.
+        size_t bytes() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return bytes_;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return index_.size();
+        }
+
+        void invalidate(const ChangeEvent &event)
+        {
+            if (shared_ != nullptr)
+            {
+                // every process drops the shared entry on the same event; the repeats are harmless
+                if (event.key.empty())
+                    shared_->clear(entity_);
+                else if (owner_)
+                    shared_->eraseOwnedBy(entity_, event.key);
+                else
+                    shared_->erase(entity_, event.key);
+            }
+            if (event.key.empty())
+            {
+                clear();
+                return;
+            }
+            if (!matcher_)
+            {
+                erase(event.key);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++generation_;
+            for (auto it = lru_.begin(); it != lru_.end();)
+            {
+                if (matcher_(it->value, event.key))
+                    it = remove(it);
+                else
+                    ++it;
+            }
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            std::string key;
+            V value;
+            Clock::time_point expires;
+            size_t cost;
+        };
+
+        using Iterator = typename std::list<Entry>::iterator;
+
+        // list node plus hash node, bucket slot and the index's copy of the key
+        static constexpr size_t ENTRY_OVERHEAD = sizeof(Entry) + 2 * sizeof(void *) + sizeof(std::string) + 4 * sizeof(void *);
+
+        std::optional<V> getLocal(const std::string &key)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it == index_.end())
+                return std::nullopt;
+            if (it->second->expires <= Clock::now())
+            {
+                remove(it->second);
+                return std::nullopt;
+            }
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->value;
+        }
+
+        // `since` is sharedGeneration() from before the value was loaded. An invalidation landing
+        // between the local generation check and this put reaches the segment first, so the put
+        // is dropped then too.
+        void putShared(const std::string &key, const V &value, std::uint32_t since)
+        {
+            if (shared_ == nullptr)
+                return;
+            std::string bytes;
+            encode_(value, bytes);
+            shared_->put(entity_, key, bytes, ttl_, owner_ ? owner_(value, key) : key, since);
+        }
+
+        std::uint32_t sharedGeneration() const
+        {
+            return shared_ == nullptr ? 0 : shared_->generation(entity_);
+        }
+
+        std::uint64_t generation_snapshot() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return generation_;
+        }
+
+        void store(const std::string &key, const V &value)
+        {
+            if (capacity_ == 0)
+                return;
+            auto it = index_.find(key);
+            if (it != index_.end())
+                remove(it->second);
+            size_t cost = ENTRY_OVERHEAD + 2 * heapSize(key) + approximateSize(value);
+            lru_.push_front({key, value, Clock::now() + ttl_, cost});
+            index_[key] = lru_.begin();
+            bytes_ += cost;
+            evictOverflow();
+            publishUsage();
+        }
+
+        Iterator remove(Iterator entry)
+        {
+            bytes_ -= entry->cost;
+            index_.erase(entry->key);
+            Iterator next = lru_.erase(entry);
+            publishUsage();
+            return next;
+        }
+
+        void evictOverflow()
+        {
+            size_t limit = account_->limit.load(std::memory_order_relaxed);
+            while (!lru_.empty() && (index_.size() > capacity_ || bytes_ > limit))
+            {
+                remove(std::prev(lru_.end()));
+                account_->evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void publishUsage()
+        {
+            account_->bytes.store(bytes_, std::memory_order_relaxed);
+            account_->entries.store(index_.size(), std::memory_order_relaxed);
+        }
+
+        EntityType entity_;
+        size_t capacity_;
+        std::chrono::seconds ttl_;
+        Matcher matcher_;
+        size_t subscription_ = 0;
+
+        SharedCache *shared_ = nullptr;
+        Owner owner_;
+        std::function<void(const V &, std::string &)> encode_;
+        std::function<bool(std::string_view, V &)> decode_;
+
+        std::shared_ptr<CacheAccount> account_;
+        CacheBudget *budget_ = nullptr;
+        std::string name_;
+
+        mutable std::mutex mutex_;
+        std::list<Entry> lru_;
+        std::unordered_map<std::string, Iterator> index_;
+        std::uint64_t generation_ = 0;
+        size_t bytes_ = 0;
+    };
+}
+
+#endif // INDIEPUB_ENTITY_CACHE_HPP
@@ -0,0 +1,33 @@
+#ifndef INDIEPUB_ENTITY_CODEC_HPP
+#define INDIEPUB_ENTITY_CODEC_HPP
+
+#include <backend/models/Credentials.hpp>
+#include <backend/models/User.hpp>
+#include <backend/models/Venue.hpp>
+#include <backend/models/EventByVenue.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace indiepub
+{
+    // Compact binary form of cached models, shared by the shared-memory segment and snapshots.
+    // Length-prefixed fields in host byte order; it never leaves the machine.
+    class EntityCodec
+    {
+    public:
+        static void encode(const User &user, std::string &out);
+        static void encode(const Venue &venue, std::string &out);
+        static void encode(const Credentials &creds, std::string &out);
+        static void encode(const EventByVenue &event, std::string &out);
+        static void encode(const std::vector<EventByVenue> &events, std::string &out);
+
+        static bool decode(std::string_view in, User &user);
+        static bool decode(std::string_view in, Venue &venue);
+        static bool decode(std::string_view in, Credentials &creds);
+        static bool decode(std::string_view in, EventByVenue &event);
+        static bool decode(std::string_view in, std::vector<EventByVenue> &events);
+    };
+}
+
+#endif // INDIEPUB_ENTITY_CODEC_HPP
@@ -0,0 +1,61 @@
+#ifndef INDIEPUB_ENTITY_SIZE_HPP
+#define INDIEPUB_ENTITY_SIZE_HPP
+
+#include <backend/models/Credentials.hpp>
+#include <backend/models/User.hpp>
+#include <backend/models/Venue.hpp>
+#include <backend/models/EventByVenue.hpp>
+#include <string>
+#include <vector>
+
+namespace indiepub
+{
+    // Approximate heap footprint of cached values, used for cache memory accounting.
+    // Strings short enough for the small-string buffer cost nothing beyond the object itself.
+    inline size_t heapSize(const std::string &value)
+    {
+        return value.size() < sizeof(std::string) ? 0 : value.size() + 1;
+    }
+
+    inline size_t approximateSize(const std::string &value)
+    {
+        return sizeof(std::string) + heapSize(value);
+    }
+
+    inline size_t approximateSize(const Credentials &creds)
+    {
+        return sizeof(Credentials) + heapSize(creds.user_id()) + heapSize(creds.auth_token()) + heapSize(creds.pw_hash());
+    }
+
+    inline size_t approximateSize(const User &user)
+    {
+        size_t size = sizeof(User) + heapSize(user.user_id()) + heapSize(user.email()) + heapSize(user.role()) +
+                      heapSize(user.name()) + heapSize(user.bio()) + heapSize(user.profile_picture());
+        for (const auto &link : user.social_links())
+            size += approximateSize(link);
+        return size;
+    }
+
+    inline size_t approximateSize(const Venue &venue)
+    {
+        return sizeof(Venue) + heapSize(venue.venue_id()) + heapSize(venue.owner_id()) + heapSize(venue.name()) +
+               heapSize(venue.location());
+    }
+
+    inline size_t approximateSize(const EventByVenue &event)
+    {
+        return sizeof(EventByVenue) + heapSize(event.event_id()) + heapSize(event.venue_id()) + heapSize(event.band_id()) +
+               heapSize(event.creator_id()) + heapSize(event.name());
+    }
+
+    template <typename T>
+    size_t approximateSize(const std::vector<T> &values)
+    {
+        size_t size = sizeof(std::vector<T>);
+        for (const auto &value : values)
+            size += approximateSize(value);
+        return size;
+    }
+}
+
+#endif // INDIEPUB_ENTITY_SIZE_HPP
@@ -0,0 +1,73 @@
+#ifndef INDIEPUB_INVALIDATION_BUS_HPP
+#define INDIEPUB_INVALIDATION_BUS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace indiepub
+{
+    enum class EntityType : std::uint8_t
+    {
+        USER,
+        VENUE,
+        VENUE_MEMBER,   // keyed by user_id
+        CREDENTIALS,    // keyed by user_id
+        EVENT,
+        SESSION,        // keyed by "<token_id>:<expires_at>", published on logout
+        ANY             // only valid for subscriptions and full flushes
+    };
+
+    // An empty key means every key of the entity type changed.
+    struct ChangeEvent
+    {
+        EntityType entity;
+        std::string key;
+        std::uint64_t version;
+    };
+
+    class InvalidationBus
+    {
+    public:
+        using Listener = std::function<void(const ChangeEvent &)>;
+
+        static InvalidationBus &instance();
+
+        size_t subscribe(EntityType entity, Listener listener);
+
+        void unsubscribe(size_t id);
+
+        // Stamps the event with the next bus version and delivers it.
+        std::uint64_t publish(EntityType entity, const std::string &key);
+
+        // Delivers an event that already carries a version, e.g. one received from another process.
+        void dispatch(const ChangeEvent &event);
+
+        std::uint64_t version() const;
+
+    private:
+        struct Subscription
+        {
+            size_t id;
+            EntityType entity;
+            Listener listener;
+        };
+
+        using Subscriptions = std::vector<Subscription>;
+
+        InvalidationBus() = default;
+
+        std::shared_ptr<const Subscriptions> snapshot() const;
+
+        mutable std::mutex mutex_;
+        std::shared_ptr<const Subscriptions> subscriptions_ = std::make_shared<Subscriptions>();
+        size_t next_id_ = 1;
+        std::atomic<std::uint64_t> version_{0};
+    };
+}
+
+#endif // INDIEPUB_INVALIDATION_BUS_HPP
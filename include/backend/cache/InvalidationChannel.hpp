@@ -0,0 +1,127 @@
+#ifndef INDIEPUB_INVALIDATION_CHANNEL_HPP
+#define INDIEPUB_INVALIDATION_CHANNEL_HPP
+
+#include <backend/cache/InvalidationBus.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace indiepub
+{
+    // Mirrors InvalidationBus events between rest_api processes on the same host.
+    // Every sender numbers its datagrams; a gap or a heartbeat ahead of what we saw
+    // means something was lost, and the only safe answer is a full local flush.
+    class InvalidationChannel
+    {
+    public:
+        enum class Transport
+        {
+            OFF,
+            UNIX,       // one datagram socket per process in a shared directory
+            MULTICAST   // UDP multicast with TTL 0, never leaves the host
+        };
+
+        struct Options
+        {
+            Transport transport;
+            std::string socket_dir;
+            std::string group;
+            int port;
+            std::chrono::milliseconds heartbeat;
+
+            // config.h defaults, overridden by INDIEBACK_INVALIDATION_* environment variables
+            static Options fromEnvironment();
+        };
+
+        enum class Kind : std::uint8_t
+        {
+            INVALIDATE = 1,
+            HEARTBEAT = 2
+        };
+
+        struct Message
+        {
+            Kind kind;
+            std::uint64_t sender;
+            std::uint64_t sequence;
+            ChangeEvent event;
+        };
+
+        struct Stats
+        {
+            std::uint64_t sent;
+            std::uint64_t received;
+            std::uint64_t gaps;
+            std::uint64_t flushes;
+        };
+
+        explicit InvalidationChannel(const Options &options);
+
+        ~InvalidationChannel();
+
+        InvalidationChannel(const InvalidationChannel &) = delete;
+        InvalidationChannel &operator=(const InvalidationChannel &) = delete;
+
+        bool start();
+
+        void stop();
+
+        bool running() const;
+
+        Stats stats() const;
+
+        std::uint64_t senderId() const;
+
+        static std::string encode(const Message &message);
+
+        static bool decode(const char *data, size_t length, Message &message);
+
+    private:
+        struct Peer
+        {
+            std::uint64_t sequence;
+            std::chrono::steady_clock::time_point seen;
+        };
+
+        bool openUnix();
+
+        bool openMulticast();
+
+        void forward(const ChangeEvent &event);
+
+        // Numbers INVALIDATE messages; a heartbeat carries the last number sent.
+        void send(Kind kind, const ChangeEvent &event);
+
+        void receiveLoop();
+
+        void onMessage(const Message &message);
+
+        void flush();
+
+        void expirePeers();
+
+        Options options_;
+        int fd_ = -1;
+        std::string socket_path_;
+        std::uint64_t sender_;
+        std::atomic<bool> running_{false};
+        size_t subscription_ = 0;
+        std::thread receiver_;
+
+        std::mutex send_mutex_;
+        std::uint64_t sequence_ = 0;    // guarded by send_mutex_
+        std::mutex peers_mutex_;
+        std::unordered_map<std::uint64_t, Peer> peers_;
+
+        std::atomic<std::uint64_t> sent_{0};
+        std::atomic<std::uint64_t> received_{0};
+        std::atomic<std::uint64_t> gaps_{0};
+        std::atomic<std::uint64_t> flushes_{0};
+    };
+}
+
+#endif // INDIEPUB_INVALIDATION_CHANNEL_HPP
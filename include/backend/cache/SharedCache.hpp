@@ -0,0 +1,91 @@
+#ifndef INDIEPUB_SHARED_CACHE_HPP
+#define INDIEPUB_SHARED_CACHE_HPP
+
+#include <backend/cache/InvalidationBus.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace indiepub
+{
+    // Fixed-size open-addressing hash table in a POSIX shared memory segment so every
+    // rest_api process on the host reads the same warm copy of read-mostly entities.
+    //
+    // Readers never lock: each slot carries a sequence counter that is odd while the slot
+    // is being rewritten (seqlock), and a read that overlaps a write is retried.
+    // Writers from any process serialize on a robust process-shared mutex in the header.
+    // Invalidating by owner only bumps a shared generation counter; entries written under an
+    // older generation read as misses and their slots are reused. Every invalidation of an
+    // entity type also advances the type's own generation, so a value loaded while one was in
+    // flight can be kept out of the segment.
+    class SharedCache
+    {
+    public:
+        struct Stats
+        {
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::uint64_t writes;
+            std::uint64_t evictions;
+            std::uint32_t slots;
+            std::uint32_t used;     // includes entries invalidated by owner but not yet reused
+        };
+
+        // Creates the segment or attaches to an existing one with the same geometry.
+        static std::unique_ptr<SharedCache> open(const std::string &name, std::uint32_t slots, std::uint32_t value_size);
+
+        static bool remove(const std::string &name);
+
+        ~SharedCache();
+
+        SharedCache(const SharedCache &) = delete;
+        SharedCache &operator=(const SharedCache &) = delete;
+
+        bool get(EntityType entity, const std::string &key, std::string &value);
+
+        // Read before loading a value for put(): advanced by every erase, eraseOwnedBy and clear
+        // of `entity`, whatever the owner.
+        std::uint32_t generation(EntityType entity) const;
+
+        // `owner` is the entity key whose change invalidates this entry; empty means the entry
+        // depends on every key of the entity type. `since` is generation(entity) from before the
+        // value was loaded; the put is dropped, returning false, when it has moved on since.
+        bool put(EntityType entity, const std::string &key, const std::string &value,
+                 std::chrono::milliseconds ttl, const std::string &owner, std::uint32_t since);
+
+        void erase(EntityType entity, const std::string &key);
+
+        // Drops the entries owned by `owner` and those without an owner, in constant time.
+        void eraseOwnedBy(EntityType entity, const std::string &owner);
+
+        // EntityType::ANY clears the whole segment.
+        void clear(EntityType entity);
+
+        Stats stats() const;
+
+        std::uint32_t valueCapacity() const;
+
+    private:
+        struct Header;
+        struct Slot;
+
+        SharedCache(int fd, void *base, size_t length);
+
+        Slot *slot(std::uint32_t index) const;
+
+        std::atomic<std::uint32_t> &generation(std::uint64_t owner_hash) const;
+
+        void lockWriter();
+
+        void unlockWriter();
+
+        int fd_;
+        void *base_;
+        size_t length_;
+        Header *header_;
+    };
+}
+
+#endif // INDIEPUB_SHARED_CACHE_HPP
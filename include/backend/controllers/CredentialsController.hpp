@@ -2,6 +2,7 @@
 #define INDIEPUB_CREDENTIALS_CONTROLLER_HPP
 
 #include <backend/CassandraConnection.hpp>
+#include <backend/async/Task.hpp>
 #include <backend/models/Credentials.hpp>
 
 namespace indiepub 
@@ -20,6 +21,12 @@ namespace indiepub
         indiepub::Credentials getCredentialsByUserId(const std::string &user_id);
         indiepub::Credentials getCredentialsByAuthToken(const std::string &auth_token);
         indiepub::Credentials getCredentialsByPwHash(const std::string &pw_hash);
+
+        // Non-blocking counterparts: empty Credentials when there is no match, a failed Async when
+        // the query fails.
+        indiepub::Task<bool> insertCredentialsAsync(indiepub::Credentials creds);
+        indiepub::Async<indiepub::Credentials> getCredentialsByUserIdAsync(const std::string &user_id);
+        indiepub::Async<indiepub::Credentials> getCredentialsByAuthTokenAsync(const std::string &auth_token);
     };
 }
 
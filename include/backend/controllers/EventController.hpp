@@ -20,6 +20,13 @@ namespace indiepub {
         indiepub::EventByVenue getEventById(const std::string& event_id);
         indiepub::EventByVenue getEventBy(const std::string& name, const std::string& location);
 
+        // Non-blocking counterparts; a failed Async when the query fails.
+        indiepub::Async<std::vector<indiepub::EventByVenue>> getAllEventsAsync();
+        indiepub::Async<std::vector<indiepub::EventByVenue>> getOneWeekEventsAsync(const time_t& start_date);
+        indiepub::Async<indiepub::EventByVenue> getEventByIdAsync(const std::string& event_id);
+        // One partition, newest first.
+        indiepub::Async<std::vector<indiepub::EventByVenue>> getEventsByVenueAsync(const std::string& venue_id);
+
     private:
         // Add any private members or methods if needed
     };
@@ -2,6 +2,7 @@
 #define INDIEPUB_USERS_CONTROLLER_HPP
 
 #include <backend/CassandraConnection.hpp>
+#include <backend/async/Task.hpp>
 #include <backend/models/User.hpp>
 #include <functional>
 
@@ -21,6 +22,14 @@ namespace indiepub {
         indiepub::User getUserByEmail(const std::string& email);
         indiepub::User getUserBy(const std::string& name, const std::string& email);
 
+        // Non-blocking counterparts: an empty User when there is no match, a failed Async when
+        // the query fails.
+        indiepub::Async<indiepub::User> getUserByIdAsync(const std::string& user_id);
+        indiepub::Async<indiepub::User> getUserByEmailAsync(const std::string& email);
+        indiepub::Async<indiepub::User> getUserByAsync(const std::string& name, const std::string& email);
+
+        indiepub::Task<bool> insertUserAsync(indiepub::User user);
+
     private:
         // Add any private members or methods if needed
     };
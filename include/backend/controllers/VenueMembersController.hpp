@@ -16,6 +16,9 @@ namespace indiepub {
         indiepub::VenueMembers getVenueMemberById(const std::string& venue_id, const std::string& user_id);
         indiepub::VenueMembers getVenueMemberByUserId(const std::string &user_id);
         std::vector<indiepub::VenueMembers> getVenueMembersByRole(const std::string& role);
+
+        // getVenueMemberByUserId without blocking; a failed Async when the query fails.
+        indiepub::Async<indiepub::VenueMembers> getVenueMemberByUserIdAsync(const std::string &user_id);
     
     private:
         // Add any private members or methods if needed
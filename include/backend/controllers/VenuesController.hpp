@@ -21,6 +21,9 @@ namespace indiepub
         indiepub::Venue getVenueById(const std::string &venue_id);
         indiepub::Venue getVenueBy(const std::string &name, const std::string &location);
 
+        // getVenueById without blocking; a failed Async when the query fails.
+        indiepub::Async<indiepub::Venue> getVenueByIdAsync(const std::string &venue_id);
+
     private:
         // Add any private members or methods if needed
     };
@@ -5,18 +5,25 @@
 #include <openssl/evp.h>
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
+#include <memory>
 #include <string>
 
+class KeyPair;
+
 class AuthCrypto {
 private:
     const char *filename;
     std::string public_key_file;
     std::string private_key_file;
-    EVP_PKEY *public_key;
-    EVP_PKEY *private_key;
+    EVP_PKEY *public_key = nullptr;
+    EVP_PKEY *private_key = nullptr;
+    // keys borrowed from the KeyRing stay loaded between operations
+    bool pinned = false;
 
     void init();
 
+    void initFileNames();
+
     void destroy();
 
     void unloadPublicKey();
@@ -28,6 +35,9 @@ public:
     
     AuthCrypto(const char *filename);
 
+    // Borrows already parsed keys; no filesystem access.
+    AuthCrypto(const char *filename, const std::shared_ptr<const KeyPair> &keys);
+
     ~AuthCrypto();
     
     std::string getPublicKeyFilename();
@@ -52,7 +62,8 @@ public:
 
     size_t encrypt(unsigned char *src, unsigned char *&out);
 
-    size_t decrypt(unsigned char *src, size_t src_len, unsigned char *&out, const char *password=NULL);
+    // See CryptoContexts::decryptContext for `explicitRejection`.
+    size_t decrypt(unsigned char *src, size_t src_len, unsigned char *&out, const char *password=NULL, bool explicitRejection=false);
 
     size_t sign(const char *msg, unsigned char *&sig, const char *password=NULL);
 
@@ -63,6 +74,9 @@ public:
     void loadPublicKey(std::string filename);
     
     void loadPrivateKey(std::string filename, const char *password="");
+
+    // Hands the loaded keys over to a KeyPair, leaving this instance without keys.
+    std::shared_ptr<const KeyPair> releaseKeys();
 };
 
 #endif // __AUTH_CRYPTO_HPP__
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef INDIEPUB_CRYPTO_CONTEXTS_HPP
+#define INDIEPUB_CRYPTO_CONTEXTS_HPP
+
+#include <openssl/evp.h>
+
+// Per-thread cache of initialized OpenSSL contexts so hot calls only run the RSA math.
+//
+// Everything uses the default library context. The digest is fetched once per process;
+// the EVP_PKEY_CTX / EVP_MD_CTX templates are built once per thread and key and hold a
+// reference on the key, so a cached pointer can never be reused by another key.
+class CryptoContexts {
+public:
+    // RSA_HASH_ALGO, fetched once.
+    static const EVP_MD *digest();
+
+    // Reset digest context owned by the calling thread.
+    static EVP_MD_CTX *digestContext();
+
+    // AES-256-GCM, fetched once.
+    static const EVP_CIPHER *aead();
+
+    // Reset cipher context owned by the calling thread.
+    static EVP_CIPHER_CTX *cipherContext();
+
+    // Contexts ready for EVP_PKEY_encrypt / EVP_PKEY_decrypt with PKCS#1 padding. With
+    // `explicitRejection` a decrypt under the wrong key fails instead of returning the random
+    // message of implicit rejection.
+    static EVP_PKEY_CTX *encryptContext(EVP_PKEY *key);
+    static EVP_PKEY_CTX *decryptContext(EVP_PKEY *key, bool explicitRejection = false);
+
+    // The thread's digest context, primed for DigestSign / DigestVerify update and final.
+    static EVP_MD_CTX *signContext(EVP_PKEY *key);
+    static EVP_MD_CTX *verifyContext(EVP_PKEY *key);
+
+    // Drops this thread's templates for `key`, e.g. after an operation left one in an unknown state.
+    static void discard(EVP_PKEY *key);
+
+    // Frees every context owned by the calling thread.
+    static void release();
+};
+
+#endif // INDIEPUB_CRYPTO_CONTEXTS_HPP
@@ -2,15 +2,57 @@
 #define AUTH_HASH_HPP
 
 #include "config.h"
+#include <array>
+#include <cstddef>
+#include <string_view>
 
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+// Message digests returned by value, so concurrent callers never share a buffer.
+// One-shot calls reuse a digest context owned by the calling thread.
 class Hash {
 public:
-    static byte* md5(const byte* text);
+    enum class Algorithm { MD5, SHA1, SHA256 };
+
+    template <Algorithm A>
+    static constexpr size_t size = A == Algorithm::MD5 ? 16 : A == Algorithm::SHA1 ? 20 : 32;
+
+    template <Algorithm A>
+    using Digest = std::array<byte, size<A>>;
+
+    static Digest<Algorithm::MD5> md5(const byte *data, size_t length);
+
+    static Digest<Algorithm::MD5> md5(std::string_view data);
+
+    static Digest<Algorithm::SHA1> sha1(const byte *data, size_t length);
+
+    static Digest<Algorithm::SHA1> sha1(std::string_view data);
+
+    static Digest<Algorithm::SHA256> sha256(const byte *data, size_t length);
+
+    static Digest<Algorithm::SHA256> sha256(std::string_view data);
+
+    // Incremental digest for payloads that arrive in pieces; not shared between threads.
+    template <Algorithm A>
+    class Stream {
+    public:
+        Stream();
+
+        ~Stream();
+
+        Stream(const Stream &) = delete;
+        Stream &operator=(const Stream &) = delete;
+
+        Stream &update(const byte *data, size_t length);
 
-    static byte* sha1(const byte* text);
+        Stream &update(std::string_view data);
 
-    static byte* sha256(const byte* text);
+        // Returns the digest and starts over.
+        Digest<A> finish();
 
+    private:
+        EVP_MD_CTX *ctx;
+    };
 };
 
-#endif // AUTH_HASH_HPP
\ No newline at end of file
+#endif // AUTH_HASH_HPP
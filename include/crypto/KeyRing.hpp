@@ -0,0 +1,95 @@
+#ifndef INDIEPUB_KEY_RING_HPP
+#define INDIEPUB_KEY_RING_HPP
+
+#include <openssl/evp.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Parsed key pair owned by the KeyRing. EVP_PKEY objects are immutable once loaded and
+// OpenSSL allows any number of threads to create operation contexts from them concurrently.
+class KeyPair {
+public:
+    KeyPair(EVP_PKEY *public_key, EVP_PKEY *private_key);
+
+    ~KeyPair();
+
+    KeyPair(const KeyPair &) = delete;
+    KeyPair &operator=(const KeyPair &) = delete;
+
+    EVP_PKEY *publicKey() const;
+
+    EVP_PKEY *privateKey() const;
+
+    // First 8 bytes of the SHA-256 of the DER public key, in hex; empty without keys.
+    const std::string &id() const;
+
+private:
+    EVP_PKEY *public_key;
+    EVP_PKEY *private_key;
+    std::string key_id;
+};
+
+// The pairs published under one name: the current pair, which signs and is handed to clients
+// for encryption, and the retired pairs that still decrypt and verify until they are removed.
+class KeySet {
+public:
+    KeySet(std::shared_ptr<const KeyPair> current, std::vector<std::shared_ptr<const KeyPair>> retired);
+
+    const std::shared_ptr<const KeyPair> &current() const;
+
+    // nullptr when no pair carries `id`.
+    std::shared_ptr<const KeyPair> find(const std::string &id) const;
+
+    // Current pair first.
+    const std::vector<std::shared_ptr<const KeyPair>> &all() const;
+
+private:
+    std::vector<std::shared_ptr<const KeyPair>> pairs;
+};
+
+// Process-wide cache of the PEM key pairs under the key archives.
+//
+// `<name>_prv.pem` / `<name>_pub.pem` is the current pair and `<name>.<tag>_prv.pem` /
+// `<name>.<tag>_pub.pem` are retired ones. Readers take the published KeySet without locking;
+// reload() parses the files aside and swaps the new set in, so request threads never wait on disk
+// and keep using the set they started with until they drop it.
+class KeyRing {
+public:
+    static KeyRing &instance();
+
+    // Reads and publishes the set for `name`; either half of a pair may be missing.
+    // Returns the current pair.
+    std::shared_ptr<const KeyPair> load(const std::string &name, const char *password = "");
+
+    // Re-reads `name` from disk. The published set is kept when the new current pair has no
+    // private key while the old one had.
+    bool reload(const std::string &name, const char *password = "");
+
+    // The current pair, reading it from disk only the first time.
+    std::shared_ptr<const KeyPair> get(const std::string &name);
+
+    // The published set, reading it from disk only the first time.
+    std::shared_ptr<const KeySet> keys(const std::string &name);
+
+    void clear();
+
+private:
+    using Sets = std::unordered_map<std::string, std::shared_ptr<const KeySet>>;
+
+    KeyRing();
+
+    static std::shared_ptr<const KeySet> read(const std::string &name, const char *password);
+
+    std::shared_ptr<const KeySet> loadSet(const std::string &name, const char *password);
+
+    void publish(const std::string &name, std::shared_ptr<const KeySet> set);
+
+    // serializes writers only
+    std::mutex mutex;
+    std::shared_ptr<const Sets> sets;
+};
+
+#endif // INDIEPUB_KEY_RING_HPP
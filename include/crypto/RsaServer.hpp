@@ -2,11 +2,18 @@
 #define INDIEPUB_RSA_SERVER_HPP
 
 #include <crypto/AuthCrypto.hpp>
+#include <crypto/KeyRing.hpp>
 #include <memory>
+#include <string>
 
 class RsaServer {
 public:    
     static std::unique_ptr<AuthCrypto> getInstance();
+
+    // The current or a retired backend pair; throws std::runtime_error for an unknown id.
+    static std::unique_ptr<AuthCrypto> getInstance(const std::string &keyId);
+
+    static std::shared_ptr<const KeySet> keys();
 };
 
-#endif // INDIEPUB_RSA_SERVER_HPP
\ No newline at end of file
+#endif // INDIEPUB_RSA_SERVER_HPP
@@ -0,0 +1,36 @@
+#ifndef INDIEPUB_SESSION_CIPHER_HPP
+#define INDIEPUB_SESSION_CIPHER_HPP
+
+#include "config.h"
+#include <string>
+#include <vector>
+
+// AES-256-GCM with a symmetric key agreed once per client session.
+//
+// Sealed messages are iv (12 bytes) || ciphertext || tag (16 bytes). The associated data is
+// authenticated but not encrypted; callers bind it to the session the key belongs to.
+class SessionCipher {
+public:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t IV_SIZE = 12;
+    static constexpr size_t TAG_SIZE = 16;
+
+    // Throws std::invalid_argument unless `length` is KEY_SIZE.
+    SessionCipher(const byte *key, size_t length);
+
+    ~SessionCipher();
+
+    SessionCipher(const SessionCipher &other) = default;
+    SessionCipher &operator=(const SessionCipher &other) = default;
+
+    // Empty on failure.
+    std::string seal(const std::string &plaintext, const std::string &aad = "") const;
+
+    // False when the message is malformed or fails authentication.
+    bool open(const std::string &sealed, std::string &plaintext, const std::string &aad = "") const;
+
+private:
+    std::vector<byte> key;
+};
+
+#endif // INDIEPUB_SESSION_CIPHER_HPP
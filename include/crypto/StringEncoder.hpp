@@ -2,24 +2,51 @@
 #define __STRING_ENCODER_HPP__
 
 #include "config.h"
+#include <cstddef>
 #include <string>
 #include <vector>
 
+// Hex and base64 codecs. The buffer variants write into caller storage and never allocate;
+// the string/vector variants size their result once and use them. x86-64 builds pick an
+// AVX2 or SSE4.1 kernel at startup when the CPU has one (INDIEBACK_SIMD=off forces scalar).
 class StringEncoder {
 public:
     static std::vector<byte> stringToBytes(const std::string& str);
 
     static std::string bytesToString(const byte* bytes, size_t length);
 
+    // Single line, padded, no trailing newline.
     static std::string base64Encode(const byte* bytes, size_t length);
 
+    // Accepts padded or unpadded input and skips line breaks; empty on malformed input.
     static std::vector<byte> base64Decode(const std::string& encodedData);
 
     static std::string bytesToHex(const byte* bytes, size_t length);
 
+    // Throws std::invalid_argument on odd length or non-hex characters.
     static std::vector<byte> hexToBytes(const std::string &hexStr);
 
     static unsigned long long hexToInteger(const std::string& hexStr);
+
+    // Writes 2 * length lowercase characters.
+    static void hexEncode(const byte* bytes, size_t length, char* out);
+
+    // Writes length / 2 bytes; false on odd length or non-hex characters.
+    static bool hexDecode(const char* hex, size_t length, byte* out);
+
+    static size_t base64EncodedSize(size_t length);
+
+    // Writes base64EncodedSize(length) characters and returns that count.
+    static size_t base64Encode(const byte* bytes, size_t length, char* out);
+
+    // Room the decoder may need for `length` input characters.
+    static size_t base64DecodedMaxSize(size_t length);
+
+    // Returns the number of bytes written, or SIZE_MAX on malformed input.
+    static size_t base64Decode(const char* text, size_t length, byte* out);
+
+    // "avx2", "sse4.1" or "scalar".
+    static const char* simdLevel();
 };
 
-#endif // __STRING_ENCODER_HPP__
\ No newline at end of file
+#endif // __STRING_ENCODER_HPP__
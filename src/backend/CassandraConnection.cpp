@@ -3,6 +3,25 @@
 #include <iostream>
 #include <string>
 
+namespace
+{
+    using ResultPromise = indiepub::Promise<std::shared_ptr<const CassResult>>;
+
+    void onQueryDone(CassFuture* future, void* data)
+    {
+        std::unique_ptr<ResultPromise> promise(static_cast<ResultPromise*>(data));
+        if (cass_future_error_code(future) == CASS_OK) {
+            promise->set(std::shared_ptr<const CassResult>(cass_future_get_result(future), cass_result_free));
+        } else {
+            const char* message;
+            size_t message_length;
+            cass_future_error_message(future, &message, &message_length);
+            promise->fail(std::make_exception_ptr(
+                std::runtime_error("Query execution failed: " + std::string(message, message_length))));
+        }
+    }
+}
+
 CassandraConnection::CassandraConnection(const std::string &contact_points,
                                          const std::string &username,
                                          const std::string &password)
@@ -66,4 +85,20 @@ void CassandraConnection::executeQuery(const std::string &query)
     }
     cass_statement_free(statement);
     cass_future_free(query_future);
-}
\ No newline at end of file
+}
+
+indiepub::Async<std::shared_ptr<const CassResult>> CassandraConnection::executeAsync(CassStatement* statement)
+{
+    ResultPromise promise;
+    indiepub::Async<std::shared_ptr<const CassResult>> result = promise.async();
+    CassFuture* query_future = cass_session_execute(session, statement);
+    cass_statement_free(statement);
+    auto* pending = new ResultPromise(promise);
+    if (cass_future_set_callback(query_future, onQueryDone, pending) != CASS_OK) {
+        delete pending;
+        promise.fail(std::make_exception_ptr(std::runtime_error("Unable to register query callback")));
+    }
+    // the driver keeps the future alive until the callback has run
+    cass_future_free(query_future);
+    return result;
+}
@@ -0,0 +1,50 @@
+#include <backend/Environment.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace
+{
+    std::invalid_argument invalid(const char *name, const std::string &value, const std::string &expected)
+    {
+        return std::invalid_argument(std::string(name) + "=" + value + ": expected " + expected);
+    }
+}
+
+std::string indiepub::env::text(const char *name, const std::string &fallback)
+{
+    const char *value = std::getenv(name);
+    return (value == nullptr || *value == '\0') ? fallback : std::string(value);
+}
+
+bool indiepub::env::flag(const char *name, bool fallback)
+{
+    std::string value = text(name, fallback ? "1" : "0");
+    if (value == "1" || value == "true" || value == "on" || value == "yes")
+        return true;
+    if (value == "0" || value == "false" || value == "off" || value == "no")
+        return false;
+    throw invalid(name, value, "on or off");
+}
+
+long long indiepub::env::number(const char *name, long long fallback, long long min, long long max)
+{
+    std::string value = text(name, std::to_string(fallback));
+    char *end = nullptr;
+    errno = 0;
+    long long parsed = std::strtoll(value.c_str(), &end, 10);
+    if (end == value.c_str() || *end != '\0' || errno == ERANGE || parsed < min || parsed > max)
+        throw invalid(name, value, "a whole number from " + std::to_string(min) +
+                                       (max == std::numeric_limits<long long>::max() ? " up" : " to " + std::to_string(max)));
+    return parsed;
+}
+
+std::chrono::milliseconds indiepub::env::milliseconds(const char *name, long long fallback)
+{
+    return std::chrono::milliseconds(number(name, fallback));
+}
+
+std::chrono::seconds indiepub::env::seconds(const char *name, long long fallback)
+{
+    return std::chrono::seconds(number(name, fallback));
+}
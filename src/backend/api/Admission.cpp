@@ -0,0 +1,254 @@
+#include <backend/api/Admission.hpp>
+#include <backend/Environment.hpp>
+#include <http/Status.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    // class indexes, highest priority first
+    constexpr std::array<indiepub::RouteClass, indiepub::Admission::CLASSES> PRIORITY = {
+        indiepub::RouteClass::ADMIN, indiepub::RouteClass::WRITE, indiepub::RouteClass::AUTH, indiepub::RouteClass::READ};
+
+    size_t indexOf(indiepub::RouteClass routeClass)
+    {
+        return static_cast<size_t>(routeClass);
+    }
+
+    indiepub::Admission::Limits limits(const std::string &prefix, const indiepub::Admission::Limits &fallback)
+    {
+        indiepub::Admission::Limits limits;
+        limits.concurrency = static_cast<size_t>(indiepub::env::number((prefix + "_LIMIT").c_str(), fallback.concurrency));
+        limits.queue = static_cast<size_t>(indiepub::env::number((prefix + "_QUEUE").c_str(), fallback.queue));
+        limits.deadline = indiepub::env::milliseconds((prefix + "_DEADLINE").c_str(), fallback.deadline.count());
+        return limits;
+    }
+
+    std::optional<indiepub::Admission::Options> configured;
+    std::atomic<bool> built{false};
+}
+
+indiepub::Admission::Options indiepub::Admission::Options::defaults(size_t workers)
+{
+    using std::chrono::milliseconds;
+    Options options;
+    options.limit = limitFor(workers);
+    options.classes[indexOf(RouteClass::AUTH)] = {ADMISSION_AUTH_LIMIT, ADMISSION_QUEUE_SIZE, milliseconds(ADMISSION_AUTH_DEADLINE)};
+    options.classes[indexOf(RouteClass::READ)] = {ADMISSION_READ_LIMIT, ADMISSION_QUEUE_SIZE, milliseconds(ADMISSION_READ_DEADLINE)};
+    options.classes[indexOf(RouteClass::WRITE)] = {ADMISSION_WRITE_LIMIT, ADMISSION_QUEUE_SIZE, milliseconds(ADMISSION_WRITE_DEADLINE)};
+    options.classes[indexOf(RouteClass::ADMIN)] = {ADMISSION_ADMIN_LIMIT, ADMISSION_QUEUE_SIZE, milliseconds(ADMISSION_ADMIN_DEADLINE)};
+    options.retry_after = std::chrono::seconds(ADMISSION_RETRY_AFTER);
+    return options;
+}
+
+indiepub::Admission::Options indiepub::Admission::Options::fromEnvironment(size_t workers)
+{
+    Options options = defaults(workers);
+    options.limit = static_cast<size_t>(env::number("INDIEBACK_ADMISSION_LIMIT", options.limit));
+    for (auto &[routeClass, prefix] : {std::pair{RouteClass::AUTH, "INDIEBACK_ADMISSION_AUTH"}, {RouteClass::READ, "INDIEBACK_ADMISSION_READ"},
+                                       {RouteClass::WRITE, "INDIEBACK_ADMISSION_WRITE"}, {RouteClass::ADMIN, "INDIEBACK_ADMISSION_ADMIN"}})
+        options.classes[indexOf(routeClass)] = limits(prefix, options.classes[indexOf(routeClass)]);
+    options.retry_after = env::seconds("INDIEBACK_ADMISSION_RETRY_AFTER", options.retry_after.count());
+    return options;
+}
+
+indiepub::Admission::Admission(const Options &options) : options_(options)
+{
+    std::ostringstream summary;
+    for (RouteClass routeClass : PRIORITY)
+    {
+        const Limits &limits = options_.classes[indexOf(routeClass)];
+        summary << " " << name(routeClass) << "=" << limits.concurrency << "/" << limits.queue << "/" << limits.deadline.count() << "ms";
+    }
+    LOG_INFO << "Admission limit " << options_.limit << ", running/queued/deadline per class:" << summary.str();
+}
+
+void indiepub::Admission::configure(const Options &options)
+{
+    if (built.load())
+        throw std::logic_error("Admission is configured after its first use");
+    configured = options;
+}
+
+indiepub::Admission &indiepub::Admission::instance()
+{
+    static Admission *admission = []() {
+        built = true;
+        return new Admission(configured.value_or(Options::defaults(HTTP_LISTENERS * HTTP_WORKERS)));
+    }();
+    return *admission;
+}
+
+const char *indiepub::Admission::name(RouteClass routeClass)
+{
+    switch (routeClass)
+    {
+    case RouteClass::AUTH:
+        return "auth";
+    case RouteClass::READ:
+        return "read";
+    case RouteClass::WRITE:
+        return "write";
+    default:
+        return "admin";
+    }
+}
+
+size_t indiepub::Admission::limitFor(size_t workers)
+{
+    return std::max<size_t>(workers * ADMISSION_WORKER_PERCENT / 100, 1);
+}
+
+bool indiepub::Admission::runnable(size_t index) const
+{
+    if (running_[index] >= options_.classes[index].concurrency || total_ >= options_.limit)
+        return false;
+    // a waiting class of higher priority that only lacks a shared slot goes first
+    for (RouteClass routeClass : PRIORITY)
+    {
+        size_t other = indexOf(routeClass);
+        if (other == index)
+            return true;
+        if (waiting_[other] > 0 && running_[other] < options_.classes[other].concurrency)
+            return false;
+    }
+    return true;
+}
+
+bool indiepub::Admission::admit(RouteClass routeClass)
+{
+    size_t index = indexOf(routeClass);
+    const Limits &limits = options_.classes[index];
+    Clock::time_point arrived = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!runnable(index))
+    {
+        if (waiting_[index] >= limits.queue)
+        {
+            counters_[index].shed_full.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ++waiting_[index];
+        bool admitted = ready_[index].wait_until(lock, arrived + limits.deadline, [this, index]() { return runnable(index); });
+        --waiting_[index];
+        if (!admitted)
+        {
+            counters_[index].shed_deadline.fetch_add(1, std::memory_order_relaxed);
+            // classes below may have been holding back for this one
+            for (size_t other = 0; other < CLASSES; ++other)
+            {
+                if (waiting_[other] > 0)
+                    ready_[other].notify_all();
+            }
+            return false;
+        }
+    }
+    ++running_[index];
+    ++total_;
+    lock.unlock();
+    record(index, Clock::now() - arrived);
+    return true;
+}
+
+void indiepub::Admission::release(RouteClass routeClass)
+{
+    size_t index = indexOf(routeClass);
+    std::lock_guard<std::mutex> lock(mutex_);
+    --running_[index];
+    --total_;
+    // runnable() hands the slot to the highest waiting class; the others go back to sleep
+    for (size_t other = 0; other < CLASSES; ++other)
+    {
+        if (waiting_[other] > 0)
+            ready_[other].notify_all();
+    }
+}
+
+bool indiepub::Admission::admit(RequestContext &context, HttpResponse &response)
+{
+    RouteClass routeClass = context.meta().route_class;
+    if (admit(routeClass))
+    {
+        context.defer([this, routeClass]() { release(routeClass); });
+        return true;
+    }
+    LOG_WARN << "Shedding " << name(routeClass) << " request";
+    response.setStatus(CODES::SERVICE_UNAVAILABLE);
+    response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+    response.setHeader("Retry-After", std::to_string(options_.retry_after.count()));
+    response.setBody("{\"error\": \"server busy, retry later\"}");
+    return false;
+}
+
+void indiepub::Admission::record(size_t index, Clock::duration wait)
+{
+    Counters &counters = counters_[index];
+    counters.admitted.fetch_add(1, std::memory_order_relaxed);
+    counters.wait_us.fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(wait).count()),
+                               std::memory_order_relaxed);
+    double seconds = std::chrono::duration<double>(wait).count();
+    for (size_t i = 0; i < WAIT_BUCKETS.size(); ++i)
+    {
+        if (seconds <= WAIT_BUCKETS[i])
+        {
+            counters.buckets[i].fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+std::string indiepub::Admission::exposition() const
+{
+    std::array<size_t, CLASSES> running;
+    std::array<size_t, CLASSES> waiting;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running = running_;
+        waiting = waiting_;
+    }
+    std::ostringstream out;
+    out << "# TYPE indieback_admission_running gauge\n";
+    for (RouteClass routeClass : PRIORITY)
+        out << "indieback_admission_running{class=\"" << name(routeClass) << "\"} " << running[indexOf(routeClass)] << "\n";
+    out << "# TYPE indieback_admission_queued gauge\n";
+    for (RouteClass routeClass : PRIORITY)
+        out << "indieback_admission_queued{class=\"" << name(routeClass) << "\"} " << waiting[indexOf(routeClass)] << "\n";
+    out << "# TYPE indieback_admission_shed_total counter\n";
+    for (RouteClass routeClass : PRIORITY)
+    {
+        const Counters &counters = counters_[indexOf(routeClass)];
+        out << "indieback_admission_shed_total{class=\"" << name(routeClass) << "\",reason=\"queue_full\"} "
+            << counters.shed_full.load(std::memory_order_relaxed) << "\n";
+        out << "indieback_admission_shed_total{class=\"" << name(routeClass) << "\",reason=\"deadline\"} "
+            << counters.shed_deadline.load(std::memory_order_relaxed) << "\n";
+    }
+
+    // buckets are stored per range; the exposition wants them cumulative
+    out << "# TYPE indieback_admission_wait_seconds histogram\n";
+    for (RouteClass routeClass : PRIORITY)
+    {
+        const Counters &counters = counters_[indexOf(routeClass)];
+        std::string label = std::string("class=\"") + name(routeClass) + "\"";
+        std::uint64_t cumulative = 0;
+        std::uint64_t count = counters.admitted.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < WAIT_BUCKETS.size(); ++i)
+        {
+            cumulative += counters.buckets[i].load(std::memory_order_relaxed);
+            out << "indieback_admission_wait_seconds_bucket{" << label << ",le=\"" << WAIT_BUCKETS[i] << "\"} " << cumulative << "\n";
+        }
+        out << "indieback_admission_wait_seconds_bucket{" << label << ",le=\"+Inf\"} " << count << "\n";
+        out << "indieback_admission_wait_seconds_sum{" << label << "} " << counters.wait_us.load(std::memory_order_relaxed) / 1e6 << "\n";
+        out << "indieback_admission_wait_seconds_count{" << label << "} " << count << "\n";
+    }
+    return out.str();
+}
+
+const indiepub::Admission::Options &indiepub::Admission::options() const
+{
+    return options_;
+}
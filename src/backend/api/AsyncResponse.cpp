@@ -0,0 +1,95 @@
+#include <backend/api/AsyncResponse.hpp>
+#include <http/Status.hpp>
+#include <util/logging/Log.hpp>
+
+namespace
+{
+    constexpr int GATEWAY_TIMEOUT = 504;
+}
+
+indiepub::AsyncResponse::AsyncResponse() : state_(std::make_shared<State>())
+{
+}
+
+void indiepub::AsyncResponse::setHeader(const std::string &name, const std::string &value)
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->done)
+        state_->headers.emplace_back(name, value);
+}
+
+bool indiepub::AsyncResponse::complete(int status, const std::string &body)
+{
+    return complete(status, Status(status).ss.str(), body);
+}
+
+bool indiepub::AsyncResponse::complete(const HttpResponse &response)
+{
+    return complete(response.getStatus(), response.getStatusMsg(), response.getBody());
+}
+
+bool indiepub::AsyncResponse::complete(int status, const std::string &statusMsg, const std::string &body)
+{
+    std::vector<std::function<void()>> after;
+    bool late = false;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->completed)
+            return false;
+        state_->completed = true;
+        after.swap(state_->after);
+        late = state_->done;
+        if (!late)
+        {
+            state_->done = true;
+            state_->status = status;
+            state_->status_msg = statusMsg;
+            state_->body = body;
+        }
+    }
+    if (!late)
+        state_->ready.notify_all();
+    for (auto &done : after)
+        done();
+    return !late;
+}
+
+void indiepub::AsyncResponse::whenComplete(std::function<void()> done)
+{
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->completed)
+        {
+            state_->after.push_back(std::move(done));
+            return;
+        }
+    }
+    done();
+}
+
+bool indiepub::AsyncResponse::completed() const
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->done;
+}
+
+bool indiepub::AsyncResponse::deliver(HttpResponse &response, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    bool inTime = state_->ready.wait_for(lock, timeout, [this]() { return state_->done; });
+    if (!inTime)
+    {
+        state_->done = true;
+        state_->status = GATEWAY_TIMEOUT;
+        state_->status_msg = Status(GATEWAY_TIMEOUT).ss.str();
+        state_->body = "{\"error\":\"Request timed out\"}";
+        state_->headers.clear();
+        LOG_WARN << "Asynchronous handler did not complete within " << timeout.count() << " ms";
+    }
+    response.setStatus(state_->status);
+    response.setStatusMsg(state_->status_msg);
+    for (const auto &header : state_->headers)
+        response.setHeader(header.first, header.second);
+    response.setBody(state_->body);
+    return inTime;
+}
@@ -0,0 +1,186 @@
+#include <backend/api/Compression.hpp>
+#include <backend/Environment.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+
+namespace
+{
+    std::string_view trim(std::string_view value)
+    {
+        size_t start = value.find_first_not_of(" \t");
+        if (start == std::string_view::npos)
+            return std::string_view();
+        return value.substr(start, value.find_last_not_of(" \t") - start + 1);
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                   return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+               });
+    }
+
+    // 1 without a q parameter; a malformed q reads as 0.
+    double quality(std::string_view parameters)
+    {
+        size_t q = parameters.find("q=");
+        if (q == std::string_view::npos)
+            return 1.0;
+        std::string value(trim(parameters.substr(q + 2)));
+        char *end = nullptr;
+        double parsed = std::strtod(value.c_str(), &end);
+        return end == value.c_str() ? 0.0 : parsed;
+    }
+
+    std::optional<indiepub::Compression::Options> configured;
+    std::atomic<bool> built{false};
+}
+
+indiepub::Compression::Options indiepub::Compression::Options::defaults()
+{
+    return Options{HTTP_COMPRESSION_LEVEL, HTTP_COMPRESSION_MIN_SIZE};
+}
+
+indiepub::Compression::Options indiepub::Compression::Options::fromEnvironment()
+{
+    Options options = defaults();
+    options.level = static_cast<int>(env::number("INDIEBACK_HTTP_COMPRESSION_LEVEL", options.level, 0, 9));
+    options.min_size = static_cast<size_t>(env::number("INDIEBACK_HTTP_COMPRESSION_MIN_SIZE", options.min_size));
+    return options;
+}
+
+indiepub::Compression::Compression(const Options &options) : options_(options)
+{
+    options_.level = std::clamp(options_.level, 0, 9);
+}
+
+void indiepub::Compression::configure(const Options &options)
+{
+    if (built.load())
+        throw std::logic_error("Compression is configured after its first use");
+    configured = options;
+}
+
+const indiepub::Compression &indiepub::Compression::instance()
+{
+    static Compression *compression = []() {
+        built = true;
+        return new Compression(configured.value_or(Options::defaults()));
+    }();
+    return *compression;
+}
+
+indiepub::ContentEncoding indiepub::Compression::negotiate(std::string_view acceptEncoding)
+{
+    // -1 while a coding is not named
+    double gzip = -1.0;
+    double deflate = -1.0;
+    double any = -1.0;
+    while (!acceptEncoding.empty())
+    {
+        size_t comma = acceptEncoding.find(',');
+        std::string_view item = acceptEncoding.substr(0, comma);
+        acceptEncoding = comma == std::string_view::npos ? std::string_view() : acceptEncoding.substr(comma + 1);
+        size_t semicolon = item.find(';');
+        std::string_view coding = trim(item.substr(0, semicolon));
+        double q = semicolon == std::string_view::npos ? 1.0 : quality(item.substr(semicolon + 1));
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip"))
+            gzip = q;
+        else if (equalsIgnoreCase(coding, "deflate"))
+            deflate = q;
+        else if (coding == "*")
+            any = q;
+    }
+    // `*` only stands for the codings not named
+    if (gzip < 0.0)
+        gzip = any;
+    if (deflate < 0.0)
+        deflate = any;
+    if (gzip <= 0.0 && deflate <= 0.0)
+        return ContentEncoding::IDENTITY;
+    // gzip on a tie: some clients mishandle raw deflate
+    return gzip >= deflate ? ContentEncoding::GZIP : ContentEncoding::DEFLATE;
+}
+
+const char *indiepub::Compression::name(ContentEncoding encoding)
+{
+    switch (encoding)
+    {
+    case ContentEncoding::GZIP:
+        return "gzip";
+    case ContentEncoding::DEFLATE:
+        return "deflate";
+    default:
+        return "identity";
+    }
+}
+
+std::string indiepub::Compression::compress(std::string_view data, ContentEncoding encoding, int level)
+{
+    if (encoding == ContentEncoding::IDENTITY)
+        return std::string(data);
+    z_stream stream{};
+    // 16 added to the window bits selects the gzip wrapper instead of zlib's
+    int windowBits = encoding == ContentEncoding::GZIP ? 15 + 16 : 15;
+    if (deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return std::string();
+    std::string out(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END ? out : std::string();
+}
+
+indiepub::ContentEncoding indiepub::Compression::choose(const RequestContext &context) const
+{
+    if (options_.level == 0)
+        return ContentEncoding::IDENTITY;
+    return negotiate(context.header("accept-encoding"));
+}
+
+std::string indiepub::Compression::compress(std::string_view data, ContentEncoding encoding) const
+{
+    return compress(data, encoding, options_.level);
+}
+
+void indiepub::Compression::apply(const RequestContext &context, HttpResponse &response) const
+{
+    // any answer could have been encoded for another Accept-Encoding, so a shared cache must
+    // key on it even when this one goes out as it is
+    if (options_.level > 0 || context.contentEncoding() != ContentEncoding::IDENTITY)
+        response.setHeader("Vary", "Accept-Encoding");
+    int status = response.getStatus();
+    if (status < 200 || status >= 300)
+        return;
+    ContentEncoding encoding = context.contentEncoding();
+    if (encoding == ContentEncoding::IDENTITY)
+    {
+        encoding = choose(context);
+        if (encoding == ContentEncoding::IDENTITY)
+            return;
+        std::string body = response.getBody();
+        if (body.size() < options_.min_size)
+            return;
+        std::string packed = compress(body, encoding);
+        // already compressed media can grow
+        if (packed.empty() || packed.size() >= body.size())
+            return;
+        response.setBody(packed);
+    }
+    response.setHeader("Content-Encoding", name(encoding));
+}
+
+const indiepub::Compression::Options &indiepub::Compression::options() const
+{
+    return options_;
+}
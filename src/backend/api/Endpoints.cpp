@@ -1,4 +1,7 @@
 #include <backend/api/Endpoints.hpp>
+#include <backend/api/Admission.hpp>
+#include <backend/api/Compression.hpp>
+#include <backend/api/RateLimiter.hpp>
 #include <http/Status.hpp>
 #include <util/logging/Log.hpp>
 #include <JSON.hpp>
@@ -10,6 +13,16 @@
 #include <util/String.hpp>
 #include <config.h>
 #include <backend/IndieBackModels.hpp>
+#include <backend/cache/Caches.hpp>
+#include <backend/cache/CacheBudget.hpp>
+#include <backend/auth/CryptoExecutor.hpp>
+#include <backend/auth/PasswordHasher.hpp>
+#include <backend/auth/SessionKeys.hpp>
+#include <backend/auth/SessionToken.hpp>
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/crypto.h>
+#include <openssl/pem.h>
 #include <ctime>
 
 Endpoints::Endpoints(/* args */)
@@ -20,107 +33,312 @@ Endpoints::~Endpoints()
 {
 }
 
-indiepub::CredentialsController Endpoints::getCredentialsController()
+indiepub::CredentialsController &Endpoints::getCredentialsController()
 {
-    return indiepub::CredentialsController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    static indiepub::CredentialsController *controller = new indiepub::CredentialsController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    return *controller;
 }
 
-indiepub::UsersController Endpoints::getUsersController()
+indiepub::UsersController &Endpoints::getUsersController()
 {
-    return indiepub::UsersController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    static indiepub::UsersController *controller = new indiepub::UsersController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    return *controller;
 }
 
-indiepub::EventController Endpoints::getEventController()
+indiepub::EventController &Endpoints::getEventController()
 {
-    return indiepub::EventController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    static indiepub::EventController *controller = new indiepub::EventController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    return *controller;
 }
 
-indiepub::VenuesController Endpoints::getVenuesController()
+indiepub::VenuesController &Endpoints::getVenuesController()
 {
-    return indiepub::VenuesController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    static indiepub::VenuesController *controller = new indiepub::VenuesController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    return *controller;
 }
 
-indiepub::VenueMembersController Endpoints::getVenueMembersController()
+indiepub::VenueMembersController &Endpoints::getVenueMembersController()
 {
-    return indiepub::VenueMembersController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    static indiepub::VenueMembersController *controller = new indiepub::VenueMembersController(CASS_CP, CASS_UN, CASS_PW, CASS_KS);
+    return *controller;
 }
 
-bool Endpoints::validateTokenAndId(const HttpRequest &request, HttpResponse &response, Path *path, indiepub::Credentials &creds, indiepub::User &user)
+std::optional<indiepub::Credentials> Endpoints::loadCredentials(const std::string &token)
 {
-    auto headers = request.getHeaders();
-    std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
-    if (headers.find("authorization") == headers.end())
+    indiepub::Credentials loaded = getCredentialsController().getCredentialsByAuthToken(token);
+    if (loaded.auth_token().empty())
+        return std::nullopt;
+    return loaded;
+}
+
+std::optional<indiepub::User> Endpoints::loadUser(const std::string &user_id)
+{
+    indiepub::User loaded = getUsersController().getUserById(user_id);
+    if (loaded.user_id().empty())
+        return std::nullopt;
+    return loaded;
+}
+
+std::optional<indiepub::Venue> Endpoints::loadVenue(const std::string &venue_id)
+{
+    indiepub::Venue loaded = getVenuesController().getVenueById(venue_id);
+    if (loaded.venue_id().empty())
+        return std::nullopt;
+    return loaded;
+}
+
+std::optional<std::vector<indiepub::EventByVenue>> Endpoints::loadEvents(const std::string &window)
+{
+    if (window == "week")
+        return getEventController().getOneWeekEvents(time(nullptr));
+    return getEventController().getAllEvents();
+}
+
+indiepub::Credentials Endpoints::findCredentialsByToken(const std::string &token)
+{
+    if (indiepub::SessionToken::isSessionToken(token))
     {
-        response.setStatus(CODES::UNAUTHORIZED);
-        response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-        body->put("error", "Token not provided");
-        response.setBody(body->c_str());
-        return false;
+        indiepub::SessionToken::Claims claims;
+        if (!indiepub::SessionToken::instance().verify(token, claims))
+            return indiepub::Credentials();
+        return indiepub::Credentials(claims.user_id, token, "");
     }
-    else
+    auto creds = indiepub::Caches::auth().getOrLoad(token, [&token]() { return loadCredentials(token); });
+    return creds ? *creds : indiepub::Credentials();
+}
+
+indiepub::User Endpoints::findUserById(const std::string &user_id)
+{
+    auto user = indiepub::Caches::users().getOrLoad(user_id, [&user_id]() { return loadUser(user_id); });
+    return user ? *user : indiepub::User();
+}
+
+indiepub::Venue Endpoints::findVenueById(const std::string &venue_id)
+{
+    auto venue = indiepub::Caches::venues().getOrLoad(venue_id, [&venue_id]() { return loadVenue(venue_id); });
+    return venue ? *venue : indiepub::Venue();
+}
+
+std::vector<indiepub::EventByVenue> Endpoints::findEvents(bool upcomingOnly)
+{
+    // the one-week window moves with the clock, so that entry relies on the catalog TTL
+    std::string window = upcomingOnly ? "week" : "all";
+    auto events = indiepub::Caches::eventCatalog().getOrLoad(window, [&window]() { return loadEvents(window); });
+    return events ? *events : std::vector<indiepub::EventByVenue>();
+}
+
+indiepub::Async<std::optional<indiepub::Credentials>> Endpoints::loadCredentialsAsync(const std::string &token)
+{
+    return getCredentialsController().getCredentialsByAuthTokenAsync(token).then([](const indiepub::Credentials &loaded) {
+        return loaded.auth_token().empty() ? std::nullopt : std::optional<indiepub::Credentials>(loaded);
+    });
+}
+
+indiepub::Async<std::optional<indiepub::User>> Endpoints::loadUserAsync(const std::string &user_id)
+{
+    return getUsersController().getUserByIdAsync(user_id).then([](const indiepub::User &loaded) {
+        return loaded.user_id().empty() ? std::nullopt : std::optional<indiepub::User>(loaded);
+    });
+}
+
+indiepub::Async<std::optional<indiepub::Venue>> Endpoints::loadVenueAsync(const std::string &venue_id)
+{
+    return getVenuesController().getVenueByIdAsync(venue_id).then([](const indiepub::Venue &loaded) {
+        return loaded.venue_id().empty() ? std::nullopt : std::optional<indiepub::Venue>(loaded);
+    });
+}
+
+indiepub::Async<std::optional<std::vector<indiepub::EventByVenue>>> Endpoints::loadEventsAsync(const std::string &window)
+{
+    auto events = window == "week" ? getEventController().getOneWeekEventsAsync(time(nullptr)) : getEventController().getAllEventsAsync();
+    return events.then([](const std::vector<indiepub::EventByVenue> &loaded) {
+        return std::optional<std::vector<indiepub::EventByVenue>>(loaded);
+    });
+}
+
+indiepub::Async<std::optional<std::string>> Endpoints::loadFeedAsync(const std::string &key)
+{
+    size_t colon = key.find(':');
+    if (colon == std::string::npos)
     {
-        std::string auth = headers["authorization"];
-        if (auth.empty() || auth.find("Bearer ") != 0)
-        {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "Invalid token format");
-            response.setBody(body->c_str());
-            return false;
-        }
-        std::string token = auth.substr(7); // Remove "Bearer " prefix
-        if (token[token.size()-1] == '\r' || token[token.size()-1] == '\n')
-            token = token.substr(0, token.size()-1);
-        creds = getCredentialsController().getCredentialsByAuthToken(token);
-        if (creds.auth_token().empty())
-        {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "Invalid token");
-            response.setBody(body->c_str());
-            return false;
-        }
-        std::string xuserId = headers["x-user-id"];
-        if(xuserId[xuserId.size()-1] == '\r' || xuserId[xuserId.size()-1] == '\n') 
-        {
-            xuserId = xuserId.substr(0, xuserId.size() - 1);
-        }
-        if (xuserId.empty()) {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "User ID not provided");
-            response.setBody(body->c_str());
-            return false;
-        }
-        if (xuserId != creds.user_id())
-        {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "User ID does not match token");
-            response.setBody(body->c_str());
-            return false;
-        }
-        user = getUsersController().getUserById(creds.user_id());
-        if (user.user_id().empty())
-        {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "User not found");
-            response.setBody(body->c_str());
-            return false;
-        }
+        return indiepub::start(renderFeed(key)).then([](const std::string &feed) {
+            return std::optional<std::string>(feed);
+        });
     }
-    return true;
+    // encoded once from the plain body, which is cached as well
+    indiepub::ContentEncoding encoding = key.compare(colon + 1, std::string::npos, "gzip") == 0 ? indiepub::ContentEncoding::GZIP : indiepub::ContentEncoding::DEFLATE;
+    return indiepub::start(findFeedAsync(key.substr(0, colon))).then([encoding](const std::string &feed) {
+        std::string packed = feed.empty() ? std::string() : indiepub::Compression::instance().compress(feed, encoding);
+        return packed.empty() ? std::optional<std::string>() : std::optional<std::string>(packed);
+    });
 }
 
-std::string Endpoints::hashing(std::string &password)
+indiepub::Task<indiepub::Credentials> Endpoints::findCredentialsByTokenAsync(std::string token)
+{
+    if (indiepub::SessionToken::isSessionToken(token))
+    {
+        indiepub::SessionToken::Claims claims;
+        if (!indiepub::SessionToken::instance().verify(token, claims))
+            co_return indiepub::Credentials();
+        co_return indiepub::Credentials(claims.user_id, token, "");
+    }
+    try
+    {
+        auto creds = co_await indiepub::Caches::auth().getOrLoadAsync(token, [&token]() { return loadCredentialsAsync(token); });
+        co_return creds ? *creds : indiepub::Credentials();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+    }
+    co_return indiepub::Credentials();
+}
+
+indiepub::Task<indiepub::User> Endpoints::findUserByIdAsync(std::string user_id)
+{
+    try
+    {
+        auto user = co_await indiepub::Caches::users().getOrLoadAsync(user_id, [&user_id]() { return loadUserAsync(user_id); });
+        co_return user ? *user : indiepub::User();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+    }
+    co_return indiepub::User();
+}
+
+indiepub::Task<indiepub::Venue> Endpoints::findVenueByIdAsync(std::string venue_id)
+{
+    try
+    {
+        auto venue = co_await indiepub::Caches::venues().getOrLoadAsync(venue_id, [&venue_id]() { return loadVenueAsync(venue_id); });
+        co_return venue ? *venue : indiepub::Venue();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+    }
+    co_return indiepub::Venue();
+}
+
+indiepub::Task<std::vector<indiepub::EventByVenue>> Endpoints::findEventsAsync(bool upcomingOnly)
+{
+    std::string window = upcomingOnly ? "week" : "all";
+    try
+    {
+        auto events = co_await indiepub::Caches::eventCatalog().getOrLoadAsync(window, [&window]() { return loadEventsAsync(window); });
+        co_return events ? *events : std::vector<indiepub::EventByVenue>();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+    }
+    co_return std::vector<indiepub::EventByVenue>();
+}
+
+indiepub::Task<std::string> Endpoints::findFeedAsync(std::string key)
+{
+    try
+    {
+        auto feed = co_await indiepub::Caches::eventFeeds().getOrLoadAsync(key, [&key]() { return loadFeedAsync(key); });
+        co_return feed ? *feed : std::string();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+    }
+    co_return std::string();
+}
+
+void Endpoints::revalidateCaches(const indiepub::Caches::Restored &restored)
+{
+    for (const auto &token : restored.auth)
+        indiepub::Caches::auth().refresh(token, [&token]() { return loadCredentials(token); });
+    for (const auto &venue_id : restored.venues)
+        indiepub::Caches::venues().refresh(venue_id, [&venue_id]() { return loadVenue(venue_id); });
+    for (const auto &window : restored.events)
+        indiepub::Caches::eventCatalog().refresh(window, [&window]() { return loadEvents(window); });
+}
+
+bool Endpoints::unauthorized(HttpResponse &response, const std::string &error)
+{
+    std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
+    body->put("error", error);
+    response.setStatus(CODES::UNAUTHORIZED);
+    response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
+    response.setBody(body->c_str());
+    return false;
+}
+
+bool Endpoints::authenticate(indiepub::RequestContext &context, HttpResponse &response)
+{
+    // admin routes carry the admin token, which is no user's
+    if (context.meta().route_class == indiepub::RouteClass::ADMIN)
+        return true;
+    if (!context.meta().auth_required && !context.hasHeader("authorization"))
+        return true;
+    // Blocks this HTTP worker only on a cache miss; with the token and user cached the task has
+    // already completed inline. It cannot give up early: the task writes into `context`.
+    std::string error = indiepub::start(authenticateAsync(context)).get();
+    if (error.empty() || !context.meta().auth_required)
+        return true;
+    return unauthorized(response, error);
+}
+
+std::string &Endpoints::adminToken()
+{
+    static std::string token;
+    return token;
+}
+
+void Endpoints::configureAdmin(const std::string &token)
+{
+    if (!token.empty() && token.size() < ADMIN_TOKEN_MIN_LENGTH)
+        throw std::invalid_argument("INDIEBACK_ADMIN_TOKEN must be at least " + std::to_string(ADMIN_TOKEN_MIN_LENGTH) + " characters");
+    if (token.empty())
+        LOG_WARN << "INDIEBACK_ADMIN_TOKEN is not set: admin routes are closed";
+    adminToken() = token;
+}
+
+bool Endpoints::authorizeAdmin(indiepub::RequestContext &context, HttpResponse &response)
 {
-    std::vector<byte> pwEnc = StringEncoder::stringToBytes(password);
-    byte *md = nullptr;
+    if (context.meta().route_class != indiepub::RouteClass::ADMIN)
+        return true;
+    const std::string &token = adminToken();
+    std::string_view presented = context.bearerToken();
+    if (!token.empty() && presented.size() == token.size() && CRYPTO_memcmp(presented.data(), token.data(), token.size()) == 0)
+        return true;
+    LOG_WARN << "Refused an admin request" << (token.empty() ? ": INDIEBACK_ADMIN_TOKEN is not set" : "");
+    return unauthorized(response, "Admin token required");
+}
 
-    std::string hash = StringEncoder::bytesToHex(Hash::sha256(pwEnc.data()), pwEnc.size());
-    delete[] md;
-    return hash;
+indiepub::Task<std::string> Endpoints::authenticateAsync(indiepub::RequestContext &context)
+{
+    if (!context.hasHeader("authorization"))
+        co_return "Token not provided";
+    if (context.bearerToken().empty())
+        co_return "Invalid token format";
+    std::string xuserId(context.userId());
+    // the user is read only for a verified token, so an unauthenticated caller cannot make the
+    // server load arbitrary user rows
+    indiepub::Credentials creds = co_await findCredentialsByTokenAsync(std::string(context.bearerToken()));
+    if (creds.auth_token().empty())
+        co_return "Invalid token";
+    if (xuserId.empty())
+        co_return "User ID not provided";
+    if (xuserId != creds.user_id())
+        co_return "User ID does not match token";
+    indiepub::User user = co_await findUserByIdAsync(xuserId);
+    if (user.user_id().empty())
+        co_return "User not found";
+    context.authenticate(std::move(creds), std::move(user));
+    co_return "";
+}
+
+std::string Endpoints::hashing(std::string &password)
+{
+    return indiepub::PasswordHasher::legacyHash(password);
 }
 
 std::string Endpoints::tokenGenerator(std::string &pwHash)
@@ -173,132 +391,358 @@ bool Endpoints::isValidPassword(const std::string &password)
     return password.length() >= 10;
 }
 
-std::string Endpoints::decryptMessage(const std::string &value)
+std::string Endpoints::rsaDecrypt(const std::string &value, const std::string &keyId)
 {
-    try
+    std::vector<std::string> ids;
+    if (!keyId.empty())
+    {
+        ids.push_back(keyId);
+    }
+    else
+    {
+        // clients from before the rotation send no key id; they encrypted to whichever key
+        // they fetched, current first
+        for (const auto &pair : RsaServer::keys()->all())
+            ids.push_back(pair->id());
+    }
+    // with implicit rejection a decrypt under the wrong key returns random bytes rather than
+    // failing, so it is only turned off where keys are tried in turn
+    bool explicitRejection = ids.size() > 1;
+    std::vector<byte> encryptedData = StringEncoder::base64Decode(value.c_str());
+    for (const auto &id : ids)
     {
-        std::string result = "";
-        std::vector<byte> encryptedData = StringEncoder::base64Decode(value.c_str());
         byte *decryptedData = nullptr;
-        size_t decryptedLen = RsaServer::getInstance()->decrypt(encryptedData.data(), encryptedData.size(), decryptedData);
+        size_t decryptedLen = RsaServer::getInstance(id)->decrypt(encryptedData.data(), encryptedData.size(), decryptedData, nullptr, explicitRejection);
         if (decryptedData && decryptedLen > 0 && decryptedLen < SIZE_MAX)
         {
-            result = StringEncoder::bytesToString(decryptedData, decryptedLen);
-            delete[] decryptedData;
+            std::string result = StringEncoder::bytesToString(decryptedData, decryptedLen);
+            OPENSSL_free(decryptedData);
+            return result;
         }
-        else
+    }
+    throw std::runtime_error("Decryption error");
+}
+
+std::string Endpoints::decryptMessage(const std::string &value, const std::string &keyId)
+{
+    return indiepub::CryptoExecutor::instance().run([&value, &keyId]() { return rsaDecrypt(value, keyId); });
+}
+
+std::vector<std::string> Endpoints::decryptMessages(const std::vector<std::string> &values, const std::string &keyId)
+{
+    std::vector<std::function<std::string()>> jobs;
+    for (const auto &value : values)
+        jobs.push_back([value, keyId]() { return rsaDecrypt(value, keyId); });
+    // the fields of one request are independent, so they decrypt on the pool in parallel
+    auto futures = indiepub::CryptoExecutor::instance().submitAll(std::move(jobs));
+    std::vector<std::string> results;
+    for (auto &future : futures)
+        results.push_back(future.get());
+    return results;
+}
+
+bool Endpoints::checkSignature(const std::string &message, const std::vector<unsigned char> &signature, const std::string &keyId)
+{
+    if (!keyId.empty())
+        return RsaClient::getInstance(keyId)->verify(message.c_str(), const_cast<unsigned char *>(signature.data()), signature.size());
+    for (const auto &pair : RsaClient::keys()->all())
+    {
+        if (RsaClient::getInstance(pair->id())->verify(message.c_str(), const_cast<unsigned char *>(signature.data()), signature.size()))
+            return true;
+    }
+    return false;
+}
+
+bool Endpoints::verifySignature(const std::string &message, const std::vector<unsigned char> &signature, const std::string &keyId)
+{
+    return indiepub::CryptoExecutor::instance().run([&message, &signature, &keyId]() { return checkSignature(message, signature, keyId); });
+}
+
+indiepub::Async<bool> Endpoints::verifySignatureAsync(const std::string &message, const std::vector<unsigned char> &signature, const std::string &keyId)
+{
+    return indiepub::CryptoExecutor::instance().submit([message, signature, keyId]() { return checkSignature(message, signature, keyId); });
+}
+
+bool Endpoints::readBody(const indiepub::RequestContext &context, HttpResponse &response, std::string &body, BodyEncoding &encoding)
+{
+    const HttpRequest &request = context.request();
+    encoding.key_id = context.header("x-key-id");
+    encoding.signature_key_id = context.header("x-signature-key-id");
+    encoding.sealed = context.header("x-encryption") == "aes-256-gcm";
+    if (!encoding.sealed)
+    {
+        body = request.getBody();
+        return true;
+    }
+    std::string sessionId(context.header("x-session-id"));
+    std::optional<SessionCipher> cipher = indiepub::SessionKeys::instance().find(sessionId);
+    try
+    {
+        if (cipher)
+        {
+            std::unique_ptr<JSONObject> jsonObj = std::make_unique<JSONObject>(request.getBody());
+            std::vector<byte> payload = StringEncoder::base64Decode(jsonObj->get("payload").c_str());
+            // the session id is authenticated too, so a body cannot be replayed under another session
+            if (cipher->open(StringEncoder::bytesToString(payload.data(), payload.size()), body, sessionId))
+                return true;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+    }
+    LOG_ERROR << "Session encrypted request rejected";
+    response.setStatus(CODES::UNAUTHORIZED);
+    response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
+    response.setBody("{\"error\": \"session key expired or invalid\"}");
+    return false;
+}
+
+std::string Endpoints::fieldValue(const std::string &value, const BodyEncoding &encoding)
+{
+    return encoding.sealed ? value : decryptMessage(value, encoding.key_id);
+}
+
+std::vector<std::string> Endpoints::fieldValues(const std::vector<std::string> &values, const BodyEncoding &encoding)
+{
+    return encoding.sealed ? values : decryptMessages(values, encoding.key_id);
+}
+
+indiepub::Async<std::string> Endpoints::fieldValueAsync(const std::string &value, const BodyEncoding &encoding)
+{
+    if (encoding.sealed)
+        return indiepub::Async<std::string>::value(value);
+    return indiepub::CryptoExecutor::instance().submit([value, keyId = encoding.key_id]() { return rsaDecrypt(value, keyId); });
+}
+
+void Endpoints::respond(const indiepub::RequestContext &context, indiepub::AsyncResponse response, Coroutine handler)
+{
+    indiepub::start(reply(context.request(), context.params(), context, response, handler));
+}
+
+indiepub::Task<void> Endpoints::reply(HttpRequest request, indiepub::RouteParams params, const indiepub::RequestContext &origin, indiepub::AsyncResponse done, Coroutine handler)
+{
+    // start() runs this far on the HTTP worker, while `origin` is still alive
+    indiepub::RequestContext context(origin, request, params);
+    HttpResponse response;
+    try
+    {
+        co_await handler(context, response);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+        response.setStatus(CODES::INTERNAL_SERVER_ERROR);
+        response.setStatusMsg(Status(CODES::INTERNAL_SERVER_ERROR).ss.str());
+    }
+    done.complete(response);
+}
+
+void Endpoints::sessionKeyHandler(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    try
+    {
+        std::unique_ptr<JSONObject> jsonObj = std::make_unique<JSONObject>(context.request().getBody());
+        std::string keyId(context.header("x-key-id"));
+        // the only private key operation of the session
+        std::string key = decryptMessage(jsonObj->get("key").c_str(), keyId);
+        std::time_t expiresAt = 0;
+        std::string sessionId = indiepub::SessionKeys::instance().establish(key, expiresAt);
+        if (sessionId.empty())
         {
-            throw std::runtime_error("Decryption error");
+            response.setStatus(CODES::BAD_REQUEAST);
+            response.setStatusMsg(Status(CODES::BAD_REQUEAST).ss.str());
+            response.setBody("{\"error\": \"session key must be 32 bytes\"}");
+            return;
         }
-        return result;
+        std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
+        body->put("session_id", sessionId);
+        body->put("encryption", "aes-256-gcm");
+        body->put("expires_at", std::to_string(expiresAt));
+        // lets clients notice a rotation and fetch /keys
+        body->put("key_id", RsaServer::keys()->current()->id());
+        response.setStatus(CODES::CREATED);
+        response.setStatusMsg(Status(CODES::CREATED).ss.str());
+        response.setBody(body->c_str());
     }
-    catch (std::runtime_error &ex) 
+    catch (const indiepub::CryptoOverloaded &e)
     {
-        throw std::runtime_error(ex.what());
+        LOG_WARN << e.what();
+        response.setStatus(CODES::SERVICE_UNAVAILABLE);
+        response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+        response.setBody("{\"error\": \"server busy, retry later\"}");
     }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+        response.setStatus(CODES::BAD_REQUEAST);
+        response.setStatusMsg(Status(CODES::BAD_REQUEAST).ss.str());
+        response.setBody("{\"error\": \"session key could not be decrypted\"}");
+    }
+}
+
+void Endpoints::keysHandler(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    std::shared_ptr<const KeySet> keys = RsaServer::keys();
+    JSONArray published;
+    for (const auto &pair : keys->all())
+    {
+        if (pair->publicKey() == nullptr)
+            continue;
+        BIO *bio = BIO_new(BIO_s_mem());
+        BUF_MEM *pem = nullptr;
+        if (bio == nullptr || PEM_write_bio_PUBKEY(bio, pair->publicKey()) != 1)
+        {
+            BIO_free(bio);
+            continue;
+        }
+        BIO_get_mem_ptr(bio, &pem);
+        std::unique_ptr<JSONObject> key = std::make_unique<JSONObject>();
+        key->put("key_id", pair->id());
+        key->put("public_key", std::string(pem->data, pem->length));
+        published.add(JSON(key->dump(4)));
+        BIO_free(bio);
+    }
+    std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
+    body->put("current", keys->current()->id());
+    body->put("keys", published);
+    response.setStatus(CODES::OK);
+    response.setStatusMsg(Status(CODES::OK).ss.str());
+    response.setBody(body->c_str());
+}
+
+indiepub::Task<Endpoints::Account> Endpoints::findAccount(std::string email)
+{
+    Account account;
+    account.first = co_await getUsersController().getUserByEmailAsync(email);
+    if (!account.first.user_id().empty())
+        account.second = co_await getCredentialsController().getCredentialsByUserIdAsync(account.first.user_id());
+    co_return account;
+}
+
+void Endpoints::signInHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response)
+{
+    respond(context, response, signIn);
 }
 
-void Endpoints::signInHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+indiepub::Task<void> Endpoints::signIn(const indiepub::RequestContext &context, HttpResponse &response)
 {
-    std::string msg = request.getBody();
+    std::string msg;
+    BodyEncoding encoding;
+    if (!readBody(context, response, msg, encoding))
+        co_return;
     try
     {
         std::string email;
-        std::string pwHash;
+        std::string plainPassword;
         std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
+        // the account is looked up while the password signature is checked
+        std::optional<indiepub::Async<Account>> account;
         if (!msg.empty())
         {
             auto jsonObj = JSONObject(msg);
-            for (const auto key : jsonObj.keys())
+            std::optional<indiepub::Async<std::string>> emailField;
+            std::optional<indiepub::Async<std::string>> passwordField;
+            std::string signature;
+            // both fields decrypt on the pool at the same time
+            for (const auto &key : jsonObj.keys())
             {
                 auto value = jsonObj[key];
                 if (key == "email")
                 {
-                    email = decryptMessage(value.c_str());
-                    if (email.empty())
-                    {
-                        int status = CODES::BAD_REQUEAST;
-                        std::string errorMsg = Status(status).ss.str() + " Failed to decrypt email";
-                        LOG_ERROR << "Failed to decrypt email";
-                        response.setStatus(status);
-                        response.setStatusMsg(errorMsg);
-                        body->put("error", "Failed to decrypt email");
-                        response.setBody(body->c_str());
-                        return;
-                    }
-                    if (!isValidEmail(email))
-                    {
-                        int status = CODES::BAD_REQUEAST;
-                        std::string errorMsg = Status(status).ss.str() + " " + email;
-                        LOG_ERROR << "Invalid email format";
-                        response.setStatus(status);
-                        response.setStatusMsg(errorMsg);
-                        body->put("error", "Invalid email format");
-                        response.setBody(body->c_str());
-                        return;
-                    }
+                    emailField = fieldValueAsync(value.c_str(), encoding);
                 }
                 else if (key == "password")
                 {
                     std::string valueStr = value.c_str();
-                    size_t colonPos = valueStr.find(':');
-                    std::vector<std::string> parts;
+                    // the signature is base64, so the last ':' separates it even from a clear password
+                    size_t colonPos = valueStr.rfind(':');
                     if (colonPos != std::string::npos)
                     {
-                        // Split into two parts based on ':'
                         std::string part1 = valueStr.substr(0, colonPos);
-                        std::string part2 = valueStr.substr(colonPos + 1);
-                        LOG_DEBUG << part1 << " : " << part1.size();
-
-                        std::string password = decryptMessage(part1);
-                        
-                        if (password.empty())
-                        {
-                            int status = CODES::BAD_REQUEAST;
-                            std::string errorMsg = Status(status).ss.str() + " Failed to decrypt password";
-                            LOG_ERROR << "Failed to decrypt password";
-                            response.setStatus(status);
-                            response.setStatusMsg(errorMsg);
-                            body->put("error", "Failed to decrypt password");
-                            response.setBody(body->c_str());
-                            return;
-                        }
-                        
-
-                        std::vector<byte> signatureBytes = StringEncoder::base64Decode(part2);
-                        bool isVerified = RsaClient::getInstance()->verify(password.c_str(), signatureBytes.data(), signatureBytes.size());
-                        if (!isVerified)
-                        {
-                            int status = CODES::BAD_REQUEAST;
-                            std::string errorMsg = Status(status).ss.str() + " Password signature verification failed";
-                            LOG_ERROR << "Password signature verification failed";
-                            response.setStatus(status);
-                            response.setStatusMsg(errorMsg);
-                            body->put("error", "Password signature verification failed");
-                            response.setBody(body->c_str());
-                            return;
-                        }
+                        if (!encoding.sealed)
+                            LOG_DEBUG << part1 << " : " << part1.size();
+                        passwordField = fieldValueAsync(part1, encoding);
+                        signature = valueStr.substr(colonPos + 1);
+                    }
+                }
+            }
+            if (emailField)
+            {
+                email = co_await *emailField;
+                if (email.empty())
+                {
+                    int status = CODES::BAD_REQUEAST;
+                    std::string errorMsg = Status(status).ss.str() + " Failed to decrypt email";
+                    LOG_ERROR << "Failed to decrypt email";
+                    response.setStatus(status);
+                    response.setStatusMsg(errorMsg);
+                    body->put("error", "Failed to decrypt email");
+                    response.setBody(body->c_str());
+                    co_return;
+                }
+                if (!isValidEmail(email))
+                {
+                    int status = CODES::BAD_REQUEAST;
+                    std::string errorMsg = Status(status).ss.str() + " " + email;
+                    LOG_ERROR << "Invalid email format";
+                    response.setStatus(status);
+                    response.setStatusMsg(errorMsg);
+                    body->put("error", "Invalid email format");
+                    response.setBody(body->c_str());
+                    co_return;
+                }
+                account = indiepub::start(findAccount(email));
+            }
+            if (passwordField)
+            {
+                std::string password = co_await *passwordField;
+                if (password.empty())
+                {
+                    int status = CODES::BAD_REQUEAST;
+                    std::string errorMsg = Status(status).ss.str() + " Failed to decrypt password";
+                    LOG_ERROR << "Failed to decrypt password";
+                    response.setStatus(status);
+                    response.setStatusMsg(errorMsg);
+                    body->put("error", "Failed to decrypt password");
+                    response.setBody(body->c_str());
+                    co_return;
+                }
 
-                        if (!isValidPassword(password))
-                        {
-                            int status = CODES::BAD_REQUEAST;
-                            std::string errorMsg = Status(status).ss.str() + " Weak password";
-                            LOG_ERROR << "Invalid password format";
-                            response.setStatus(status);
-                            response.setStatusMsg(errorMsg);
-                            body->put("error", "Weak password");
-                            response.setBody(body->c_str());
-                            return;
-                        }
+                std::vector<byte> signatureBytes = StringEncoder::base64Decode(signature);
+                bool isVerified = co_await verifySignatureAsync(password, signatureBytes, encoding.signature_key_id);
+                if (!isVerified)
+                {
+                    int status = CODES::BAD_REQUEAST;
+                    std::string errorMsg = Status(status).ss.str() + " Password signature verification failed";
+                    LOG_ERROR << "Password signature verification failed";
+                    response.setStatus(status);
+                    response.setStatusMsg(errorMsg);
+                    body->put("error", "Password signature verification failed");
+                    response.setBody(body->c_str());
+                    co_return;
+                }
 
-                        // gets hash the value of the password
-                        pwHash = hashing(password);
-                    }
+                if (!isValidPassword(password))
+                {
+                    int status = CODES::BAD_REQUEAST;
+                    std::string errorMsg = Status(status).ss.str() + " Weak password";
+                    LOG_ERROR << "Invalid password format";
+                    response.setStatus(status);
+                    response.setStatusMsg(errorMsg);
+                    body->put("error", "Weak password");
+                    response.setBody(body->c_str());
+                    co_return;
                 }
+
+                // checked against the stored hash once the user is known
+                plainPassword = password;
             }
-            LOG_DEBUG << jsonObj.dump(4);
+            // a sealed body holds the password in clear
+            if (!encoding.sealed)
+                LOG_DEBUG << jsonObj.dump(4);
         }
-        if (email.empty() && pwHash.empty())
+        if (email.empty() && plainPassword.empty())
         {
             int status = CODES::BAD_REQUEAST;
             std::string errorMsg = Status(status).ss.str() + " password sent... not signed";
@@ -308,12 +752,12 @@ void Endpoints::signInHandler(const HttpRequest &request, HttpResponse &response
             body->put("error", "Invalid password format");
             response.setBody(body->c_str());
             LOG_DEBUG << response.getBody();
-            return;
+            co_return;
         }
         else
         {
             std::string token;
-            indiepub::User user = getUsersController().getUserByEmail(email);
+            auto [user, creds] = co_await (account ? *account : indiepub::start(findAccount(email)));
 
             if (user.user_id().empty())
             {
@@ -324,8 +768,22 @@ void Endpoints::signInHandler(const HttpRequest &request, HttpResponse &response
             }
             else
             {
-                indiepub::Credentials creds = getCredentialsController().getCredentialsByUserId(user.user_id());
-                if (creds.pw_hash() != pwHash)
+                indiepub::PasswordHasher &hasher = indiepub::PasswordHasher::instance();
+                bool rehash = false;
+                // the frame, and so these locals, outlive the jobs: the coroutine waits for each one
+                bool matches = co_await indiepub::PasswordHasher::executor().submit([&hasher, &plainPassword, &creds, &rehash]() {
+                    return hasher.verify(plainPassword, creds.pw_hash(), rehash);
+                });
+                if (matches && rehash)
+                {
+                    // legacy or cheaper hash: upgrade it now that the password is at hand
+                    creds.set_pw_hash(co_await indiepub::PasswordHasher::executor().submit([&hasher, &plainPassword]() {
+                        return hasher.hash(plainPassword);
+                    }));
+                    if (!co_await getCredentialsController().insertCredentialsAsync(creds))
+                        LOG_ERROR << "Password rehash for " << user.user_id() << " was not saved";
+                }
+                if (!matches)
                 {
                     response.setStatus(CODES::UNAUTHORIZED);
                     response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
@@ -336,57 +794,60 @@ void Endpoints::signInHandler(const HttpRequest &request, HttpResponse &response
                 {
                     response.setStatus(CODES::CREATED);
                     response.setStatusMsg(Status(CODES::CREATED).ss.str());
-                    std::string token = tokenGenerator(pwHash);
-                    creds.set_auth_token(token);
-                    if (getCredentialsController().insertCredentials(creds))
-                    {
-                        response.setStatus(CODES::CREATED);
-                        response.setStatusMsg(Status(CODES::CREATED).ss.str());
-                        std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
-                        body->put("token", creds.auth_token());
-                        body->put("user_id", user.user_id());
-                        body->put("email", user.email());
-                        body->put("role", user.role());
-                        body->put("name", user.name());
-                        body->put("created_at", indiepub::timestamp_to_string(user.created_at()));
-                        body->put("bio", user.bio());
-                        body->put("profile_picture", user.profile_picture());
-                        std::string socialLinks;
-                        for (const auto& link : user.social_links()) {
-                            socialLinks += link + ",";
-                        }
-                        if (!socialLinks.empty()) {
-                            socialLinks.pop_back(); // Remove the trailing comma
-                        }
-                        body->put("social_links", socialLinks);;
-                        response.setBody(body->c_str());
-                        LOG_DEBUG << response.getBody();
+                    // session tokens are checked in memory, so a login no longer rewrites the credentials row
+                    creds.set_auth_token(indiepub::SessionToken::instance().issue(user.user_id()));
+                    std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
+                    body->put("token", creds.auth_token());
+                    body->put("user_id", user.user_id());
+                    body->put("email", user.email());
+                    body->put("role", user.role());
+                    body->put("name", user.name());
+                    body->put("created_at", indiepub::timestamp_to_string(user.created_at()));
+                    body->put("bio", user.bio());
+                    body->put("profile_picture", user.profile_picture());
+                    std::string socialLinks;
+                    for (const auto& link : user.social_links()) {
+                        socialLinks += link + ",";
                     }
-                    else
-                    {
-                        response.setStatus(CODES::CONFLICT);
-                        response.setStatusMsg(Status(CODES::CONFLICT).ss.str());
-                        LOG_ERROR << response.getStatusMsg();
+                    if (!socialLinks.empty()) {
+                        socialLinks.pop_back(); // Remove the trailing comma
                     }
+                    body->put("social_links", socialLinks);;
+                    response.setBody(body->c_str());
+                    LOG_DEBUG << response.getBody();
                 }
             }
             LOG_DEBUG << "id: " << email;
-            LOG_DEBUG << "hash: " << pwHash;
         }
     }
+    catch (const indiepub::CryptoOverloaded &e)
+    {
+        LOG_WARN << e.what();
+        response.setStatus(CODES::SERVICE_UNAVAILABLE);
+        response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+        response.setBody("{\"error\": \"server busy, retry later\"}");
+    }
     catch (const std::exception &e)
     {
         LOG_ERROR << e.what();
         response.setStatus(CODES::INTERNAL_SERVER_ERROR);
         response.setStatusMsg(Status(CODES::INTERNAL_SERVER_ERROR).ss.str());
     }
-    return;
 }
 
-void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::signUpHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response)
 {
-    std::string msg = request.getBody();
-    LOG_DEBUG << "signUpHandler: " << msg;
+    respond(context, response, signUp);
+}
+
+indiepub::Task<void> Endpoints::signUp(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    std::string msg;
+    BodyEncoding encoding;
+    if (!readBody(context, response, msg, encoding))
+        co_return;
+    if (!encoding.sealed)
+        LOG_DEBUG << "signUpHandler: " << msg;
     try
     {
         std::string email;
@@ -400,7 +861,7 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                 auto value = jsonObj->get(key);
                 if (key == "email")
                 {
-                    email = decryptMessage(value.c_str());
+                    email = co_await fieldValueAsync(value.c_str(), encoding);
                     if (email.empty())
                     {
                         int status = CODES::BAD_REQUEAST;
@@ -408,7 +869,7 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                         LOG_ERROR << "Failed to decrypt email";
                         response.setStatus(status);
                         response.setStatusMsg(errorMsg);
-                        return;
+                        co_return;
                     }
                     if (!isValidEmail(email))
                     {
@@ -417,19 +878,20 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                         LOG_ERROR << "Invalid email format";
                         response.setStatus(status);
                         response.setStatusMsg(errorMsg);
-                        return;
+                        co_return;
                     }
                 }
                 else if (key == "password")
                 {
                     std::string valueStr = value.c_str();
-                    size_t colonPos = valueStr.find(':');
+                    // the signature is base64, so the last ':' separates it even from a clear password
+                    size_t colonPos = valueStr.rfind(':');
                     std::vector<std::string> parts;
                     if (colonPos != std::string::npos)
                     {
                         std::string part1 = valueStr.substr(0, colonPos);
                         std::string part2 = valueStr.substr(colonPos + 1);
-                        std::string password = decryptMessage(part1);
+                        std::string password = co_await fieldValueAsync(part1, encoding);
                         if (password.empty())
                         {
                             int status = CODES::BAD_REQUEAST;
@@ -437,11 +899,11 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                             LOG_ERROR << "Failed to decrypt password";
                             response.setStatus(status);
                             response.setStatusMsg(errorMsg);
-                            return;
+                            co_return;
                         }
 
                         std::vector<byte> signatureBytes = StringEncoder::base64Decode(part2);
-                        bool isVerified = RsaClient::getInstance()->verify(password.c_str(), signatureBytes.data(), signatureBytes.size());
+                        bool isVerified = co_await verifySignatureAsync(password, signatureBytes, encoding.signature_key_id);
                         if (!isVerified)
                         {
                             int status = CODES::BAD_REQUEAST;
@@ -449,7 +911,7 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                             LOG_ERROR << "Password signature verification failed";
                             response.setStatus(status);
                             response.setStatusMsg(errorMsg);
-                            return;
+                            co_return;
                         }
 
                         if (!isValidPassword(password))
@@ -459,16 +921,18 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                             LOG_ERROR << "Invalid password format";
                             response.setStatus(status);
                             response.setStatusMsg(errorMsg);
-                            return;
+                            co_return;
                         }
 
                         // gets hash the value of the password
-                        pwHash = hashing(password);
+                        pwHash = co_await indiepub::PasswordHasher::executor().submit([password]() {
+                            return indiepub::PasswordHasher::instance().hash(password);
+                        });
                     }
                 }
                 else if (key == "role")
                 {
-                    role = decryptMessage(value.c_str());
+                    role = co_await fieldValueAsync(value.c_str(), encoding);
                     if (role.empty())
                     {
                         int status = CODES::BAD_REQUEAST;
@@ -476,11 +940,12 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                         LOG_ERROR << "Failed to decrypt email";
                         response.setStatus(status);
                         response.setStatusMsg(errorMsg);
-                        return;
+                        co_return;
                     }
                 }
             }
-            LOG_DEBUG << jsonObj->dump(4);
+            if (!encoding.sealed)
+                LOG_DEBUG << jsonObj->dump(4);
         }
         if (email.empty() && pwHash.empty() && role.empty())
         {
@@ -489,11 +954,11 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
             LOG_ERROR << "Invalid password format";
             response.setStatus(status);
             response.setStatusMsg(errorMsg);
-            return;
+            co_return;
         }
         else
         {
-            indiepub::User user = getUsersController().getUserByEmail(email);
+            indiepub::User user = co_await getUsersController().getUserByEmailAsync(email);
             if (user.user_id().empty())
             {
                 user.user_id(UUID::random());
@@ -503,15 +968,15 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
                 std::string uname = (at_pos != std::string::npos) ? email.substr(0, at_pos) : email;
                 user.name(uname); // Use the part before '@' as the name
                 user.created_at(std::time(nullptr));
-                if (getUsersController().insertUser(user))
+                if (co_await getUsersController().insertUserAsync(user))
                 {
-                    std::string token = tokenGenerator(pwHash);
+                    std::string token = indiepub::SessionToken::instance().issue(user.user_id());
 
                     indiepub::Credentials creds(
                         user.user_id(),
                         token,
                         pwHash);
-                    if (getCredentialsController().insertCredentials(creds))
+                    if (co_await getCredentialsController().insertCredentialsAsync(creds))
                     {
                         response.setStatus(CODES::CREATED);
                         response.setStatusMsg(Status(CODES::CREATED).ss.str());
@@ -542,6 +1007,13 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
             }
         }
     }
+    catch (const indiepub::CryptoOverloaded &e)
+    {
+        LOG_WARN << e.what();
+        response.setStatus(CODES::SERVICE_UNAVAILABLE);
+        response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+        response.setBody("{\"error\": \"server busy, retry later\"}");
+    }
     catch (const std::exception &e)
     {
         LOG_ERROR << e.what();
@@ -551,11 +1023,11 @@ void Endpoints::signUpHandler(const HttpRequest &request, HttpResponse &response
 }
 
 \
-void Endpoints::fetchUserInfoHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::fetchUserInfoHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
-    indiepub::Credentials creds;
-    indiepub::User user;
-    if (validateTokenAndId(request, response, path, creds, user))
+    const indiepub::Credentials &creds = context.credentials();
+    const indiepub::User &user = context.user();
+    if (context.authenticated())
     {
         std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>(user.to_json());
         body->put("token", creds.auth_token());
@@ -565,197 +1037,213 @@ void Endpoints::fetchUserInfoHandler(const HttpRequest &request, HttpResponse &r
     }
 }
 
-void Endpoints::validateHeaders(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::validateHeaders(const indiepub::RequestContext &context, HttpResponse &response)
 {
-    indiepub::Credentials creds;
-    indiepub::User user;
-    auto headers = request.getHeaders();
-    std::unique_ptr<JSONObject> body = std::make_unique<JSONObject>();
-    if (headers.find("authorization") == headers.end())
+    // the route requires authentication, so the middleware has already checked the headers
+    fetchUserInfoHandler(context, response);
+}
+
+
+void Endpoints::fetchEventsHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response)
+{
+    respond(context, response, fetchEvents);
+}
+
+indiepub::Task<void> Endpoints::fetchEvents(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    LOG_DEBUG << "getFetchEventsHandler called";
+    // signed in users get every event, everyone else the coming week
+    std::string key = context.authenticated() ? "all" : "week";
+    // the feed is kept compressed next to the plain body, so a hit costs no zlib work
+    indiepub::ContentEncoding encoding = indiepub::Compression::instance().choose(context);
+    if (encoding != indiepub::ContentEncoding::IDENTITY)
+        key += std::string(":") + indiepub::Compression::name(encoding);
+    std::string body = co_await findFeedAsync(key);
+    if (body.empty() && encoding != indiepub::ContentEncoding::IDENTITY)
     {
-        response.setStatus(CODES::UNAUTHORIZED);
-        response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-        body->put("error", "Token not provided");
-        response.setBody(body->c_str());
-        return;
+        encoding = indiepub::ContentEncoding::IDENTITY;
+        body = co_await findFeedAsync(key.substr(0, key.find(':')));
     }
-    else
+    if (encoding != indiepub::ContentEncoding::IDENTITY)
+        context.setContentEncoding(encoding);
+    response.setBody(body.empty() ? "[]" : body);
+    response.setStatus(CODES::OK);
+    response.setStatusMsg(Status(CODES::OK).ss.str());
+}
+
+indiepub::Task<std::string> Endpoints::renderFeed(std::string window)
+{
+    std::vector<indiepub::EventByVenue> found = co_await findEventsAsync(window == "week");
+
+    // one entry per run of events at the same venue; the venues are looked up together
+    std::vector<const indiepub::EventByVenue *> listed;
+    std::vector<indiepub::Async<indiepub::Venue>> lookups;
+    std::string venueId = "";
+    for (const auto &event : found)
     {
-        std::string auth = headers["authorization"];
-        if (auth.empty() || auth.find("Bearer ") != 0)
-        {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "Invalid token format");
-            response.setBody(body->c_str());
-            return;
-        }
-        std::string token = auth.substr(7); // Remove "Bearer " prefix
-        creds = getCredentialsController().getCredentialsByAuthToken(token);
-        if (creds.auth_token().empty())
-        {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "Invalid token");
-            response.setBody(body->c_str());
-            return;
-        }
-        std::string xuserId = headers["x-user-id"];
-        if (xuserId.empty()) {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "User ID not provided");
-            response.setBody(body->c_str());
-            return;
-        }
-        if (xuserId != creds.user_id())
+        if (venueId != event.venue_id())
         {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "User ID does not match token");
-            response.setBody(body->c_str());
-            return;
+            venueId = event.venue_id();
+            listed.push_back(&event);
+            lookups.push_back(indiepub::start(findVenueByIdAsync(venueId)));
         }
-        user = getUsersController().getUserById(creds.user_id());
-        if (user.user_id().empty())
+    }
+    std::vector<indiepub::Venue> venues = co_await indiepub::whenAll(lookups);
+
+    std::unique_ptr<JSONArray> events = std::make_unique<JSONArray>();
+    for (size_t i = 0; i < listed.size(); ++i)
+    {
+        const indiepub::EventByVenue &event = *listed[i];
+        const indiepub::Venue &venue = venues[i];
+        if (venue.venue_id().empty())
         {
-            response.setStatus(CODES::UNAUTHORIZED);
-            response.setStatusMsg(Status(CODES::UNAUTHORIZED).ss.str());
-            body->put("error", "User not found");
-            response.setBody(body->c_str());
-            return;
+            LOG_ERROR << "Venue not found for event: " << event.event_id();
+            continue; // Skip this event if venue is not found
         }
-        body = std::make_unique<JSONObject>(user.to_json());
-        body->put("token", creds.auth_token());
-        response.setStatus(CODES::OK);
-        response.setStatusMsg(Status(CODES::OK).ss.str());
-        response.setBody(body->c_str());
+        events->add(JSON(eventJson(event, venue)));
     }
-    
+    co_return std::string(events->c_str());
 }
 
+std::string Endpoints::eventJson(const indiepub::EventByVenue &event, const indiepub::Venue &venue)
+{
+    std::unique_ptr<JSONObject> eventObj = std::make_unique<JSONObject>();
+    eventObj->put("event_id", event.event_id());
+    eventObj->put("name", event.name());
+    eventObj->put("date", indiepub::timestamp_to_string(event.date()));
+    eventObj->put("location", "`" + venue.name() + "` " + venue.location());
+    eventObj->put("ticket_price", event.price());
+    eventObj->put("capacity", venue.capacity());
+    eventObj->put("creator_id", event.creator_id());
+    eventObj->put("sold", event.sold());
+    return eventObj->dump(4);
+}
 
-void Endpoints::fetchEventsHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::fetchEventHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response)
 {
-    indiepub::Credentials creds;
-    indiepub::User user;
-    std::string venueId = "";
+    respond(context, response, fetchEvent);
+}
+
+indiepub::Task<void> Endpoints::fetchEvent(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    indiepub::EventByVenue event;
+    try
+    {
+        event = co_await getEventController().getEventByIdAsync(context.params().get("event_id"));
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+    }
     indiepub::Venue venue;
-    std::unique_ptr<JSONArray> events = std::make_unique<JSONArray>();
-    LOG_DEBUG << "getFetchEventsHandler called";
-    if (validateTokenAndId(request, response, path, creds, user))
+    if (!event.event_id().empty())
+        venue = co_await findVenueByIdAsync(event.venue_id());
+    if (venue.venue_id().empty())
     {
-        auto allEvents = getEventController().getAllEvents();
-        
-        for (const auto &event : allEvents)
-        {
-            if (venueId != event.venue_id())
-            {
-                venueId = event.venue_id();
-                venue = getVenuesController().getVenueById(venueId);
-                if (venue.venue_id().empty())
-                {
-                    LOG_ERROR << "Venue not found for event: " << event.event_id();
-                    continue; // Skip this event if venue is not found
-                }
-                else
-                {
-                    std::unique_ptr<JSONObject> eventObj = std::make_unique<JSONObject>();
-                    eventObj->put("event_id", event.event_id());
-                    eventObj->put("name", event.name());
-                    eventObj->put("date", indiepub::timestamp_to_string(event.date()));
-                    eventObj->put("location", "`" + venue.name() + "` " + venue.location());
-                    eventObj->put("ticket_price", event.price());
-                    eventObj->put("capacity", venue.capacity());
-                    eventObj->put("creator_id", event.creator_id());
-                    eventObj->put("sold", event.sold());
-                    events->add(JSON(eventObj->dump(4)));
-                }
-            }
-        }
-        response.setBody(events->c_str());
-        response.setStatus(200);
+        response.setStatus(CODES::NOT_FOUND);
+        response.setStatusMsg(Status(CODES::NOT_FOUND).ss.str());
+        response.setBody("{\"error\": \"Event not found\"}");
+        co_return;
     }
-    else
+    response.setBody(eventJson(event, venue));
+    response.setStatus(CODES::OK);
+    response.setStatusMsg(Status(CODES::OK).ss.str());
+}
+
+void Endpoints::fetchVenueHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response)
+{
+    respond(context, response, fetchVenue);
+}
+
+indiepub::Task<void> Endpoints::fetchVenue(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    indiepub::Venue venue = co_await findVenueByIdAsync(context.params().get("venue_id"));
+    if (venue.venue_id().empty())
     {
-        auto oneWeekEvents = getEventController().getOneWeekEvents(time(nullptr));
-        for (const auto &event : oneWeekEvents)
-        {
-            if (venueId != event.venue_id())
-            {
-                venueId = event.venue_id();
-                venue = getVenuesController().getVenueById(venueId);
-                if (venue.venue_id().empty())
-                {
-                    LOG_ERROR << "Venue not found for event: " << event.event_id();
-                    continue; // Skip this event if venue is not found
-                }
-                else
-                {
-                    std::unique_ptr<JSONObject> eventObj = std::make_unique<JSONObject>();
-                    eventObj->put("event_id", event.event_id());
-                    eventObj->put("name", event.name());
-                    eventObj->put("date", indiepub::timestamp_to_string(event.date()));
-                    eventObj->put("location", "`" + venue.name() + "` " + venue.location());
-                    eventObj->put("ticket_price", event.price());
-                    eventObj->put("capacity", venue.capacity());
-                    eventObj->put("creator_id", event.creator_id());
-                    eventObj->put("sold", event.sold());
-                    events->add(JSON(eventObj->dump(4)));
-                }
-            }
-        }
-        response.setBody(events->c_str());
-        response.setStatus(200);
+        response.setStatus(CODES::NOT_FOUND);
+        response.setStatusMsg(Status(CODES::NOT_FOUND).ss.str());
+        response.setBody("{\"error\": \"Venue not found\"}");
+        co_return;
+    }
+    response.setBody(venue.to_json());
+    response.setStatus(CODES::OK);
+    response.setStatusMsg(Status(CODES::OK).ss.str());
+}
+
+void Endpoints::fetchVenueEventsHandler(const indiepub::RequestContext &context, indiepub::AsyncResponse response)
+{
+    respond(context, response, fetchVenueEvents);
+}
+
+indiepub::Task<void> Endpoints::fetchVenueEvents(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    const std::string &venueId = context.params().get("venue_id");
+    // the venue partition is read while the venue itself is looked up
+    indiepub::Async<std::vector<indiepub::EventByVenue>> found = getEventController().getEventsByVenueAsync(venueId);
+    indiepub::Venue venue = co_await findVenueByIdAsync(venueId);
+    if (venue.venue_id().empty())
+    {
+        response.setStatus(CODES::NOT_FOUND);
+        response.setStatusMsg(Status(CODES::NOT_FOUND).ss.str());
+        response.setBody("{\"error\": \"Venue not found\"}");
+        co_return;
     }
+    std::unique_ptr<JSONArray> events = std::make_unique<JSONArray>();
+    for (const auto &event : co_await found)
+        events->add(JSON(eventJson(event, venue)));
+    response.setBody(events->c_str());
+    response.setStatus(CODES::OK);
+    response.setStatusMsg(Status(CODES::OK).ss.str());
 }
 
-void Endpoints::createEventHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::createEventHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
     LOG_DEBUG << "createEventHandler called";
     response.setBody("Hello, World!");
     response.setStatus(200);
 }
 
-void Endpoints::fetchPostsHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::fetchPostsHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
     LOG_DEBUG << "fetchPostsHandler called";
     response.setBody("Hello, World!");
     response.setStatus(200);
 }
 
-void Endpoints::createPostHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::createPostHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
     LOG_DEBUG << "createPostHanPdler called";
     response.setBody("Hello, World!");
     response.setStatus(200);
 }
 
-void Endpoints::updateUserInfoHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::updateUserInfoHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
-    indiepub::Credentials creds;
-    indiepub::User user;
+    indiepub::User user = context.user();
     
     try
     {
         bool result = false;
-        if (validateTokenAndId(request, response, path, creds, user))
+        if (context.authenticated())
         {
-            std::string requestStr = request.getBody();
-            LOG_DEBUG << requestStr;
+            std::string requestStr;
+            BodyEncoding encoding;
+            if (!readBody(context, response, requestStr, encoding))
+                return;
             std::unique_ptr<JSONObject> jsonObject = std::make_unique<JSONObject>(requestStr);
             
-            std::string name = decryptMessage(jsonObject->get("name").c_str());
             std::string bio = jsonObject->get("bio").c_str();
             std::string links = jsonObject->get("social_links").c_str();
             std::string profilePicture = jsonObject->get("profile_picture").c_str();
             std::regex rx(",");
-            std::vector<std::string> socialLinksVector = String::tokenize(links, rx);
+            std::vector<std::string> encrypted = String::tokenize(links, rx);
+            encrypted.insert(encrypted.begin(), jsonObject->get("name").c_str());
+            std::vector<std::string> decrypted = fieldValues(encrypted, encoding);
+            std::string name = decrypted.front();
             std::vector<std::string> socialLinks;
-            for(auto& link: socialLinksVector)
+            for (size_t i = 1; i < decrypted.size(); ++i)
             {
-                std::string socialLink = decryptMessage(link);
-                socialLinks.push_back(String::trim(socialLink));
+                socialLinks.push_back(String::trim(decrypted[i]));
             }
             user.social_links(socialLinks);
             user.name(name);
@@ -775,6 +1263,13 @@ void Endpoints::updateUserInfoHandler(const HttpRequest &request, HttpResponse &
             response.setBody("{\"error\": \"failed to save venue information\"}");
         }
     } 
+    catch (const indiepub::CryptoOverloaded &e)
+    {
+        LOG_WARN << e.what();
+        response.setStatus(CODES::SERVICE_UNAVAILABLE);
+        response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+        response.setBody("{\"error\": \"server busy, retry later\"}");
+    }
     catch (std::runtime_error &ex)
     {
         LOG_ERROR << ex.what();
@@ -785,47 +1280,59 @@ void Endpoints::updateUserInfoHandler(const HttpRequest &request, HttpResponse &
 }
 
 
-void Endpoints::addBandProfileHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::addBandProfileHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
     LOG_DEBUG << "addBandProfileHandler called";
     response.setBody("Hello, World!");
     response.setStatus(200);
 }
 
-void Endpoints::fetchBandProfileHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::fetchBandProfileHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
     LOG_DEBUG << "fetchBandProfileHandler called";
     response.setBody("Hello, World!");
     response.setStatus(200);
 }
 
-void Endpoints::addVenueProfileHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::addVenueProfileHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
     LOG_DEBUG << "addVenueProfileHandler called";
-    indiepub::Credentials creds;
-    indiepub::User user;
+    const indiepub::User &user = context.user();
 
     try
     {
         bool result = false;
     
-        if (validateTokenAndId(request, response, path, creds, user))
+        if (context.authenticated())
         {
-            std::string requestStr = request.getBody();
-            LOG_DEBUG << requestStr;
+            std::string requestStr;
+            BodyEncoding encoding;
+            if (!readBody(context, response, requestStr, encoding))
+                return;
             std::unique_ptr<JSONObject> jsonObject = std::make_unique<JSONObject>(requestStr);
             
             
-            std::string venueId = jsonObject->get("venue_id").c_str().empty()? UUID::random() : decryptMessage(jsonObject->get("venue_id").c_str());
             std::time_t createdAt = indiepub::string_to_timestamp(jsonObject->get("created_at").str());
             long capacity = std::stol(jsonObject->get("capacity").str());
-            std::string name = decryptMessage(jsonObject->get("name").c_str());
-            std::string location = decryptMessage(jsonObject->get("location").c_str());
-            std::string userId = decryptMessage(jsonObject->get("user_id").c_str());
-            std::string memberType = decryptMessage(jsonObject->get("member_type").c_str());
-            
-            indiepub::Venue venue = getVenuesController().getVenueById(venueId);
-            indiepub::VenueMembers venueMember = getVenueMembersController().getVenueMemberByUserId(userId);
+            std::string encryptedVenueId = jsonObject->get("venue_id").c_str();
+            std::vector<std::string> encrypted = {
+                jsonObject->get("name").c_str(),
+                jsonObject->get("location").c_str(),
+                jsonObject->get("user_id").c_str(),
+                jsonObject->get("member_type").c_str()};
+            // one batch for every encrypted field, the venue id included
+            if (!encryptedVenueId.empty())
+                encrypted.push_back(encryptedVenueId);
+            std::vector<std::string> fields = fieldValues(encrypted, encoding);
+            std::string name = fields[0];
+            std::string location = fields[1];
+            std::string userId = fields[2];
+            std::string memberType = fields[3];
+            std::string venueId = encryptedVenueId.empty() ? UUID::random() : fields[4];
+
+            // independent reads, so both queries are in flight at once
+            auto [venue, venueMember] = indiepub::whenAll(indiepub::start(findVenueByIdAsync(venueId)),
+                                                          getVenueMembersController().getVenueMemberByUserIdAsync(userId)).get();
 
             if (!venueMember.venue_id().empty() && venueMember.user_id() == userId && venueMember.is_active())
             {
@@ -891,6 +1398,13 @@ void Endpoints::addVenueProfileHandler(const HttpRequest &request, HttpResponse
             }
         }
     }
+    catch (const indiepub::CryptoOverloaded &e)
+    {
+        LOG_WARN << e.what();
+        response.setStatus(CODES::SERVICE_UNAVAILABLE);
+        response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+        response.setBody("{\"error\": \"server busy, retry later\"}");
+    }
     catch (std::runtime_error &ex)
     {
         LOG_ERROR << ex.what();
@@ -901,17 +1415,16 @@ void Endpoints::addVenueProfileHandler(const HttpRequest &request, HttpResponse
     }
 }
 
-void Endpoints::fetchVenueProfileHandler(const HttpRequest &request, HttpResponse &response, Path *path)
+void Endpoints::fetchVenueProfileHandler(const indiepub::RequestContext &context, HttpResponse &response)
 {
     LOG_DEBUG << "fetchVenueProfileHandler called";
-    indiepub::Credentials creds;
-    indiepub::User user;
+    const indiepub::User &user = context.user();
 
     try
     {
         bool result = false;
     
-        if (validateTokenAndId(request, response, path, creds, user))
+        if (context.authenticated())
         {
             indiepub::VenueMembers vm = getVenueMembersController().getVenueMemberByUserId(user.user_id());
             if (vm.venue_id().empty())
@@ -942,6 +1455,13 @@ void Endpoints::fetchVenueProfileHandler(const HttpRequest &request, HttpRespons
             }
         }
     }
+    catch (const indiepub::CryptoOverloaded &e)
+    {
+        LOG_WARN << e.what();
+        response.setStatus(CODES::SERVICE_UNAVAILABLE);
+        response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+        response.setBody("{\"error\": \"server busy, retry later\"}");
+    }
     catch (std::runtime_error &ex)
     {
         LOG_ERROR << ex.what();
@@ -950,4 +1470,31 @@ void Endpoints::fetchVenueProfileHandler(const HttpRequest &request, HttpRespons
         response.setBody("{\"error\": \"someting went wrong in the server side\"}");
         return;
     }
-}
\ No newline at end of file
+}
+
+void Endpoints::metricsHandler(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    response.setStatus(CODES::OK);
+    response.setStatusMsg(Status(CODES::OK).ss.str());
+    response.setBody(metrics());
+}
+
+std::string Endpoints::metrics()
+{
+    return indiepub::CacheBudget::instance().exposition() + indiepub::CryptoExecutor::instance().exposition() +
+           indiepub::Admission::instance().exposition() + indiepub::RateLimiter::instance().exposition();
+}
+
+void Endpoints::logoutHandler(const indiepub::RequestContext &context, HttpResponse &response)
+{
+    const indiepub::Credentials &creds = context.credentials();
+    if (context.authenticated())
+    {
+        indiepub::SessionToken::Claims claims;
+        if (indiepub::SessionToken::instance().verify(creds.auth_token(), claims))
+            indiepub::SessionToken::instance().logout(claims);
+        response.setStatus(CODES::OK);
+        response.setStatusMsg(Status(CODES::OK).ss.str());
+        response.setBody("{\"logout\": true}");
+    }
+}
@@ -0,0 +1,264 @@
+#include <backend/api/HttpListeners.hpp>
+#include <backend/Environment.hpp>
+#include <util/logging/Log.hpp>
+#include <http/Status.hpp>
+#include <config.h>
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+
+indiepub::HttpListeners::Options indiepub::HttpListeners::Options::fromEnvironment()
+{
+    Options options;
+    options.host = env::text("INDIEBACK_HTTP_HOST", HTTP_HOST);
+    options.port = env::text("INDIEBACK_HTTP_PORT", HTTP_PORT);
+    options.backlog = static_cast<int>(env::number("INDIEBACK_HTTP_BACKLOG", HTTP_BACKLOG, 1, INT_MAX));
+    options.workers = static_cast<int>(env::number("INDIEBACK_HTTP_WORKERS", HTTP_WORKERS, 1, INT_MAX));
+    options.listeners = static_cast<int>(env::number("INDIEBACK_HTTP_LISTENERS", HTTP_LISTENERS, 0, INT_MAX));
+    options.pin_cpus = env::flag("INDIEBACK_HTTP_PIN_CPUS", HTTP_PIN_CPUS);
+    options.async_timeout = env::milliseconds("INDIEBACK_HTTP_ASYNC_TIMEOUT", HTTP_ASYNC_TIMEOUT);
+    return options;
+}
+
+indiepub::HttpListeners::HttpListeners(const Options &options) : options_(options)
+{
+    if (options_.workers < 1)
+        options_.workers = 1;
+    if (options_.listeners <= 0)
+        options_.listeners = static_cast<int>(availableCpus().size());
+#ifndef __linux__
+    if (options_.pin_cpus)
+        LOG_WARN << "CPU pinning needs Linux; the listener is not pinned";
+    options_.pin_cpus = false;
+#endif
+    // HttpServer binds its own socket without SO_REUSEPORT, so a second listener on the port
+    // would fail to bind
+    if (options_.listeners > 1)
+    {
+        LOG_WARN << options_.listeners << " listeners need port reuse, which HttpServer does not offer; using one listener";
+        options_.listeners = 1;
+    }
+}
+
+void indiepub::HttpListeners::setHttpHandler(HttpMethod method, const std::string &pattern, Handler handler, RouteMeta meta)
+{
+    router_.add(method, pattern, meta, std::move(handler));
+}
+
+void indiepub::HttpListeners::use(Router::Middleware middleware)
+{
+    router_.use(std::move(middleware));
+}
+
+void indiepub::HttpListeners::after(Router::Filter filter)
+{
+    router_.after(std::move(filter));
+}
+
+void indiepub::HttpListeners::setAsyncHandler(HttpMethod method, const std::string &pattern, AsyncHandler handler, RouteMeta meta)
+{
+    std::chrono::milliseconds timeout = options_.async_timeout;
+    setHttpHandler(method, pattern, [handler = std::move(handler), timeout](const RequestContext &context, HttpResponse &response) {
+        AsyncResponse pending;
+        try
+        {
+            handler(context, pending);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "Asynchronous handler failed: " << e.what();
+            pending.complete(CODES::INTERNAL_SERVER_ERROR, "{\"error\":\"Internal server error\"}");
+        }
+        // past the timeout the handler still runs, and keeps what the request holds, such as
+        // its admission slot, until it completes
+        if (!pending.deliver(response, timeout))
+            pending.whenComplete(context.detachDeferred());
+    }, meta);
+}
+
+const indiepub::HttpListeners::Options &indiepub::HttpListeners::options() const
+{
+    return options_;
+}
+
+const indiepub::Router &indiepub::HttpListeners::router() const
+{
+    return router_;
+}
+
+std::vector<int> indiepub::HttpListeners::availableCpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty())
+    {
+        unsigned int count = std::thread::hardware_concurrency();
+        for (unsigned int cpu = 0; cpu < (count > 0 ? count : 1); ++cpu)
+            cpus.push_back(static_cast<int>(cpu));
+    }
+    return cpus;
+}
+
+std::vector<int> indiepub::HttpListeners::cpusFor(int index, int count, const std::vector<int> &cpus)
+{
+    std::vector<int> mine;
+    if (count <= 0 || cpus.empty())
+        return mine;
+    // more listeners than CPUs: listeners share CPUs round-robin
+    for (size_t i = static_cast<size_t>(index % static_cast<int>(cpus.size())); i < cpus.size(); i += count)
+        mine.push_back(cpus[i]);
+    return mine;
+}
+
+void indiepub::HttpListeners::listen(int index)
+{
+#ifdef __linux__
+    if (options_.pin_cpus)
+    {
+        std::vector<int> cpus = cpusFor(index, options_.listeners, availableCpus());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+            CPU_SET(cpu, &set);
+        // the HttpServer worker threads created below inherit this mask
+        if (cpus.empty() || pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            LOG_WARN << "Listener " << index << " is not pinned";
+    }
+#endif
+    try
+    {
+        HttpServer server(options_.host.c_str(), options_.port.c_str(), options_.backlog, options_.workers);
+        // every pattern is registered with HttpServer for every method some route uses; the router
+        // then finds the route's metadata and captures, or answers 405 for a method the path lacks
+        std::vector<HttpMethod> methods;
+        std::vector<std::string> patterns;
+        for (const auto &route : router_.routes())
+        {
+            if (std::find(methods.begin(), methods.end(), route->method) == methods.end())
+                methods.push_back(route->method);
+            if (std::find(patterns.begin(), patterns.end(), route->pattern) == patterns.end())
+                patterns.push_back(route->pattern);
+        }
+        for (const auto &pattern : patterns)
+        {
+            for (HttpMethod method : methods)
+            {
+                server.setHttpHandler(method, pattern, [this, method](const HttpRequest &request, HttpResponse &response, Path *) {
+                    handle(method, request, response);
+                });
+            }
+        }
+        LOG_INFO << "Listener " << index << " on " << options_.host << " : " << options_.port
+                 << " with " << options_.workers << " workers";
+        server.run();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << "Listener " << index << " stopped: " << e.what();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    --running_;
+    changed_.notify_all();
+}
+
+void indiepub::HttpListeners::run()
+{
+    LOG_INFO << "Starting " << options_.listeners << " listener(s)" << (options_.pin_cpus ? ", pinned to CPUs" : "");
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = options_.listeners;
+    }
+    std::vector<std::thread> listeners;
+    for (int index = 0; index < options_.listeners; ++index)
+        listeners.emplace_back(&HttpListeners::listen, this, index);
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this]() { return stopped_ || running_ == 0; });
+    bool drained = stopped_;
+    lock.unlock();
+    for (auto &listener : listeners)
+    {
+        // HttpServer cannot be stopped; once drained its threads end with the process
+        if (drained)
+            listener.detach();
+        else
+            listener.join();
+    }
+}
+
+void indiepub::HttpListeners::handle(HttpMethod method, const HttpRequest &request, HttpResponse &response)
+{
+    // counted before draining is checked, so drain() either waits for this request or it is
+    // refused below
+    in_flight_.fetch_add(1);
+    try
+    {
+        if (draining_.load())
+        {
+            // the listening socket stays open until the process exits
+            response.setStatus(CODES::SERVICE_UNAVAILABLE);
+            response.setStatusMsg(Status(CODES::SERVICE_UNAVAILABLE).ss.str());
+            response.setHeader("Retry-After", "1");
+            response.setBody("{\"error\": \"shutting down\"}");
+        }
+        else
+        {
+            router_.dispatch(method, request, response);
+        }
+        // connections kept alive would otherwise bring more requests while draining
+        if (draining_.load())
+            response.setHeader("Connection", "close");
+    }
+    catch (...)
+    {
+        finished();
+        throw;
+    }
+    finished();
+}
+
+void indiepub::HttpListeners::finished()
+{
+    if (in_flight_.fetch_sub(1) == 1 && draining_.load())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changed_.notify_all();
+    }
+}
+
+bool indiepub::HttpListeners::drain(std::chrono::milliseconds timeout)
+{
+    LOG_INFO << "Draining " << in_flight_.load() << " request(s)";
+    draining_.store(true);
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool drained = changed_.wait_for(lock, timeout, [this]() { return in_flight_.load() == 0; });
+    if (!drained)
+        LOG_WARN << in_flight_.load() << " request(s) still running after " << timeout.count() << " ms";
+    stopped_ = true;
+    changed_.notify_all();
+    return drained;
+}
+
+bool indiepub::HttpListeners::draining() const
+{
+    return draining_.load();
+}
+
+size_t indiepub::HttpListeners::inFlight() const
+{
+    return in_flight_.load();
+}
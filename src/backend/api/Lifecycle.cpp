@@ -0,0 +1,256 @@
+#include <backend/api/Lifecycle.hpp>
+#include <backend/Environment.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern char **environ;
+
+namespace
+{
+    // where a successor finds its end of the socket pair, unless that is already taken
+    constexpr int HANDOFF_FD = 3;
+
+    // the write end of the pipe the signal handler reports to
+    std::atomic<int> signalPipe{-1};
+
+    void onSignal(int number)
+    {
+        int saved = errno;
+        char value = static_cast<char>(number);
+        ssize_t written = write(signalPipe.load(), &value, 1);
+        (void)written;
+        errno = saved;
+    }
+
+    bool readable(int fd, std::chrono::milliseconds timeout)
+    {
+        pollfd ready{fd, POLLIN, 0};
+        int result;
+        do
+        {
+            result = poll(&ready, 1, static_cast<int>(timeout.count()));
+        } while (result < 0 && errno == EINTR);
+        return result > 0;
+    }
+
+    // The arguments this process was started with.
+    std::vector<std::string> commandLine()
+    {
+        std::ifstream file("/proc/self/cmdline", std::ios::binary);
+        std::string line((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::vector<std::string> arguments;
+        size_t start = 0;
+        while (start < line.size())
+        {
+            size_t end = line.find('\0', start);
+            if (end == std::string::npos)
+                end = line.size();
+            arguments.push_back(line.substr(start, end - start));
+            start = end + 1;
+        }
+        return arguments;
+    }
+}
+
+indiepub::Lifecycle::Options indiepub::Lifecycle::Options::fromEnvironment()
+{
+    Options options;
+    options.drain_timeout = env::milliseconds("INDIEBACK_DRAIN_TIMEOUT", DRAIN_TIMEOUT);
+    options.handoff_timeout = env::milliseconds("INDIEBACK_HANDOFF_TIMEOUT", HANDOFF_TIMEOUT);
+    return options;
+}
+
+indiepub::Lifecycle::Lifecycle(HttpListeners &listeners, const Options &options) : listeners_(listeners), options_(options)
+{
+}
+
+indiepub::Lifecycle::~Lifecycle()
+{
+    if (worker_.joinable())
+    {
+        char stop = 0;
+        ssize_t written = write(signals_[1], &stop, 1);
+        (void)written;
+        worker_.join();
+    }
+    if (signals_[0] >= 0)
+    {
+        // the handlers stay installed; signals after this point are dropped
+        signalPipe.store(-1);
+        close(signals_[0]);
+        close(signals_[1]);
+    }
+    if (predecessor_ >= 0)
+        close(predecessor_);
+}
+
+bool indiepub::Lifecycle::adopt()
+{
+    const char *from = std::getenv(HANDOFF_VARIABLE);
+    if (from == nullptr)
+        return false;
+    std::string value = from;
+    // a later restart of this process starts its own successor
+    unsetenv(HANDOFF_VARIABLE);
+    char *end = nullptr;
+    long fd = std::strtol(value.c_str(), &end, 10);
+    sockaddr_storage address{};
+    socklen_t length = sizeof(address);
+    if (value.empty() || *end != '\0' || fd < 0 || fd > INT_MAX ||
+        getsockname(static_cast<int>(fd), reinterpret_cast<sockaddr *>(&address), &length) != 0 || address.ss_family != AF_UNIX)
+    {
+        LOG_ERROR << HANDOFF_VARIABLE << "=" << value << " is not a socket to the previous process";
+        return false;
+    }
+    predecessor_ = static_cast<int>(fd);
+    fcntl(predecessor_, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+bool indiepub::Lifecycle::takeOver()
+{
+    if (predecessor_ < 0)
+        return true;
+    char ready = 'R';
+    bool told = write(predecessor_, &ready, 1) == 1;
+    // the predecessor drains and exits; nothing is ever sent back, so readable means closed
+    bool gone = told && readable(predecessor_, options_.drain_timeout + options_.handoff_timeout) &&
+                read(predecessor_, &ready, 1) == 0;
+    close(predecessor_);
+    predecessor_ = -1;
+    if (gone)
+        LOG_INFO << "The previous process has exited; taking over the port";
+    else
+        LOG_ERROR << "The previous process did not exit; listening may fail while it holds the port";
+    return gone;
+}
+
+void indiepub::Lifecycle::start(std::function<void()> checkpoint)
+{
+    checkpoint_ = std::move(checkpoint);
+    if (pipe(signals_) != 0)
+    {
+        LOG_ERROR << "No signal pipe: " << std::strerror(errno);
+        return;
+    }
+    fcntl(signals_[0], F_SETFD, FD_CLOEXEC);
+    fcntl(signals_[1], F_SETFD, FD_CLOEXEC);
+    signalPipe.store(signals_[1]);
+    struct sigaction action{};
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    for (int number : {SIGTERM, SIGINT, SIGUSR2})
+        sigaction(number, &action, nullptr);
+    // a client hanging up mid-response must not end the process
+    std::signal(SIGPIPE, SIG_IGN);
+    worker_ = std::thread(&Lifecycle::run, this);
+}
+
+void indiepub::Lifecycle::run()
+{
+    while (true)
+    {
+        char number = 0;
+        ssize_t got = read(signals_[0], &number, 1);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0 || number == 0)
+            return;
+        if (number == SIGUSR2)
+        {
+            LOG_INFO << "SIGUSR2: starting a new process to take over";
+            if (!restart())
+                continue;
+            listeners_.drain(options_.drain_timeout);
+            return;
+        }
+        LOG_INFO << "Signal " << static_cast<int>(number) << ": draining";
+        listeners_.drain(options_.drain_timeout);
+        return;
+    }
+}
+
+bool indiepub::Lifecycle::restart()
+{
+    std::vector<std::string> arguments = commandLine();
+    int channel[2] = {-1, -1};
+    if (successor_ >= 0 || arguments.empty() || socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, channel) != 0)
+    {
+        LOG_ERROR << "Cannot restart: already handed over, or no command line or socket pair";
+        return false;
+    }
+    if (checkpoint_)
+        checkpoint_();
+
+    std::vector<char *> argv;
+    for (auto &argument : arguments)
+        argv.push_back(argument.data());
+    argv.push_back(nullptr);
+    // dup2 onto another descriptor clears close-on-exec there, in the successor only
+    int inherited = channel[1] == HANDOFF_FD ? HANDOFF_FD + 1 : HANDOFF_FD;
+    std::string handoff = std::string(HANDOFF_VARIABLE) + "=" + std::to_string(inherited);
+    std::vector<char *> envp;
+    for (char **variable = environ; *variable != nullptr; ++variable)
+    {
+        if (std::strncmp(*variable, handoff.c_str(), std::strlen(HANDOFF_VARIABLE) + 1) != 0)
+            envp.push_back(*variable);
+    }
+    envp.push_back(handoff.data());
+    envp.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, channel[1], inherited);
+    pid_t pid = -1;
+    int spawned = posix_spawn(&pid, "/proc/self/exe", &actions, nullptr, argv.data(), envp.data());
+    posix_spawn_file_actions_destroy(&actions);
+    close(channel[1]);
+
+    char ready = 0;
+    bool handedOver = false;
+    if (spawned != 0)
+    {
+        pid = -1;
+        LOG_ERROR << "Cannot start a new process: " << std::strerror(spawned);
+    }
+    else if (!readable(channel[0], options_.handoff_timeout) || read(channel[0], &ready, 1) != 1 || ready != 'R')
+    {
+        LOG_ERROR << "New process " << pid << " did not get ready within " << options_.handoff_timeout.count() << " ms";
+    }
+    else
+    {
+        handedOver = true;
+    }
+
+    if (!handedOver)
+    {
+        close(channel[0]);
+        if (pid > 0)
+        {
+            kill(pid, SIGTERM);
+            std::thread([pid]() { waitpid(pid, nullptr, 0); }).detach();
+        }
+        return false;
+    }
+    // never closed: it closes when this process exits, which lets the successor listen
+    successor_ = channel[0];
+    LOG_INFO << "Process " << pid << " is ready to take over";
+    return true;
+}
@@ -1,53 +1,152 @@
 #include <backend/api/RESTfulAPI.hpp>
 #include <backend/api/Endpoints.hpp>
+#include <backend/api/Admission.hpp>
+#include <backend/api/Compression.hpp>
+#include <backend/api/RateLimiter.hpp>
+#include <backend/Environment.hpp>
+#include <backend/auth/CryptoExecutor.hpp>
+#include <backend/auth/PasswordHasher.hpp>
+#include <backend/auth/SessionToken.hpp>
+#include <backend/cache/Caches.hpp>
+#include <backend/cache/CacheBudget.hpp>
+#include <crypto/KeyRing.hpp>
 #include <util/logging/Log.hpp>
+#include <config.h>
 
 RESTfulAPI::RESTfulAPI()
 {
-    apiServer = std::make_unique<HttpServer>("localhost", "8008", 1024, 4);
+    // every INDIEBACK_* option is parsed here, so a bad value stops startup instead of failing
+    // the first request that needs it
+    apiServer = std::make_unique<indiepub::HttpListeners>(indiepub::HttpListeners::Options::fromEnvironment());
+    // a request waiting for admission holds its worker, so the limit follows the workers run
+    size_t workers = static_cast<size_t>(apiServer->options().listeners) * static_cast<size_t>(apiServer->options().workers);
+    indiepub::Admission::configure(indiepub::Admission::Options::fromEnvironment(workers));
+    indiepub::RateLimiter::configure(indiepub::RateLimiter::Options::fromEnvironment());
+    indiepub::Compression::configure(indiepub::Compression::Options::fromEnvironment());
+    Endpoints::configureAdmin(indiepub::env::text("INDIEBACK_ADMIN_TOKEN", ADMIN_TOKEN));
+    indiepub::CryptoExecutor::instance();
+    indiepub::PasswordHasher::executor();
+    indiepub::PasswordHasher::instance();
+    // a process started by SIGUSR2 finds its predecessor here
+    lifecycle = std::make_unique<indiepub::Lifecycle>(*apiServer, indiepub::Lifecycle::Options::fromEnvironment());
+    if (lifecycle->adopt())
+    {
+        LOG_INFO << "Warming up to take over from the previous process";
+    }
+    // parse the RSA keys once, request handlers only borrow them
+    if (KeyRing::instance().load(BACKEND_RSA_FILE_NAME)->privateKey() == nullptr)
+    {
+        LOG_ERROR << "Backend RSA private key is not available";
+    }
+    LOG_INFO << "Backend RSA key " << KeyRing::instance().get(BACKEND_RSA_FILE_NAME)->id();
+    LOG_INFO << "Session tokens signed with key " << indiepub::SessionToken::instance().keyId();
+    keyRotation = std::make_unique<indiepub::KeyRotation>(indiepub::KeyRotation::Options::fromEnvironment());
+    keyRotation->start();
+    invalidationChannel = std::make_unique<indiepub::InvalidationChannel>(indiepub::InvalidationChannel::Options::fromEnvironment());
+    if (!invalidationChannel->start())
+    {
+        LOG_INFO << "Cross-process cache invalidation disabled";
+    }
+    if (!indiepub::Caches::enableShared())
+    {
+        LOG_INFO << "Shared cache segment disabled";
+    }
+    indiepub::CacheBudget::instance().start(std::chrono::seconds(CACHE_REBALANCE_INTERVAL));
+    cacheSnapshotter = std::make_unique<indiepub::CacheSnapshotter>(indiepub::CacheSnapshotter::Options::fromEnvironment());
+    size_t restored = cacheSnapshotter->start(Endpoints::revalidateCaches);
+    LOG_INFO << "Warm start with " << restored << " cached entries";
 }
 
 void RESTfulAPI::initEndpointHandlers() {
+    using indiepub::RouteClass;
+    using indiepub::RouteMeta;
+    const RouteMeta signedIn{.auth_required = true};
+    const RouteMeta cached{.cache_seconds = HTTP_CACHE_MAX_AGE};
+    // RSA and password hashing on every call
+    const RouteMeta expensive{.route_class = RouteClass::AUTH, .rate_limit = RATE_LIMIT_AUTH};
+
+    // rate limits and shedding come before authentication, which already costs database and
+    // crypto work, and before any handler reads the body
+    apiServer->use([](indiepub::RequestContext &context, HttpResponse &response) {
+        return indiepub::RateLimiter::instance().limitClient(context, response);
+    });
+    apiServer->use(Endpoints::authorizeAdmin);
+    apiServer->use([](indiepub::RequestContext &context, HttpResponse &response) {
+        return indiepub::Admission::instance().admit(context, response);
+    });
+    // every handler gets the credentials and user from the context instead of looking them up
+    apiServer->use(Endpoints::authenticate);
+    apiServer->use([](indiepub::RequestContext &context, HttpResponse &response) {
+        return indiepub::RateLimiter::instance().limitUser(context, response);
+    });
+    apiServer->after([](const indiepub::RequestContext &context, HttpResponse &response) {
+        indiepub::Compression::instance().apply(context, response);
+    });
+
     LOG_INFO << "Mapping endpoints";
     LOG_INFO << "/validate POST";
-    apiServer->setHttpHandler(HttpMethod::POST, "/validate", Endpoints::validateHeaders);
+    apiServer->setHttpHandler(HttpMethod::POST, "/validate", Endpoints::validateHeaders, signedIn);
     LOG_INFO << "/user/info GET";
-    apiServer->setHttpHandler(HttpMethod::GET, "/user/info", Endpoints::fetchUserInfoHandler);
+    apiServer->setHttpHandler(HttpMethod::GET, "/user/info", Endpoints::fetchUserInfoHandler, signedIn);
     LOG_INFO << "/login POST";
-    apiServer->setHttpHandler(HttpMethod::POST, "/login", Endpoints::signInHandler);
+    apiServer->setAsyncHandler(HttpMethod::POST, "/login", Endpoints::signInHandler, expensive);
+    LOG_INFO << "/keys GET";
+    apiServer->setHttpHandler(HttpMethod::GET, "/keys", Endpoints::keysHandler, cached);
+    LOG_INFO << "/session/key POST";
+    apiServer->setHttpHandler(HttpMethod::POST, "/session/key", Endpoints::sessionKeyHandler, expensive);
+    LOG_INFO << "/logout POST";
+    apiServer->setHttpHandler(HttpMethod::POST, "/logout", Endpoints::logoutHandler, {.auth_required = true, .route_class = RouteClass::WRITE});
     LOG_INFO << "/signup POST";
-    apiServer->setHttpHandler(HttpMethod::POST, "/signup", Endpoints::signUpHandler);
+    apiServer->setAsyncHandler(HttpMethod::POST, "/signup", Endpoints::signUpHandler, expensive);
+    // the feed depends on who asks, so only the single resources are cacheable
     LOG_INFO << "/events GET";
-    apiServer->setHttpHandler(HttpMethod::GET, "/events", Endpoints::fetchEventsHandler);
+    apiServer->setAsyncHandler(HttpMethod::GET, "/events", Endpoints::fetchEventsHandler);
+    LOG_INFO << "/events/{event_id} GET";
+    apiServer->setAsyncHandler(HttpMethod::GET, "/events/{event_id}", Endpoints::fetchEventHandler, cached);
     LOG_INFO << "/events POST";
-    apiServer->setHttpHandler(HttpMethod::POST, "/events", Endpoints::createEventHandler);
+    apiServer->setHttpHandler(HttpMethod::POST, "/events", Endpoints::createEventHandler, {.route_class = RouteClass::WRITE});
+    LOG_INFO << "/venues/{venue_id} GET";
+    apiServer->setAsyncHandler(HttpMethod::GET, "/venues/{venue_id}", Endpoints::fetchVenueHandler, cached);
+    LOG_INFO << "/venues/{venue_id}/events GET";
+    apiServer->setAsyncHandler(HttpMethod::GET, "/venues/{venue_id}/events", Endpoints::fetchVenueEventsHandler, cached);
     LOG_INFO << "/posts GET";
     apiServer->setHttpHandler(HttpMethod::GET, "/posts", Endpoints::fetchPostsHandler);
     LOG_INFO << "/posts POST";
-    apiServer->setHttpHandler(HttpMethod::POST, "/posts", Endpoints::createPostHandler);
+    apiServer->setHttpHandler(HttpMethod::POST, "/posts", Endpoints::createPostHandler, {.route_class = RouteClass::WRITE});
 
     LOG_INFO << "/user/profile GET";
-    apiServer->setHttpHandler(HttpMethod::GET, "/user/profile", Endpoints::fetchUserInfoHandler);
+    apiServer->setHttpHandler(HttpMethod::GET, "/user/profile", Endpoints::fetchUserInfoHandler, signedIn);
 
     LOG_INFO << "/user/profile PATCH";
-    apiServer->setHttpHandler(HttpMethod::PATCH, "/user/profile", Endpoints::updateUserInfoHandler);
+    apiServer->setHttpHandler(HttpMethod::PATCH, "/user/profile", Endpoints::updateUserInfoHandler, {.auth_required = true, .route_class = RouteClass::WRITE});
 
     LOG_INFO << "/venue/profile POST";
-    apiServer->setHttpHandler(HttpMethod::POST, "/venue/profile", Endpoints::addVenueProfileHandler);
+    apiServer->setHttpHandler(HttpMethod::POST, "/venue/profile", Endpoints::addVenueProfileHandler, {.auth_required = true, .route_class = RouteClass::WRITE});
     LOG_INFO << "/venue/profile GET";
-    apiServer->setHttpHandler(HttpMethod::GET, "/venue/profile", Endpoints::fetchVenueProfileHandler);
+    apiServer->setHttpHandler(HttpMethod::GET, "/venue/profile", Endpoints::fetchVenueProfileHandler, signedIn);
     LOG_INFO << "/band/profile POST";
-    apiServer->setHttpHandler(HttpMethod::POST, "/band/profile", Endpoints::addBandProfileHandler);
+    apiServer->setHttpHandler(HttpMethod::POST, "/band/profile", Endpoints::addBandProfileHandler, {.route_class = RouteClass::WRITE});
     LOG_INFO << "/band/profile GET";
     apiServer->setHttpHandler(HttpMethod::GET, "/band/profile", Endpoints::fetchBandProfileHandler);
+    LOG_INFO << "/metrics GET";
+    apiServer->setHttpHandler(HttpMethod::GET, "/metrics", Endpoints::metricsHandler, {.route_class = RouteClass::ADMIN});
     LOG_INFO << "/tests GET";
-    apiServer->setHttpHandler(HttpMethod::GET, "/test", [](const HttpRequest &request, HttpResponse &response, Path *path) {
+    apiServer->setHttpHandler(HttpMethod::GET, "/test", [](const indiepub::RequestContext &context, HttpResponse &response) {
         response.setBody("Hello, World!");
         response.setStatus(200);
     });
 
-    LOG_INFO << "Server listening on localhost : 8008 ";
+    // SIGTERM drains; SIGUSR2 hands over to a new process that warm starts from the snapshot
+    lifecycle->start([this]() { cacheSnapshotter->saveNow(); });
+    // a successor listens once the previous process has drained and let go of the port
+    lifecycle->takeOver();
+    LOG_INFO << "Server listening on " << apiServer->options().host << " : " << apiServer->options().port;
     apiServer->run();
+
+    cacheSnapshotter->stop();
+    LOG_INFO << "Stopped with " << apiServer->inFlight() << " request(s) unfinished; final metrics:\n" << Endpoints::metrics();
+    std::cout.flush();
+    std::clog.flush();
 }
 
 RESTfulAPI RESTfulAPI::instance() 
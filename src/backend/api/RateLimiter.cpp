@@ -0,0 +1,217 @@
+#include <backend/api/RateLimiter.hpp>
+#include <backend/Environment.hpp>
+#include <backend/api/Router.hpp>
+#include <http/Status.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    std::string_view trim(std::string_view value)
+    {
+        size_t start = value.find_first_not_of(" \t");
+        if (start == std::string_view::npos)
+            return std::string_view();
+        return value.substr(start, value.find_last_not_of(" \t") - start + 1);
+    }
+
+    // Buckets of different routes stay apart; a route's metadata lives as long as the router.
+    std::string routeKey(const indiepub::RequestContext &context, const char *scope, std::string_view id)
+    {
+        return std::to_string(reinterpret_cast<std::uintptr_t>(&context.meta())) + scope + std::string(id);
+    }
+
+    std::optional<indiepub::RateLimiter::Options> configured;
+    std::atomic<bool> built{false};
+}
+
+indiepub::RateLimiter::Options indiepub::RateLimiter::Options::defaults()
+{
+    return Options{RATE_LIMIT_STRIPES, RATE_LIMIT_WHEEL_SLOTS, RATE_LIMIT_TRUSTED_PROXY != 0};
+}
+
+indiepub::RateLimiter::Options indiepub::RateLimiter::Options::fromEnvironment()
+{
+    Options options = defaults();
+    options.stripes = static_cast<size_t>(env::number("INDIEBACK_RATE_LIMIT_STRIPES", options.stripes, 1));
+    options.wheel_slots = static_cast<size_t>(env::number("INDIEBACK_RATE_LIMIT_WHEEL_SLOTS", options.wheel_slots, 1));
+    options.trusted_proxy = env::flag("INDIEBACK_RATE_LIMIT_TRUSTED_PROXY", options.trusted_proxy);
+    return options;
+}
+
+indiepub::RateLimiter::RateLimiter(const Options &options)
+    : options_(options), start_(Clock::now()), stripes_(std::max<size_t>(options.stripes, 1))
+{
+    options_.stripes = stripes_.size();
+    options_.wheel_slots = std::max<size_t>(options_.wheel_slots, 1);
+    for (auto &stripe : stripes_)
+        stripe.wheel.resize(options_.wheel_slots);
+    if (!options_.trusted_proxy)
+        LOG_WARN << "INDIEBACK_RATE_LIMIT_TRUSTED_PROXY is off: requests are only limited per signed-in user";
+}
+
+void indiepub::RateLimiter::configure(const Options &options)
+{
+    if (built.load())
+        throw std::logic_error("RateLimiter is configured after its first use");
+    configured = options;
+}
+
+indiepub::RateLimiter &indiepub::RateLimiter::instance()
+{
+    static RateLimiter *limiter = []() {
+        built = true;
+        return new RateLimiter(configured.value_or(Options::defaults()));
+    }();
+    return *limiter;
+}
+
+std::uint64_t indiepub::RateLimiter::tickOf(Clock::time_point now) const
+{
+    return now <= start_ ? 0 : static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(now - start_).count());
+}
+
+void indiepub::RateLimiter::turn(Stripe &stripe, std::uint64_t now)
+{
+    if (now <= stripe.tick)
+        return;
+    // after a long quiet spell every slot is due, but only once
+    std::uint64_t steps = std::min<std::uint64_t>(now - stripe.tick, options_.wheel_slots);
+    for (std::uint64_t step = 1; step <= steps; ++step)
+    {
+        std::vector<std::string> due;
+        due.swap(stripe.wheel[(stripe.tick + step) % options_.wheel_slots]);
+        for (auto &key : due)
+        {
+            auto found = stripe.buckets.find(key);
+            if (found == stripe.buckets.end())
+                continue;
+            if (found->second.expires <= now)
+                stripe.buckets.erase(found);
+            else // used since it was filed, or further out than the wheel reaches
+                stripe.wheel[found->second.expires % options_.wheel_slots].push_back(std::move(key));
+        }
+    }
+    stripe.tick = now;
+}
+
+std::chrono::milliseconds indiepub::RateLimiter::take(const std::string &key, int perMinute, Clock::time_point now)
+{
+    if (perMinute <= 0)
+        return std::chrono::milliseconds(0);
+    double burst = perMinute;
+    double perSecond = perMinute / 60.0;
+    std::uint64_t tick = tickOf(now);
+    Stripe &other = stripes_[sweep_.fetch_add(1, std::memory_order_relaxed) % stripes_.size()];
+    {
+        std::unique_lock<std::mutex> lock(other.mutex, std::try_to_lock);
+        if (lock.owns_lock())
+            turn(other, tick);
+    }
+    Stripe &stripe = stripes_[std::hash<std::string>()(key) % stripes_.size()];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    turn(stripe, tick);
+    auto [found, created] = stripe.buckets.try_emplace(key, Bucket{burst, now, 0});
+    Bucket &bucket = found->second;
+    double elapsed = std::chrono::duration<double>(now - bucket.updated).count();
+    bucket.tokens = std::min(burst, bucket.tokens + std::max(elapsed, 0.0) * perSecond);
+    bucket.updated = std::max(bucket.updated, now);
+    std::chrono::milliseconds wait(0);
+    if (bucket.tokens >= 1.0)
+        bucket.tokens -= 1.0;
+    else
+        wait = std::chrono::milliseconds(static_cast<long long>(std::ceil((1.0 - bucket.tokens) / perSecond * 1000.0)));
+    bucket.expires = tick + static_cast<std::uint64_t>(std::ceil((burst - bucket.tokens) / perSecond));
+    // filed once; turn() moves it along while it stays in use
+    if (created)
+        stripe.wheel[bucket.expires % options_.wheel_slots].push_back(key);
+    return wait;
+}
+
+std::string_view indiepub::RateLimiter::clientAddress(const RequestContext &context) const
+{
+    // anyone can send these headers when no proxy in front of us overwrites them
+    if (!options_.trusted_proxy)
+        return std::string_view();
+    std::string_view forwarded = context.header("x-forwarded-for");
+    if (!forwarded.empty())
+    {
+        // earlier entries are whatever the client claimed
+        size_t comma = forwarded.rfind(',');
+        return trim(comma == std::string_view::npos ? forwarded : forwarded.substr(comma + 1));
+    }
+    return context.header("x-real-ip");
+}
+
+bool indiepub::RateLimiter::reject(std::chrono::milliseconds wait, HttpResponse &response) const
+{
+    if (wait.count() == 0)
+        return false;
+    response.setStatus(CODES::TOO_MANY_REQUESTS);
+    response.setStatusMsg(Status(CODES::TOO_MANY_REQUESTS).ss.str());
+    response.setHeader("Retry-After", std::to_string((wait.count() + 999) / 1000));
+    response.setBody("{\"error\": \"too many requests, retry later\"}");
+    return true;
+}
+
+bool indiepub::RateLimiter::limitClient(RequestContext &context, HttpResponse &response)
+{
+    int limit = context.meta().rate_limit;
+    if (limit <= 0)
+        return true;
+    std::string_view address = clientAddress(context);
+    // a bucket shared by every client would let one of them lock the rest out
+    if (address.empty())
+    {
+        if (options_.trusted_proxy && !warned_.exchange(true))
+            LOG_WARN << "Requests without X-Forwarded-For or X-Real-IP are not limited per client";
+        return true;
+    }
+    if (!reject(take(routeKey(context, "|ip|", address), limit), response))
+        return true;
+    limited_client_.fetch_add(1, std::memory_order_relaxed);
+    LOG_DEBUG << "Rate limited client " << address;
+    return false;
+}
+
+bool indiepub::RateLimiter::limitUser(RequestContext &context, HttpResponse &response)
+{
+    int limit = context.meta().rate_limit;
+    if (limit <= 0 || !context.authenticated())
+        return true;
+    // keyed by the verified user, so a forged x-user-id cannot spend someone else's tokens
+    if (!reject(take(routeKey(context, "|user|", context.user().user_id()), limit), response))
+        return true;
+    limited_user_.fetch_add(1, std::memory_order_relaxed);
+    LOG_DEBUG << "Rate limited user " << context.user().user_id();
+    return false;
+}
+
+size_t indiepub::RateLimiter::size() const
+{
+    size_t size = 0;
+    for (const auto &stripe : stripes_)
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        size += stripe.buckets.size();
+    }
+    return size;
+}
+
+std::string indiepub::RateLimiter::exposition() const
+{
+    std::ostringstream out;
+    out << "# TYPE indieback_rate_limit_buckets gauge\n";
+    out << "indieback_rate_limit_buckets " << size() << "\n";
+    out << "# TYPE indieback_rate_limited_total counter\n";
+    out << "indieback_rate_limited_total{scope=\"client\"} " << limited_client_.load(std::memory_order_relaxed) << "\n";
+    out << "indieback_rate_limited_total{scope=\"user\"} " << limited_user_.load(std::memory_order_relaxed) << "\n";
+    return out.str();
+}
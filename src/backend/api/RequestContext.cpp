@@ -0,0 +1,118 @@
+#include <backend/api/RequestContext.hpp>
+#include <backend/api/Router.hpp>
+
+namespace
+{
+    std::string_view trim(std::string_view value)
+    {
+        constexpr std::string_view blanks = " \t\r\n";
+        size_t start = value.find_first_not_of(blanks);
+        if (start == std::string_view::npos)
+            return std::string_view();
+        return value.substr(start, value.find_last_not_of(blanks) - start + 1);
+    }
+}
+
+indiepub::RequestContext::RequestContext(const HttpRequest &request, const RouteParams &params, const RouteMeta &meta)
+    : request_(&request), params_(&params), meta_(&meta), shared_(std::make_shared<Shared>(request.getHeaders()))
+{
+    std::string_view authorization = header("authorization");
+    if (authorization.substr(0, 7) == "Bearer ")
+        token_ = trim(authorization.substr(7));
+    user_id_ = header("x-user-id");
+}
+
+indiepub::RequestContext::RequestContext(const RequestContext &other, const HttpRequest &request, const RouteParams &params)
+    : request_(&request), params_(&params), meta_(other.meta_), shared_(other.shared_), token_(other.token_),
+      user_id_(other.user_id_), authenticated_(other.authenticated_), credentials_(other.credentials_), user_(other.user_)
+{
+}
+
+indiepub::RequestContext::~RequestContext()
+{
+    for (auto done = deferred_.rbegin(); done != deferred_.rend(); ++done)
+        (*done)();
+}
+
+const HttpRequest &indiepub::RequestContext::request() const
+{
+    return *request_;
+}
+
+const indiepub::RouteParams &indiepub::RequestContext::params() const
+{
+    return *params_;
+}
+
+const indiepub::RouteMeta &indiepub::RequestContext::meta() const
+{
+    return *meta_;
+}
+
+std::string_view indiepub::RequestContext::header(const std::string &name) const
+{
+    auto found = shared_->headers.find(name);
+    return found == shared_->headers.end() ? std::string_view() : trim(found->second);
+}
+
+bool indiepub::RequestContext::hasHeader(const std::string &name) const
+{
+    return shared_->headers.find(name) != shared_->headers.end();
+}
+
+std::string_view indiepub::RequestContext::bearerToken() const
+{
+    return token_;
+}
+
+std::string_view indiepub::RequestContext::userId() const
+{
+    return user_id_;
+}
+
+bool indiepub::RequestContext::authenticated() const
+{
+    return authenticated_;
+}
+
+const indiepub::Credentials &indiepub::RequestContext::credentials() const
+{
+    return credentials_;
+}
+
+const indiepub::User &indiepub::RequestContext::user() const
+{
+    return user_;
+}
+
+void indiepub::RequestContext::authenticate(Credentials credentials, User user)
+{
+    credentials_ = std::move(credentials);
+    user_ = std::move(user);
+    authenticated_ = true;
+}
+
+void indiepub::RequestContext::setContentEncoding(ContentEncoding encoding) const
+{
+    shared_->encoding.store(encoding);
+}
+
+indiepub::ContentEncoding indiepub::RequestContext::contentEncoding() const
+{
+    return shared_->encoding.load();
+}
+
+void indiepub::RequestContext::defer(std::function<void()> done)
+{
+    deferred_.push_back(std::move(done));
+}
+
+std::function<void()> indiepub::RequestContext::detachDeferred() const
+{
+    std::vector<std::function<void()>> deferred;
+    deferred.swap(deferred_);
+    return [deferred = std::move(deferred)]() {
+        for (auto done = deferred.rbegin(); done != deferred.rend(); ++done)
+            (*done)();
+    };
+}
@@ -0,0 +1,269 @@
+#include <backend/api/Router.hpp>
+#include <util/logging/Log.hpp>
+#include <http/Status.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    constexpr int METHOD_NOT_ALLOWED = 405;
+
+    // Non-empty segments of the path, without the query string or fragment.
+    std::vector<std::string_view> split(std::string_view path)
+    {
+        size_t end = path.find_first_of("?#");
+        if (end != std::string_view::npos)
+            path = path.substr(0, end);
+        std::vector<std::string_view> segments;
+        size_t start = 0;
+        while (start < path.size())
+        {
+            size_t slash = path.find('/', start);
+            if (slash == std::string_view::npos)
+                slash = path.size();
+            if (slash > start)
+                segments.push_back(path.substr(start, slash - start));
+            start = slash + 1;
+        }
+        return segments;
+    }
+
+    bool isCapture(std::string_view segment)
+    {
+        return segment.size() > 2 && segment.front() == '{' && segment.back() == '}';
+    }
+
+    const char *methodName(HttpMethod method)
+    {
+        switch (method)
+        {
+        case HttpMethod::GET:
+            return "GET";
+        case HttpMethod::POST:
+            return "POST";
+        case HttpMethod::PUT:
+            return "PUT";
+        case HttpMethod::PATCH:
+            return "PATCH";
+        case HttpMethod::DELETE:
+            return "DELETE";
+        default:
+            return "";
+        }
+    }
+}
+
+struct indiepub::Router::Node
+{
+    // sorted by segment
+    std::vector<std::pair<std::string, std::unique_ptr<Node>>> literals;
+    std::unique_ptr<Node> capture;
+    std::string capture_name;
+    std::vector<std::pair<HttpMethod, const Route *>> routes;
+
+    Node *literal(std::string_view segment) const
+    {
+        auto found = std::lower_bound(literals.begin(), literals.end(), segment,
+                                      [](const auto &child, std::string_view key) { return child.first < key; });
+        return found != literals.end() && found->first == segment ? found->second.get() : nullptr;
+    }
+
+    const Route *route(HttpMethod method) const
+    {
+        for (const auto &entry : routes)
+        {
+            if (entry.first == method)
+                return entry.second;
+        }
+        return nullptr;
+    }
+};
+
+void indiepub::RouteParams::add(std::string_view name, std::string value)
+{
+    values_.emplace_back(name, std::move(value));
+}
+
+const std::string &indiepub::RouteParams::get(std::string_view name) const
+{
+    static const std::string none;
+    for (const auto &value : values_)
+    {
+        if (value.first == name)
+            return value.second;
+    }
+    return none;
+}
+
+bool indiepub::RouteParams::has(std::string_view name) const
+{
+    return std::any_of(values_.begin(), values_.end(), [name](const auto &value) { return value.first == name; });
+}
+
+size_t indiepub::RouteParams::size() const
+{
+    return values_.size();
+}
+
+indiepub::Router::Router() : root_(std::make_unique<Node>())
+{
+}
+
+indiepub::Router::~Router() = default;
+
+const indiepub::Router::Route &indiepub::Router::add(HttpMethod method, const std::string &pattern, RouteMeta meta, Handler handler)
+{
+    Node *node = root_.get();
+    for (std::string_view segment : split(pattern))
+    {
+        if (segment.find_first_of("{}") != std::string_view::npos && !isCapture(segment))
+            throw std::invalid_argument("Malformed route segment in " + pattern);
+        if (isCapture(segment))
+        {
+            std::string_view name = segment.substr(1, segment.size() - 2);
+            if (!node->capture)
+            {
+                node->capture = std::make_unique<Node>();
+                node->capture_name = std::string(name);
+            }
+            else if (node->capture_name != name)
+            {
+                throw std::invalid_argument("Route " + pattern + " renames {" + node->capture_name + "}");
+            }
+            node = node->capture.get();
+            continue;
+        }
+        Node *next = node->literal(segment);
+        if (next == nullptr)
+        {
+            auto position = std::lower_bound(node->literals.begin(), node->literals.end(), segment,
+                                             [](const auto &child, std::string_view key) { return child.first < key; });
+            next = node->literals.emplace(position, std::string(segment), std::make_unique<Node>())->second.get();
+        }
+        node = next;
+    }
+    if (node->route(method) != nullptr)
+        throw std::invalid_argument("Route " + pattern + " is already registered");
+    routes_.push_back(std::make_unique<Route>(Route{method, pattern, meta, std::move(handler)}));
+    node->routes.emplace_back(method, routes_.back().get());
+    return *routes_.back();
+}
+
+const indiepub::Router::Route *indiepub::Router::find(const Node &node, const std::vector<std::string_view> &segments, size_t depth, HttpMethod method, Captures &captures) const
+{
+    if (depth == segments.size())
+        return node.route(method);
+    if (const Node *next = node.literal(segments[depth]))
+    {
+        if (const Route *route = find(*next, segments, depth + 1, method, captures))
+            return route;
+    }
+    if (node.capture)
+    {
+        captures.emplace_back(node.capture_name, segments[depth]);
+        if (const Route *route = find(*node.capture, segments, depth + 1, method, captures))
+            return route;
+        captures.pop_back();
+    }
+    return nullptr;
+}
+
+void indiepub::Router::collect(const Node &node, const std::vector<std::string_view> &segments, size_t depth, std::vector<const Route *> &found) const
+{
+    if (depth == segments.size())
+    {
+        for (const auto &entry : node.routes)
+            found.push_back(entry.second);
+        return;
+    }
+    if (const Node *next = node.literal(segments[depth]))
+        collect(*next, segments, depth + 1, found);
+    if (node.capture)
+        collect(*node.capture, segments, depth + 1, found);
+}
+
+void indiepub::Router::use(Middleware middleware)
+{
+    middlewares_.push_back(std::move(middleware));
+}
+
+void indiepub::Router::after(Filter filter)
+{
+    filters_.push_back(std::move(filter));
+}
+
+indiepub::Router::Match indiepub::Router::match(HttpMethod method, std::string_view path) const
+{
+    Match match;
+    std::vector<std::string_view> segments = split(path);
+    Captures captures;
+    match.route = find(*root_, segments, 0, method, captures);
+    if (match.route != nullptr)
+    {
+        for (const auto &capture : captures)
+            match.params.add(capture.first, std::string(capture.second));
+    }
+    return match;
+}
+
+std::vector<HttpMethod> indiepub::Router::allowed(std::string_view path) const
+{
+    std::vector<const Route *> found;
+    collect(*root_, split(path), 0, found);
+    // a path matched by both a literal and a capture route lists each method once, in route order
+    std::vector<HttpMethod> methods;
+    for (const auto &route : routes_)
+    {
+        if (std::find(found.begin(), found.end(), route.get()) != found.end() &&
+            std::find(methods.begin(), methods.end(), route->method) == methods.end())
+            methods.push_back(route->method);
+    }
+    return methods;
+}
+
+void indiepub::Router::dispatch(HttpMethod method, const HttpRequest &request, HttpResponse &response) const
+{
+    std::string path = request.getPath();
+    Match found = match(method, path);
+    if (!found)
+    {
+        std::vector<HttpMethod> methods = allowed(path);
+        if (!methods.empty())
+        {
+            std::string allow;
+            for (HttpMethod other : methods)
+                allow += (allow.empty() ? "" : ", ") + std::string(methodName(other));
+            response.setStatus(METHOD_NOT_ALLOWED);
+            response.setStatusMsg(Status(METHOD_NOT_ALLOWED).ss.str());
+            response.setHeader("Allow", allow);
+            response.setBody("{\"error\": \"method not allowed\"}");
+            return;
+        }
+        LOG_DEBUG << "No route for " << path;
+        response.setStatus(CODES::NOT_FOUND);
+        response.setStatusMsg(Status(CODES::NOT_FOUND).ss.str());
+        response.setBody("{\"error\": \"not found\"}");
+        return;
+    }
+    const RouteMeta &meta = found.route->meta;
+    RequestContext context(request, found.params, meta);
+    for (const auto &middleware : middlewares_)
+    {
+        if (!middleware(context, response))
+            return;
+    }
+    found.route->handler(context, response);
+    // errors, and answers whose status the handler left unset, are never cached
+    int status = response.getStatus();
+    if (meta.cache_seconds > 0 && status >= 200 && status < 300)
+        response.setHeader("Cache-Control", std::string(meta.auth_required ? "private" : "public") + ", max-age=" + std::to_string(meta.cache_seconds));
+    else
+        response.setHeader("Cache-Control", "no-store");
+    for (const auto &filter : filters_)
+        filter(context, response);
+}
+
+const std::vector<std::unique_ptr<indiepub::Router::Route>> &indiepub::Router::routes() const
+{
+    return routes_;
+}
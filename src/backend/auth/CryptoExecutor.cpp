@@ -0,0 +1,142 @@
+#include <backend/auth/CryptoExecutor.hpp>
+#include <backend/Environment.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <sstream>
+
+namespace
+{
+    thread_local bool worker_thread = false;
+
+    size_t fromEnvironment(const char *name, size_t fallback)
+    {
+        return static_cast<size_t>(indiepub::env::number(name, static_cast<long long>(fallback), 1));
+    }
+}
+
+indiepub::CryptoExecutor &indiepub::CryptoExecutor::instance()
+{
+    // leaked: handlers may still run while static destructors do
+    static CryptoExecutor *executor = new CryptoExecutor(fromEnvironment("INDIEBACK_CRYPTO_THREADS", CRYPTO_THREADS),
+                                                         fromEnvironment("INDIEBACK_CRYPTO_QUEUE", CRYPTO_QUEUE_SIZE));
+    return *executor;
+}
+
+indiepub::CryptoExecutor::CryptoExecutor(size_t threads, size_t capacity) : capacity_(capacity)
+{
+    for (size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(&CryptoExecutor::work, this);
+    LOG_INFO << "Crypto executor with " << threads << " threads and " << capacity << " queued jobs";
+}
+
+indiepub::CryptoExecutor::~CryptoExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+bool indiepub::CryptoExecutor::inWorker()
+{
+    return worker_thread;
+}
+
+void indiepub::CryptoExecutor::enqueue(std::vector<Job> &jobs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() + jobs.size() > capacity_)
+        {
+            rejected_.fetch_add(jobs.size(), std::memory_order_relaxed);
+            throw CryptoOverloaded();
+        }
+        for (auto &job : jobs)
+            queue_.push_back(std::move(job));
+    }
+    if (jobs.size() == 1)
+        ready_.notify_one();
+    else
+        ready_.notify_all();
+}
+
+void indiepub::CryptoExecutor::work()
+{
+    worker_thread = true;
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            // queued jobs still run on shutdown, their callers are waiting on them
+            if (queue_.empty())
+                return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        Clock::time_point started = Clock::now();
+        job.run();
+        record(started - job.queued, Clock::now() - job.queued);
+    }
+}
+
+void indiepub::CryptoExecutor::record(Clock::duration wait, Clock::duration total)
+{
+    auto micros = [](Clock::duration d) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    };
+    completed_.fetch_add(1, std::memory_order_relaxed);
+    wait_us_.fetch_add(micros(wait), std::memory_order_relaxed);
+    latency_us_.fetch_add(micros(total), std::memory_order_relaxed);
+    double seconds = std::chrono::duration<double>(total).count();
+    for (size_t i = 0; i < LATENCY_BUCKETS.size(); ++i)
+    {
+        if (seconds <= LATENCY_BUCKETS[i])
+        {
+            buckets_[i].fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+size_t indiepub::CryptoExecutor::depth() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+size_t indiepub::CryptoExecutor::capacity() const
+{
+    return capacity_;
+}
+
+std::string indiepub::CryptoExecutor::exposition() const
+{
+    std::ostringstream out;
+    out << "# TYPE indieback_crypto_queue_depth gauge\n";
+    out << "indieback_crypto_queue_depth " << depth() << "\n";
+    out << "# TYPE indieback_crypto_queue_capacity gauge\n";
+    out << "indieback_crypto_queue_capacity " << capacity_ << "\n";
+    out << "# TYPE indieback_crypto_rejected_total counter\n";
+    out << "indieback_crypto_rejected_total " << rejected_.load(std::memory_order_relaxed) << "\n";
+    out << "# TYPE indieback_crypto_wait_seconds_sum counter\n";
+    out << "indieback_crypto_wait_seconds_sum " << wait_us_.load(std::memory_order_relaxed) / 1e6 << "\n";
+
+    // buckets are stored per range; the exposition wants them cumulative
+    std::uint64_t cumulative = 0;
+    std::uint64_t count = completed_.load(std::memory_order_relaxed);
+    out << "# TYPE indieback_crypto_job_seconds histogram\n";
+    for (size_t i = 0; i < LATENCY_BUCKETS.size(); ++i)
+    {
+        cumulative += buckets_[i].load(std::memory_order_relaxed);
+        out << "indieback_crypto_job_seconds_bucket{le=\"" << LATENCY_BUCKETS[i] << "\"} " << cumulative << "\n";
+    }
+    out << "indieback_crypto_job_seconds_bucket{le=\"+Inf\"} " << count << "\n";
+    out << "indieback_crypto_job_seconds_sum " << latency_us_.load(std::memory_order_relaxed) / 1e6 << "\n";
+    out << "indieback_crypto_job_seconds_count " << count << "\n";
+    return out.str();
+}
@@ -0,0 +1,180 @@
+#include <backend/auth/KeyRotation.hpp>
+#include <backend/Environment.hpp>
+#include <backend/auth/SessionKeys.hpp>
+#include <backend/auth/SessionToken.hpp>
+#include <crypto/KeyRing.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <sstream>
+
+namespace
+{
+    // write end of the running watcher's pipe, for the signal handler
+    std::atomic<int> hangupFd{-1};
+
+    void onHangup(int)
+    {
+        int saved = errno;
+        int fd = hangupFd.load();
+        if (fd >= 0)
+        {
+            char wake = 'h';
+            ssize_t ignored = write(fd, &wake, 1);
+            (void)ignored;
+        }
+        errno = saved;
+    }
+
+    bool isKeyFile(const std::string &name, const std::string &sessionKey)
+    {
+        auto startsWith = [&name](const std::string &prefix) { return name.compare(0, prefix.size(), prefix) == 0; };
+        return startsWith(BACKEND_RSA_FILE_NAME) || startsWith(FRONTEND_RSA_FILE_NAME) || startsWith(sessionKey);
+    }
+}
+
+indiepub::KeyRotation::Options indiepub::KeyRotation::Options::fromEnvironment()
+{
+    Options options;
+    options.interval = env::seconds("INDIEBACK_KEY_WATCH_INTERVAL", KEY_WATCH_INTERVAL);
+    return options;
+}
+
+indiepub::KeyRotation::KeyRotation(const Options &options) : options_(options)
+{
+}
+
+indiepub::KeyRotation::~KeyRotation()
+{
+    stop();
+}
+
+bool indiepub::KeyRotation::start()
+{
+    if (worker_.joinable())
+        return true;
+    if (pipe(wake_) != 0)
+    {
+        LOG_ERROR << "Key rotation disabled: " << std::strerror(errno);
+        return false;
+    }
+    for (int fd : wake_)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    hangupFd.store(wake_[1]);
+    struct sigaction action = {};
+    action.sa_handler = onHangup;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &action, nullptr);
+    stopping_ = false;
+    worker_ = std::thread(&KeyRotation::run, this);
+    LOG_INFO << "Reloading keys on SIGHUP" << (options_.interval.count() > 0 ? " and on file changes" : "");
+    return true;
+}
+
+void indiepub::KeyRotation::stop()
+{
+    if (!worker_.joinable())
+        return;
+    stopping_ = true;
+    char wake = 's';
+    ssize_t ignored = write(wake_[1], &wake, 1);
+    (void)ignored;
+    worker_.join();
+    signal(SIGHUP, SIG_DFL);
+    hangupFd.store(-1);
+    close(wake_[0]);
+    close(wake_[1]);
+    wake_[0] = wake_[1] = -1;
+}
+
+bool indiepub::KeyRotation::reloadNow()
+{
+    bool ok = KeyRing::instance().reload(BACKEND_RSA_FILE_NAME);
+    ok = KeyRing::instance().reload(FRONTEND_RSA_FILE_NAME) && ok;
+    try
+    {
+        std::string path = SessionToken::keyFile();
+        // a file missing mid-replace must not become a new secret that signs everybody out
+        std::vector<unsigned char> key = SessionToken::loadKey(path);
+        std::vector<std::vector<unsigned char>> retired = SessionToken::loadRetiredKeys(path);
+        SessionToken::instance().rotate(key, retired);
+        SessionKeys::instance().rotate(key, retired);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << "Keeping session keys: " << e.what();
+        ok = false;
+    }
+    return ok;
+}
+
+std::string indiepub::KeyRotation::fingerprint()
+{
+    std::string sessionKey = SessionToken::keyFile();
+    std::filesystem::path sessionPath(sessionKey);
+    std::set<std::string> directories = {PRV_KEY_ARCHIVE, PUB_KEY_ARCHIVE,
+                                         sessionPath.has_parent_path() ? sessionPath.parent_path().string() : "."};
+    std::ostringstream out;
+    for (const auto &directory : directories)
+    {
+        std::error_code error;
+        std::set<std::string> entries;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+        {
+            std::string name = entry.path().filename().string();
+            if (!isKeyFile(name, sessionPath.filename().string()))
+                continue;
+            std::error_code ignored;
+            auto size = std::filesystem::file_size(entry.path(), ignored);
+            auto modified = std::filesystem::last_write_time(entry.path(), ignored).time_since_epoch().count();
+            std::ostringstream line;
+            line << name << ' ' << size << ' ' << modified << '\n';
+            entries.insert(line.str());
+        }
+        out << directory << '\n';
+        for (const auto &line : entries)
+            out << line;
+    }
+    return out.str();
+}
+
+void indiepub::KeyRotation::run()
+{
+    std::string seen = fingerprint();
+    int timeout = options_.interval.count() > 0 ? static_cast<int>(options_.interval.count() * 1000) : -1;
+    while (!stopping_)
+    {
+        pollfd wake = {wake_[0], POLLIN, 0};
+        int ready = poll(&wake, 1, timeout);
+        if (stopping_)
+            break;
+        if (ready < 0 && errno != EINTR)
+        {
+            LOG_ERROR << "Key rotation stopped: " << std::strerror(errno);
+            break;
+        }
+        bool hangup = false;
+        char drained[16];
+        while (read(wake_[0], drained, sizeof(drained)) > 0)
+            hangup = true;
+        std::string current = fingerprint();
+        if (!hangup && current == seen)
+            continue;
+        LOG_INFO << (hangup ? "SIGHUP, reloading keys" : "Key files changed, reloading keys");
+        if (!reloadNow())
+            LOG_WARN << "Some keys were not reloaded";
+        seen = current;
+    }
+}
@@ -0,0 +1,180 @@
+#include <backend/auth/PasswordHasher.hpp>
+#include <backend/Environment.hpp>
+#include <crypto/Hash.hpp>
+#include <crypto/StringEncoder.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/params.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr const char *PREFIX = "$scrypt$";
+    constexpr size_t SALT_SIZE = 16;
+    constexpr size_t HASH_SIZE = 32;
+    // refuse parameters from a corrupt row that would allocate gigabytes
+    constexpr std::uint32_t MAX_LOG_N = 22;
+
+    std::uint32_t fromEnvironment(const char *name, std::uint32_t fallback, std::uint32_t max = UINT32_MAX)
+    {
+        return static_cast<std::uint32_t>(indiepub::env::number(name, fallback, 1, max));
+    }
+
+    std::string encode(const std::string &bytes)
+    {
+        std::string out(4 * ((bytes.size() + 2) / 3) + 1, '\0');
+        int length = EVP_EncodeBlock(reinterpret_cast<unsigned char *>(&out[0]),
+                                     reinterpret_cast<const unsigned char *>(bytes.data()), static_cast<int>(bytes.size()));
+        out.resize(length);
+        return out;
+    }
+
+    bool decode(const std::string &text, std::string &bytes)
+    {
+        if (text.empty() || text.size() % 4 != 0)
+            return false;
+        std::string out(3 * text.size() / 4, '\0');
+        int length = EVP_DecodeBlock(reinterpret_cast<unsigned char *>(&out[0]),
+                                     reinterpret_cast<const unsigned char *>(text.data()), static_cast<int>(text.size()));
+        if (length < 0)
+            return false;
+        // EVP_DecodeBlock counts the padding as zero bytes
+        size_t padding = std::count(text.end() - 2, text.end(), '=');
+        out.resize(static_cast<size_t>(length) - padding);
+        bytes.swap(out);
+        return true;
+    }
+}
+
+indiepub::PasswordHasher &indiepub::PasswordHasher::instance()
+{
+    static PasswordHasher hasher({fromEnvironment("INDIEBACK_PASSWORD_SCRYPT_LN", PASSWORD_SCRYPT_LN, MAX_LOG_N),
+                                  fromEnvironment("INDIEBACK_PASSWORD_SCRYPT_R", PASSWORD_SCRYPT_R),
+                                  fromEnvironment("INDIEBACK_PASSWORD_SCRYPT_P", PASSWORD_SCRYPT_P)});
+    return hasher;
+}
+
+indiepub::CryptoExecutor &indiepub::PasswordHasher::executor()
+{
+    // apart from the RSA pool: a login burst must not starve signature checks, and the reverse
+    static CryptoExecutor *pool = new CryptoExecutor(fromEnvironment("INDIEBACK_PASSWORD_HASH_THREADS", PASSWORD_HASH_THREADS),
+                                                     fromEnvironment("INDIEBACK_PASSWORD_HASH_QUEUE", PASSWORD_HASH_QUEUE));
+    return *pool;
+}
+
+indiepub::PasswordHasher::PasswordHasher(Params params) : params_(params)
+{
+    if (params_.log_n == 0 || params_.log_n > MAX_LOG_N || params_.r == 0 || params_.p == 0)
+        throw std::invalid_argument("Invalid scrypt parameters");
+}
+
+const indiepub::PasswordHasher::Params &indiepub::PasswordHasher::params() const
+{
+    return params_;
+}
+
+std::uint64_t indiepub::PasswordHasher::memory(const Params &params)
+{
+    return 128ULL * params.r * (1ULL << params.log_n);
+}
+
+bool indiepub::PasswordHasher::derive(const std::string &password, const std::string &salt, const Params &params, std::string &out)
+{
+    EVP_KDF *kdf = EVP_KDF_fetch(nullptr, "SCRYPT", nullptr);
+    EVP_KDF_CTX *ctx = kdf != nullptr ? EVP_KDF_CTX_new(kdf) : nullptr;
+    EVP_KDF_free(kdf);
+    if (ctx == nullptr)
+    {
+        LOG_ERROR << "scrypt is not available";
+        return false;
+    }
+    std::uint64_t n = 1ULL << params.log_n;
+    std::uint32_t r = params.r;
+    std::uint32_t p = params.p;
+    std::uint64_t maxmem = memory(params) + (1ULL << 20);
+    OSSL_PARAM kdfParams[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD, const_cast<char *>(password.data()), password.size()),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, const_cast<char *>(salt.data()), salt.size()),
+        OSSL_PARAM_construct_uint64(OSSL_KDF_PARAM_SCRYPT_N, &n),
+        OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_SCRYPT_R, &r),
+        OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_SCRYPT_P, &p),
+        OSSL_PARAM_construct_uint64(OSSL_KDF_PARAM_SCRYPT_MAXMEM, &maxmem),
+        OSSL_PARAM_construct_end()};
+    out.assign(HASH_SIZE, '\0');
+    bool ok = EVP_KDF_derive(ctx, reinterpret_cast<unsigned char *>(&out[0]), out.size(), kdfParams) == 1;
+    EVP_KDF_CTX_free(ctx);
+    if (!ok)
+        LOG_ERROR << "scrypt derivation failed";
+    return ok;
+}
+
+std::string indiepub::PasswordHasher::hash(const std::string &password) const
+{
+    std::string salt(SALT_SIZE, '\0');
+    std::string derived;
+    if (RAND_bytes(reinterpret_cast<unsigned char *>(&salt[0]), static_cast<int>(salt.size())) != 1 ||
+        !derive(password, salt, params_, derived))
+        throw std::runtime_error("Password hashing failed");
+    std::ostringstream out;
+    out << PREFIX << "ln=" << params_.log_n << ",r=" << params_.r << ",p=" << params_.p
+        << "$" << encode(salt) << "$" << encode(derived);
+    return out.str();
+}
+
+bool indiepub::PasswordHasher::parse(const std::string &stored, Params &params, std::string &salt, std::string &hash)
+{
+    if (stored.compare(0, std::strlen(PREFIX), PREFIX) != 0)
+        return false;
+    size_t costsEnd = stored.find('$', std::strlen(PREFIX));
+    size_t saltEnd = costsEnd == std::string::npos ? std::string::npos : stored.find('$', costsEnd + 1);
+    if (saltEnd == std::string::npos)
+        return false;
+    std::string costs = stored.substr(std::strlen(PREFIX), costsEnd - std::strlen(PREFIX));
+    unsigned int log_n = 0, r = 0, p = 0;
+    char tail = 0;
+    if (std::sscanf(costs.c_str(), "ln=%u,r=%u,p=%u%c", &log_n, &r, &p, &tail) != 3 ||
+        log_n == 0 || log_n > MAX_LOG_N || r == 0 || p == 0)
+        return false;
+    params = {log_n, r, p};
+    return decode(stored.substr(costsEnd + 1, saltEnd - costsEnd - 1), salt) &&
+           decode(stored.substr(saltEnd + 1), hash) && hash.size() == HASH_SIZE;
+}
+
+bool indiepub::PasswordHasher::verify(const std::string &password, const std::string &stored, bool &rehash) const
+{
+    rehash = false;
+    Params params;
+    std::string salt, expected;
+    if (!parse(stored, params, salt, expected))
+    {
+        std::string legacy = legacyHash(password);
+        if (stored.empty() || legacy.size() != stored.size() ||
+            CRYPTO_memcmp(legacy.data(), stored.data(), legacy.size()) != 0)
+            return false;
+        rehash = true;
+        return true;
+    }
+    std::string derived;
+    if (!derive(password, salt, params, derived) ||
+        CRYPTO_memcmp(derived.data(), expected.data(), HASH_SIZE) != 0)
+        return false;
+    rehash = !(params == params_);
+    return true;
+}
+
+std::string indiepub::PasswordHasher::legacyHash(const std::string &password)
+{
+    auto digest = Hash::sha256(password);
+    // stored hashes keep only as many digest bytes as the password has characters
+    return StringEncoder::bytesToHex(digest.data(), std::min(password.size(), digest.size()));
+}
@@ -0,0 +1,110 @@
+#include <backend/auth/SessionKeys.hpp>
+#include <backend/auth/SessionToken.hpp>
+#include <crypto/StringEncoder.hpp>
+#include <config.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr const char *TICKET_LABEL = "indieback session key ticket";
+
+    // keeps the ticket key independent from the key that signs session tokens
+    std::vector<unsigned char> deriveTicketKey(const std::vector<unsigned char> &secret)
+    {
+        std::vector<unsigned char> key(EVP_MAX_MD_SIZE);
+        unsigned int length = 0;
+        HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+             reinterpret_cast<const unsigned char *>(TICKET_LABEL), std::strlen(TICKET_LABEL), key.data(), &length);
+        key.resize(length);
+        return key;
+    }
+
+    SessionCipher ticketCipher(const std::vector<unsigned char> &secret)
+    {
+        return SessionCipher(deriveTicketKey(secret).data(), SessionCipher::KEY_SIZE);
+    }
+}
+
+indiepub::SessionKeys &indiepub::SessionKeys::instance()
+{
+    static SessionKeys keys(SessionToken::loadOrCreateKey(SessionToken::keyFile()), std::chrono::seconds(SESSION_KEY_TTL),
+                            SessionToken::loadRetiredKeys(SessionToken::keyFile()));
+    return keys;
+}
+
+indiepub::SessionKeys::SessionKeys(const std::vector<unsigned char> &secret, std::chrono::seconds ttl,
+                                   const std::vector<std::vector<unsigned char>> &retired)
+    : ttl_(ttl)
+{
+    rotate(secret, retired);
+}
+
+void indiepub::SessionKeys::rotate(const std::vector<unsigned char> &secret, const std::vector<std::vector<unsigned char>> &retired)
+{
+    auto tickets = std::make_shared<std::vector<SessionCipher>>();
+    tickets->push_back(ticketCipher(secret));
+    for (const auto &old : retired)
+        tickets->push_back(ticketCipher(old));
+    std::atomic_store(&tickets_, std::shared_ptr<const std::vector<SessionCipher>>(std::move(tickets)));
+}
+
+std::string indiepub::SessionKeys::establish(const std::string &key, std::time_t &expires_at) const
+{
+    return establish(key, expires_at, std::time(nullptr));
+}
+
+std::string indiepub::SessionKeys::establish(const std::string &key, std::time_t &expires_at, std::time_t now) const
+{
+    if (key.size() != SessionCipher::KEY_SIZE)
+        return "";
+    expires_at = now + ttl_.count();
+    std::string ticket = key;
+    std::int64_t expiry = static_cast<std::int64_t>(expires_at);
+    ticket.append(reinterpret_cast<const char *>(&expiry), sizeof(expiry));
+    std::string sealed = std::atomic_load(&tickets_)->front().seal(ticket);
+    if (sealed.empty())
+        return "";
+    return StringEncoder::bytesToHex(reinterpret_cast<const byte *>(sealed.data()), sealed.size());
+}
+
+std::optional<SessionCipher> indiepub::SessionKeys::find(const std::string &session_id) const
+{
+    return find(session_id, std::time(nullptr));
+}
+
+std::optional<SessionCipher> indiepub::SessionKeys::find(const std::string &session_id, std::time_t now) const
+{
+    constexpr size_t TICKET_SIZE = SessionCipher::KEY_SIZE + sizeof(std::int64_t);
+    if (session_id.size() != 2 * (SessionCipher::IV_SIZE + TICKET_SIZE + SessionCipher::TAG_SIZE))
+        return std::nullopt;
+    std::vector<byte> sealed;
+    try
+    {
+        sealed = StringEncoder::hexToBytes(session_id);
+    }
+    catch (const std::exception &)
+    {
+        return std::nullopt;
+    }
+    std::string message = StringEncoder::bytesToString(sealed.data(), sealed.size());
+    std::string ticket;
+    bool opened = false;
+    for (const auto &tickets : *std::atomic_load(&tickets_))
+    {
+        if (tickets.open(message, ticket))
+        {
+            opened = true;
+            break;
+        }
+    }
+    if (!opened || ticket.size() != TICKET_SIZE)
+        return std::nullopt;
+    std::int64_t expiry = 0;
+    std::memcpy(&expiry, ticket.data() + SessionCipher::KEY_SIZE, sizeof(expiry));
+    if (expiry <= static_cast<std::int64_t>(now))
+        return std::nullopt;
+    return SessionCipher(reinterpret_cast<const byte *>(ticket.data()), SessionCipher::KEY_SIZE);
+}
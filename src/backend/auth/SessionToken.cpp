@@ -0,0 +1,350 @@
+#include <backend/auth/SessionToken.hpp>
+#include <backend/Environment.hpp>
+#include <backend/cache/InvalidationBus.hpp>
+#include <crypto/StringEncoder.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr const char *PREFIX = "v1.";
+    constexpr size_t KEY_SIZE = 32;
+    constexpr size_t FIELDS = 7;
+
+    std::vector<std::string> split(const std::string &token)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (parts.size() < FIELDS)
+        {
+            size_t dot = token.find('.', start);
+            parts.push_back(token.substr(start, dot == std::string::npos ? std::string::npos : dot - start));
+            if (dot == std::string::npos)
+                break;
+            start = dot + 1;
+        }
+        return parts;
+    }
+
+    bool parseTime(const std::string &value, std::time_t &out)
+    {
+        if (value.empty() || value.size() > 19)
+            return false;
+        for (char c : value)
+        {
+            if (c < '0' || c > '9')
+                return false;
+        }
+        out = static_cast<std::time_t>(std::stoll(value));
+        return true;
+    }
+
+    std::string mac(const std::vector<unsigned char> &key, const std::string &payload)
+    {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+             reinterpret_cast<const unsigned char *>(payload.data()), payload.size(), digest, &length);
+        return StringEncoder::bytesToHex(digest, length);
+    }
+
+    std::string randomHex(size_t bytes)
+    {
+        std::vector<unsigned char> buffer(bytes);
+        if (RAND_bytes(buffer.data(), static_cast<int>(buffer.size())) != 1)
+            throw std::runtime_error("RAND_bytes failed");
+        return StringEncoder::bytesToHex(buffer.data(), buffer.size());
+    }
+}
+
+indiepub::SessionToken &indiepub::SessionToken::instance()
+{
+    static SessionToken *tokens = []() {
+        std::string path = keyFile();
+        auto *created = new SessionToken(loadOrCreateKey(path), std::chrono::seconds(SESSION_TOKEN_TTL), loadRetiredKeys(path));
+        size_t revoked = created->persistRevocations(revocationFile());
+        if (revoked > 0)
+            LOG_INFO << "Loaded " << revoked << " revoked session tokens";
+        // logouts in any process arrive as "<token_id>:<expires_at>"
+        InvalidationBus::instance().subscribe(EntityType::SESSION, [created](const ChangeEvent &event) {
+            size_t colon = event.key.find(':');
+            std::time_t expires_at = 0;
+            if (colon != std::string::npos && parseTime(event.key.substr(colon + 1), expires_at))
+                created->revoke(event.key.substr(0, colon), expires_at);
+        });
+        return created;
+    }();
+    return *tokens;
+}
+
+std::string indiepub::SessionToken::keyFile()
+{
+    return env::text("INDIEBACK_SESSION_KEY_FILE", SESSION_KEY_FILE);
+}
+
+std::string indiepub::SessionToken::revocationFile()
+{
+    return env::text("INDIEBACK_SESSION_REVOKED_FILE", SESSION_REVOKED_FILE);
+}
+
+std::vector<unsigned char> indiepub::SessionToken::loadOrCreateKey(const std::string &path)
+{
+    std::vector<unsigned char> key(KEY_SIZE);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd >= 0)
+    {
+        bool ok = RAND_bytes(key.data(), static_cast<int>(key.size())) == 1 &&
+                  write(fd, key.data(), key.size()) == static_cast<ssize_t>(key.size()) &&
+                  fsync(fd) == 0;
+        close(fd);
+        if (!ok)
+        {
+            unlink(path.c_str());
+            throw std::runtime_error("Cannot create session key " + path);
+        }
+        LOG_INFO << "Generated session key " << path;
+        return key;
+    }
+    if (errno != EEXIST)
+        throw std::runtime_error("Cannot create session key " + path + ": " + std::strerror(errno));
+    return loadKey(path);
+}
+
+std::vector<unsigned char> indiepub::SessionToken::loadKey(const std::string &path)
+{
+    std::vector<unsigned char> key(KEY_SIZE);
+    // another process may still be writing it
+    for (int attempt = 0; attempt < 50; ++attempt)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            break;
+        ssize_t length = read(fd, key.data(), key.size());
+        close(fd);
+        if (length == static_cast<ssize_t>(key.size()))
+            return key;
+        usleep(10000);
+    }
+    throw std::runtime_error("Session key " + path + " is missing, unreadable or truncated");
+}
+
+std::vector<std::vector<unsigned char>> indiepub::SessionToken::loadRetiredKeys(const std::string &path)
+{
+    std::filesystem::path current(path);
+    std::string prefix = current.filename().string() + ".";
+    std::vector<std::string> files;
+    std::error_code error;
+    std::filesystem::path directory = current.has_parent_path() ? current.parent_path() : std::filesystem::path(".");
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0)
+            files.push_back(entry.path().string());
+    }
+    std::sort(files.rbegin(), files.rend());
+
+    std::vector<std::vector<unsigned char>> keys;
+    for (const auto &file : files)
+    {
+        std::vector<unsigned char> key(KEY_SIZE + 1);
+        int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        ssize_t length = read(fd, key.data(), key.size());
+        close(fd);
+        if (length != static_cast<ssize_t>(KEY_SIZE))
+        {
+            LOG_WARN << "Ignoring retired session key " << file << ": not " << KEY_SIZE << " bytes";
+            continue;
+        }
+        key.resize(KEY_SIZE);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+indiepub::SessionToken::SessionToken(const std::vector<unsigned char> &key, std::chrono::seconds ttl,
+                                     const std::vector<std::vector<unsigned char>> &retired)
+    : ttl_(ttl)
+{
+    rotate(key, retired);
+}
+
+std::string indiepub::SessionToken::keyId(const std::vector<unsigned char> &key)
+{
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(key.data(), key.size(), digest, &length, EVP_sha256(), nullptr);
+    return StringEncoder::bytesToHex(digest, 4);
+}
+
+void indiepub::SessionToken::rotate(const std::vector<unsigned char> &key, const std::vector<std::vector<unsigned char>> &retired)
+{
+    auto keys = std::make_shared<Keys>();
+    keys->current_id = keyId(key);
+    keys->by_id[keys->current_id] = key;
+    for (const auto &old : retired)
+        keys->by_id.emplace(keyId(old), old);
+    std::shared_ptr<const Keys> previous = std::atomic_load(&keys_);
+    if (previous != nullptr && previous->current_id != keys->current_id)
+        LOG_INFO << "Session tokens now signed with key " << keys->current_id << ", " << keys->by_id.size() - 1 << " retired keys accepted";
+    std::atomic_store(&keys_, std::shared_ptr<const Keys>(std::move(keys)));
+}
+
+std::string indiepub::SessionToken::issue(const std::string &user_id) const
+{
+    return issue(user_id, std::time(nullptr));
+}
+
+std::string indiepub::SessionToken::issue(const std::string &user_id, std::time_t now) const
+{
+    if (user_id.empty() || user_id.find('.') != std::string::npos)
+        throw std::invalid_argument("user id cannot be placed in a session token");
+    std::shared_ptr<const Keys> keys = std::atomic_load(&keys_);
+    std::string payload = PREFIX + user_id + "." + std::to_string(now) + "." +
+                          std::to_string(now + ttl_.count()) + "." + keys->current_id + "." + randomHex(8);
+    return payload + "." + mac(keys->by_id.at(keys->current_id), payload);
+}
+
+bool indiepub::SessionToken::verify(const std::string &token, Claims &claims) const
+{
+    return verify(token, claims, std::time(nullptr));
+}
+
+bool indiepub::SessionToken::verify(const std::string &token, Claims &claims, std::time_t now) const
+{
+    if (!isSessionToken(token))
+        return false;
+    std::vector<std::string> parts = split(token);
+    if (parts.size() != FIELDS)
+        return false;
+    Claims parsed;
+    parsed.user_id = parts[1];
+    parsed.key_id = parts[4];
+    parsed.token_id = parts[5];
+    if (parsed.user_id.empty() || !parseTime(parts[2], parsed.issued_at) || !parseTime(parts[3], parsed.expires_at))
+        return false;
+    std::shared_ptr<const Keys> keys = std::atomic_load(&keys_);
+    auto key = keys->by_id.find(parsed.key_id);
+    if (key == keys->by_id.end())
+        return false;
+
+    std::string expected = mac(key->second, token.substr(0, token.size() - parts[6].size() - 1));
+    if (expected.size() != parts[6].size() || CRYPTO_memcmp(expected.data(), parts[6].data(), expected.size()) != 0)
+        return false;
+    if (parsed.expires_at <= now || isRevoked(parsed.token_id))
+        return false;
+    claims = parsed;
+    return true;
+}
+
+void indiepub::SessionToken::revoke(const std::string &token_id, std::time_t expires_at)
+{
+    std::time_t now = std::time(nullptr);
+    std::lock_guard<std::mutex> lock(mutex_);
+    // expired tokens fail verification on their own, no need to remember them
+    for (auto it = revoked_.begin(); it != revoked_.end();)
+    {
+        if (it->second <= now)
+            it = revoked_.erase(it);
+        else
+            ++it;
+    }
+    if (expires_at > now)
+        revoked_[token_id] = expires_at;
+}
+
+void indiepub::SessionToken::logout(const Claims &claims)
+{
+    revoke(claims.token_id, claims.expires_at);
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = revocation_path_;
+    }
+    if (!path.empty())
+    {
+        // one short O_APPEND write under the lock compaction takes, so no line is lost or torn
+        std::string line = claims.token_id + " " + std::to_string(claims.expires_at) + "\n";
+        int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        bool ok = fd >= 0 && flock(fd, LOCK_EX) == 0 &&
+                  write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size());
+        if (fd >= 0)
+            close(fd);
+        if (!ok)
+            LOG_ERROR << "Cannot record the revocation of session " << claims.token_id << " in " << path << ": " << std::strerror(errno);
+    }
+    InvalidationBus::instance().publish(EntityType::SESSION, claims.token_id + ":" + std::to_string(claims.expires_at));
+}
+
+size_t indiepub::SessionToken::persistRevocations(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0 || flock(fd, LOCK_EX) != 0)
+    {
+        LOG_ERROR << "Cannot open session revocations " << path << ": " << std::strerror(errno);
+        if (fd >= 0)
+            close(fd);
+        return 0;
+    }
+    std::string contents;
+    char buffer[4096];
+    for (ssize_t length; (length = read(fd, buffer, sizeof(buffer))) > 0;)
+        contents.append(buffer, static_cast<size_t>(length));
+
+    std::time_t now = std::time(nullptr);
+    std::unordered_map<std::string, std::time_t> live;
+    std::istringstream lines(contents);
+    std::string token_id;
+    std::string expires;
+    while (lines >> token_id >> expires)
+    {
+        std::time_t expires_at = 0;
+        if (parseTime(expires, expires_at) && expires_at > now)
+            live[token_id] = expires_at;
+    }
+    // rewritten in place, under the lock every writer takes
+    std::string compacted;
+    for (const auto &[id, expires_at] : live)
+        compacted += id + " " + std::to_string(expires_at) + "\n";
+    if (compacted.size() != contents.size() &&
+        (ftruncate(fd, 0) != 0 || pwrite(fd, compacted.data(), compacted.size(), 0) != static_cast<ssize_t>(compacted.size())))
+        LOG_WARN << "Cannot compact session revocations " << path << ": " << std::strerror(errno);
+    close(fd);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    revocation_path_ = path;
+    for (const auto &[id, expires_at] : live)
+        revoked_[id] = expires_at;
+    return live.size();
+}
+
+bool indiepub::SessionToken::isRevoked(const std::string &token_id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return revoked_.find(token_id) != revoked_.end();
+}
+
+std::string indiepub::SessionToken::keyId() const
+{
+    return std::atomic_load(&keys_)->current_id;
+}
+
+bool indiepub::SessionToken::isSessionToken(const std::string &token)
+{
+    return token.compare(0, std::strlen(PREFIX), PREFIX) == 0;
+}
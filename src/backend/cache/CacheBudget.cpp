@@ -0,0 +1,170 @@
+#include <backend/cache/CacheBudget.hpp>
+#include <backend/Environment.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+
+indiepub::CacheBudget &indiepub::CacheBudget::instance()
+{
+    // never destroyed: static caches withdraw from it during their own destruction
+    static CacheBudget *budget = new CacheBudget([]() {
+        return static_cast<size_t>(env::number("INDIEBACK_CACHE_BUDGET_MB", CACHE_MEMORY_BUDGET_MB, 0, SIZE_MAX >> 20)) * 1024 * 1024;
+    }());
+    return *budget;
+}
+
+indiepub::CacheBudget::CacheBudget(size_t total) : total_(total)
+{
+}
+
+indiepub::CacheBudget::~CacheBudget()
+{
+    stop();
+}
+
+void indiepub::CacheBudget::enroll(const std::string &name, std::shared_ptr<CacheAccount> account, double weight)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    members_.push_back({name, std::move(account), weight, 0, 0});
+    assignShares();
+}
+
+void indiepub::CacheBudget::withdraw(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    members_.erase(std::remove_if(members_.begin(), members_.end(), [&name](const Member &member) {
+        return member.name == name;
+    }), members_.end());
+    assignShares();
+}
+
+void indiepub::CacheBudget::assignShares()
+{
+    double weights = 0;
+    for (const auto &member : members_)
+        weights += member.weight;
+    for (auto &member : members_)
+    {
+        size_t limit = static_cast<size_t>(total_ * (member.weight / weights));
+        member.account->limit.store(limit, std::memory_order_relaxed);
+        if (member.account->bytes.load(std::memory_order_relaxed) > limit && member.account->trim)
+            member.account->trim();
+    }
+}
+
+bool indiepub::CacheBudget::rebalance()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (members_.size() < 2)
+        return false;
+
+    size_t step = total_ * CACHE_REBALANCE_STEP_PERCENT / 100;
+    size_t floor = total_ * CACHE_MIN_SHARE_PERCENT / 100;
+    Member *receiver = nullptr;
+    Member *donor = nullptr;
+    double receiverDensity = -1;
+    double donorDensity = 0;
+    std::vector<double> densities;
+    for (auto &member : members_)
+    {
+        CacheAccount &account = *member.account;
+        std::uint64_t hits = account.hits.load(std::memory_order_relaxed);
+        std::uint64_t evictions = account.evictions.load(std::memory_order_relaxed);
+        size_t bytes = std::max<size_t>(account.bytes.load(std::memory_order_relaxed), 1);
+        size_t limit = account.limit.load(std::memory_order_relaxed);
+        double density = static_cast<double>(hits - member.last_hits) / bytes;
+        // only a cache that is evicting or nearly full can make use of more memory
+        bool starved = evictions > member.last_evictions || bytes >= limit / 10 * 9;
+        member.last_hits = hits;
+        member.last_evictions = evictions;
+
+        if (starved && density > receiverDensity)
+        {
+            receiver = &member;
+            receiverDensity = density;
+        }
+        if (limit >= floor + step && (donor == nullptr || density < donorDensity))
+        {
+            donor = &member;
+            donorDensity = density;
+        }
+    }
+    if (receiver == nullptr || donor == nullptr || receiver == donor || donorDensity >= receiverDensity)
+        return false;
+
+    donor->account->limit.fetch_sub(step, std::memory_order_relaxed);
+    receiver->account->limit.fetch_add(step, std::memory_order_relaxed);
+    if (donor->account->trim)
+        donor->account->trim();
+    LOG_DEBUG << "Cache budget moved " << step << " bytes from " << donor->name << " to " << receiver->name;
+    return true;
+}
+
+void indiepub::CacheBudget::start(std::chrono::seconds interval)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (worker_.joinable() || interval.count() <= 0)
+        return;
+    stopping_ = false;
+    worker_ = std::thread([this, interval]() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval, [this]() { return stopping_; }))
+        {
+            lock.unlock();
+            rebalance();
+            lock.lock();
+        }
+    });
+}
+
+void indiepub::CacheBudget::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+size_t indiepub::CacheBudget::total() const
+{
+    return total_;
+}
+
+std::vector<indiepub::CacheBudget::Gauge> indiepub::CacheBudget::gauges() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Gauge> gauges;
+    for (const auto &member : members_)
+    {
+        const CacheAccount &account = *member.account;
+        gauges.push_back({member.name, account.bytes.load(), account.limit.load(), account.entries.load(),
+                          account.hits.load(), account.misses.load(), account.evictions.load()});
+    }
+    return gauges;
+}
+
+std::string indiepub::CacheBudget::exposition() const
+{
+    std::ostringstream out;
+    out << "# TYPE indieback_cache_budget_bytes gauge\n";
+    out << "indieback_cache_budget_bytes " << total_ << "\n";
+    auto gauges = this->gauges();
+    auto series = [&out, &gauges](const char *metric, const char *type, auto field) {
+        out << "# TYPE " << metric << " " << type << "\n";
+        for (const auto &gauge : gauges)
+            out << metric << "{cache=\"" << gauge.name << "\"} " << field(gauge) << "\n";
+    };
+    series("indieback_cache_bytes", "gauge", [](const Gauge &g) { return g.bytes; });
+    series("indieback_cache_limit_bytes", "gauge", [](const Gauge &g) { return g.limit; });
+    series("indieback_cache_entries", "gauge", [](const Gauge &g) { return g.entries; });
+    series("indieback_cache_hits_total", "counter", [](const Gauge &g) { return g.hits; });
+    series("indieback_cache_misses_total", "counter", [](const Gauge &g) { return g.misses; });
+    series("indieback_cache_evictions_total", "counter", [](const Gauge &g) { return g.evictions; });
+    return out.str();
+}
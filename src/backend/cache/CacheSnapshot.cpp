@@ -0,0 +1,208 @@
+#include <backend/cache/CacheSnapshot.hpp>
+#include <util/logging/Log.hpp>
+#include <zlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    constexpr std::uint32_t MAGIC = 0x49425331; // "IBS1"
+    // tolerate small clock steps between the writer and the reader
+    constexpr std::int64_t MAX_CLOCK_SKEW = 60;
+
+    struct FileHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::int64_t created_at;
+        std::uint32_t sections;
+        std::uint32_t crc;
+        std::uint64_t body_length;
+    };
+
+    static_assert(sizeof(FileHeader) == 32, "snapshot header must not contain padding");
+
+    void putU32(std::string &out, std::uint32_t value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    bool takeU32(std::string_view &in, std::uint32_t &value)
+    {
+        if (in.size() < sizeof(value))
+            return false;
+        std::memcpy(&value, in.data(), sizeof(value));
+        in.remove_prefix(sizeof(value));
+        return true;
+    }
+
+    bool takeString(std::string_view &in, std::string_view &value)
+    {
+        std::uint32_t length = 0;
+        if (!takeU32(in, length) || in.size() < length)
+            return false;
+        value = in.substr(0, length);
+        in.remove_prefix(length);
+        return true;
+    }
+
+    bool writeAll(int fd, const char *data, size_t length)
+    {
+        while (length > 0)
+        {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            data += written;
+            length -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}
+
+bool indiepub::CacheSnapshot::write(const std::string &path, const std::vector<Section> &sections)
+{
+    std::string body;
+    for (const auto &section : sections)
+    {
+        body.push_back(static_cast<char>(section.entity));
+        putU32(body, static_cast<std::uint32_t>(section.entries.size()));
+        for (const auto &entry : section.entries)
+        {
+            putU32(body, static_cast<std::uint32_t>(entry.first.size()));
+            body.append(entry.first);
+            putU32(body, static_cast<std::uint32_t>(entry.second.size()));
+            body.append(entry.second);
+        }
+    }
+
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = FORMAT_VERSION;
+    header.created_at = static_cast<std::int64_t>(std::time(nullptr));
+    header.sections = static_cast<std::uint32_t>(sections.size());
+    header.crc = static_cast<std::uint32_t>(crc32(0L, reinterpret_cast<const Bytef *>(body.data()), static_cast<uInt>(body.size())));
+    header.body_length = body.size();
+
+    // auth tokens are part of the snapshot, keep it private to the service user
+    std::string tmp = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        LOG_ERROR << "Cannot create cache snapshot " << tmp << ": " << std::strerror(errno);
+        return false;
+    }
+    bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) &&
+              writeAll(fd, body.data(), body.size()) &&
+              fsync(fd) == 0;
+    close(fd);
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        LOG_ERROR << "Writing cache snapshot " << path << " failed: " << std::strerror(errno);
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<indiepub::CacheSnapshot> indiepub::CacheSnapshot::open(const std::string &path, std::chrono::seconds max_age)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader))
+    {
+        LOG_ERROR << "Cache snapshot " << path << " is truncated";
+        close(fd);
+        return nullptr;
+    }
+    size_t length = static_cast<size_t>(st.st_size);
+    void *base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        LOG_ERROR << "Mapping cache snapshot " << path << " failed: " << std::strerror(errno);
+        return nullptr;
+    }
+    std::unique_ptr<CacheSnapshot> snapshot(new CacheSnapshot(base, length));
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != MAGIC || header.version != FORMAT_VERSION)
+    {
+        LOG_INFO << "Ignoring cache snapshot " << path << " from another format version";
+        return nullptr;
+    }
+    if (header.body_length != length - sizeof(FileHeader))
+    {
+        LOG_ERROR << "Cache snapshot " << path << " has an inconsistent length";
+        return nullptr;
+    }
+    std::int64_t age = static_cast<std::int64_t>(std::time(nullptr)) - header.created_at;
+    if (age > max_age.count() || age < -MAX_CLOCK_SKEW)
+    {
+        LOG_INFO << "Ignoring cache snapshot " << path << " written " << age << "s ago";
+        return nullptr;
+    }
+    const Bytef *body = static_cast<const Bytef *>(base) + sizeof(FileHeader);
+    uLong crc = crc32(0L, body, static_cast<uInt>(header.body_length));
+    if (static_cast<std::uint32_t>(crc) != header.crc)
+    {
+        LOG_ERROR << "Cache snapshot " << path << " failed its checksum";
+        return nullptr;
+    }
+    return snapshot;
+}
+
+indiepub::CacheSnapshot::CacheSnapshot(void *base, size_t length) : base_(base), length_(length)
+{
+}
+
+indiepub::CacheSnapshot::~CacheSnapshot()
+{
+    munmap(base_, length_);
+}
+
+size_t indiepub::CacheSnapshot::forEach(EntityType entity, const Visitor &visitor) const
+{
+    FileHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    std::string_view body(static_cast<const char *>(base_) + sizeof(FileHeader), length_ - sizeof(FileHeader));
+
+    size_t visited = 0;
+    for (std::uint32_t s = 0; s < header.sections && !body.empty(); ++s)
+    {
+        EntityType type = static_cast<EntityType>(body.front());
+        body.remove_prefix(1);
+        std::uint32_t count = 0;
+        if (!takeU32(body, count))
+            break;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::string_view key, value;
+            if (!takeString(body, key) || !takeString(body, value))
+                return visited;
+            if (type == entity)
+            {
+                visitor(key, value);
+                ++visited;
+            }
+        }
+    }
+    return visited;
+}
+
+std::time_t indiepub::CacheSnapshot::createdAt() const
+{
+    FileHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    return static_cast<std::time_t>(header.created_at);
+}
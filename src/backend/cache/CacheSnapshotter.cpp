@@ -0,0 +1,79 @@
+#include <backend/cache/CacheSnapshotter.hpp>
+#include <backend/Environment.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+
+indiepub::CacheSnapshotter::Options indiepub::CacheSnapshotter::Options::fromEnvironment()
+{
+    Options options;
+    options.path = env::text("INDIEBACK_SNAPSHOT_PATH", CACHE_SNAPSHOT_PATH);
+    options.interval = env::seconds("INDIEBACK_SNAPSHOT_INTERVAL", CACHE_SNAPSHOT_INTERVAL);
+    options.max_age = env::seconds("INDIEBACK_SNAPSHOT_MAX_AGE", CACHE_SNAPSHOT_MAX_AGE);
+    return options;
+}
+
+indiepub::CacheSnapshotter::CacheSnapshotter(const Options &options) : options_(options)
+{
+}
+
+indiepub::CacheSnapshotter::~CacheSnapshotter()
+{
+    stop();
+}
+
+size_t indiepub::CacheSnapshotter::start(Revalidator revalidator)
+{
+    if (options_.path.empty() || worker_.joinable())
+        return 0;
+    Caches::Restored restored = Caches::loadSnapshot(options_.path, options_.max_age);
+    size_t count = restored.size();
+    worker_ = std::thread(&CacheSnapshotter::run, this, std::move(restored), std::move(revalidator));
+    return count;
+}
+
+void indiepub::CacheSnapshotter::stop()
+{
+    if (!worker_.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+    saveNow();
+}
+
+bool indiepub::CacheSnapshotter::saveNow()
+{
+    if (options_.path.empty())
+        return false;
+    // the temporary file is named per process
+    std::lock_guard<std::mutex> lock(save_mutex_);
+    return Caches::saveSnapshot(options_.path);
+}
+
+void indiepub::CacheSnapshotter::run(Caches::Restored restored, Revalidator revalidator)
+{
+    // restored entries are already being served; bring them up to date before anything else
+    if (restored.size() > 0 && revalidator)
+    {
+        revalidator(restored);
+        LOG_INFO << "Revalidated " << restored.size() << " restored cache entries";
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        if (options_.interval.count() <= 0)
+        {
+            wake_.wait(lock, [this]() { return stopping_; });
+            break;
+        }
+        if (wake_.wait_for(lock, options_.interval, [this]() { return stopping_; }))
+            break;
+        lock.unlock();
+        saveNow();
+        lock.lock();
+    }
+}
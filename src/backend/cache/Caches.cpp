@@ -0,0 +1,145 @@
+#include <backend/cache/Caches.hpp>
+#include <backend/Environment.hpp>
+#include <backend/cache/CacheSnapshot.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <cstdlib>
+
+namespace
+{
+    template <typename V>
+    indiepub::CacheSnapshot::Section snapshotSection(indiepub::EntityType entity, const indiepub::EntityCache<V> &cache)
+    {
+        indiepub::CacheSnapshot::Section section{entity, {}};
+        for (const auto &entry : cache.entries())
+        {
+            std::string bytes;
+            indiepub::EntityCodec::encode(entry.second, bytes);
+            section.entries.emplace_back(entry.first, std::move(bytes));
+        }
+        return section;
+    }
+
+    template <typename V>
+    std::vector<std::string> restoreSection(const indiepub::CacheSnapshot &snapshot, indiepub::EntityType entity, indiepub::EntityCache<V> &cache)
+    {
+        std::vector<std::string> keys;
+        snapshot.forEach(entity, [&](std::string_view key, std::string_view bytes) {
+            V value;
+            if (!indiepub::EntityCodec::decode(bytes, value))
+                return;
+            keys.emplace_back(key);
+            cache.put(keys.back(), value);
+        });
+        return keys;
+    }
+}
+
+indiepub::EntityCache<indiepub::Credentials> &indiepub::Caches::auth()
+{
+    static EntityCache<Credentials> cache(
+        EntityType::CREDENTIALS,
+        AUTH_CACHE_CAPACITY,
+        std::chrono::seconds(AUTH_CACHE_TTL),
+        [](const Credentials &creds, const std::string &user_id) { return creds.user_id() == user_id; });
+    static const bool enrolled = cache.enroll(CacheBudget::instance(), "auth", AUTH_CACHE_WEIGHT);
+    (void)enrolled;
+    return cache;
+}
+
+indiepub::EntityCache<indiepub::User> &indiepub::Caches::users()
+{
+    static EntityCache<User> cache(EntityType::USER, USER_CACHE_CAPACITY, std::chrono::seconds(USER_CACHE_TTL));
+    static const bool enrolled = cache.enroll(CacheBudget::instance(), "users", USER_CACHE_WEIGHT);
+    (void)enrolled;
+    return cache;
+}
+
+indiepub::EntityCache<indiepub::Venue> &indiepub::Caches::venues()
+{
+    static EntityCache<Venue> cache(EntityType::VENUE, VENUE_CACHE_CAPACITY, std::chrono::seconds(VENUE_CACHE_TTL));
+    static const bool enrolled = cache.enroll(CacheBudget::instance(), "venues", VENUE_CACHE_WEIGHT);
+    (void)enrolled;
+    return cache;
+}
+
+indiepub::EntityCache<std::vector<indiepub::EventByVenue>> &indiepub::Caches::eventCatalog()
+{
+    static EntityCache<std::vector<EventByVenue>> cache(
+        EntityType::EVENT,
+        2,
+        std::chrono::seconds(EVENT_CATALOG_TTL),
+        [](const std::vector<EventByVenue> &, const std::string &) { return true; });
+    static const bool enrolled = cache.enroll(CacheBudget::instance(), "event_catalog", EVENT_CATALOG_WEIGHT);
+    (void)enrolled;
+    return cache;
+}
+
+indiepub::EntityCache<std::string> &indiepub::Caches::eventFeeds()
+{
+    static EntityCache<std::string> cache(
+        EntityType::EVENT,
+        6,
+        std::chrono::seconds(EVENT_CATALOG_TTL),
+        [](const std::string &, const std::string &) { return true; });
+    static const bool enrolled = cache.enroll(CacheBudget::instance(), "event_feeds", EVENT_CATALOG_WEIGHT);
+    (void)enrolled;
+    return cache;
+}
+
+std::unique_ptr<indiepub::SharedCache> &indiepub::Caches::segment()
+{
+    static std::unique_ptr<SharedCache> segment;
+    return segment;
+}
+
+indiepub::SharedCache *indiepub::Caches::shared()
+{
+    return segment().get();
+}
+
+bool indiepub::Caches::enableShared()
+{
+    if (env::text("INDIEBACK_SHARED_CACHE", SHARED_CACHE_ENABLED) != "on")
+        return false;
+    if (segment())
+        return true;
+    segment() = SharedCache::open(env::text("INDIEBACK_SHARED_CACHE_NAME", SHARED_CACHE_NAME), SHARED_CACHE_SLOTS, SHARED_CACHE_VALUE_SIZE);
+    if (!segment())
+        return false;
+    SharedCache *shared = segment().get();
+    auth().attachShared(shared, [](const Credentials &creds, const std::string &) { return creds.user_id(); });
+    users().attachShared(shared);
+    venues().attachShared(shared);
+    // larger catalogs do not fit a slot and stay process-local
+    eventCatalog().attachShared(shared, [](const std::vector<EventByVenue> &, const std::string &) { return std::string(); });
+    LOG_INFO << "Shared cache segment attached";
+    return true;
+}
+
+size_t indiepub::Caches::Restored::size() const
+{
+    return auth.size() + venues.size() + events.size();
+}
+
+bool indiepub::Caches::saveSnapshot(const std::string &path)
+{
+    std::vector<CacheSnapshot::Section> sections;
+    sections.push_back(snapshotSection(EntityType::CREDENTIALS, auth()));
+    sections.push_back(snapshotSection(EntityType::VENUE, venues()));
+    sections.push_back(snapshotSection(EntityType::EVENT, eventCatalog()));
+    return CacheSnapshot::write(path, sections);
+}
+
+indiepub::Caches::Restored indiepub::Caches::loadSnapshot(const std::string &path, std::chrono::seconds max_age)
+{
+    Restored restored;
+    auto snapshot = CacheSnapshot::open(path, max_age);
+    if (!snapshot)
+        return restored;
+    restored.auth = restoreSection(*snapshot, EntityType::CREDENTIALS, auth());
+    restored.venues = restoreSection(*snapshot, EntityType::VENUE, venues());
+    restored.events = restoreSection(*snapshot, EntityType::EVENT, eventCatalog());
+    LOG_INFO << "Restored " << restored.size() << " cache entries from " << path;
+    return restored;
+}
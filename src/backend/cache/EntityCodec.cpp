@@ -0,0 +1,209 @@
+#include <backend/cache/EntityCodec.hpp>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    void putU32(std::string &out, std::uint32_t value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void putI64(std::string &out, std::int64_t value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void putDouble(std::string &out, double value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void putString(std::string &out, const std::string &value)
+    {
+        putU32(out, static_cast<std::uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    struct Reader
+    {
+        std::string_view in;
+        bool ok = true;
+
+        template <typename T>
+        T fixed()
+        {
+            T value{};
+            if (in.size() < sizeof(T))
+            {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, in.data(), sizeof(T));
+            in.remove_prefix(sizeof(T));
+            return value;
+        }
+
+        std::string string()
+        {
+            std::uint32_t length = fixed<std::uint32_t>();
+            if (!ok || in.size() < length)
+            {
+                ok = false;
+                return std::string();
+            }
+            std::string value(in.substr(0, length));
+            in.remove_prefix(length);
+            return value;
+        }
+
+        bool done() const
+        {
+            return ok && in.empty();
+        }
+    };
+}
+
+void indiepub::EntityCodec::encode(const User &user, std::string &out)
+{
+    putString(out, user.user_id());
+    putString(out, user.email());
+    putString(out, user.role());
+    putString(out, user.name());
+    putI64(out, user.created_at());
+    putString(out, user.bio());
+    putString(out, user.profile_picture());
+    auto links = user.social_links();
+    putU32(out, static_cast<std::uint32_t>(links.size()));
+    for (const auto &link : links)
+        putString(out, link);
+}
+
+void indiepub::EntityCodec::encode(const Venue &venue, std::string &out)
+{
+    putString(out, venue.venue_id());
+    putString(out, venue.owner_id());
+    putString(out, venue.name());
+    putString(out, venue.location());
+    putI64(out, venue.capacity());
+    putI64(out, venue.created_at());
+}
+
+void indiepub::EntityCodec::encode(const Credentials &creds, std::string &out)
+{
+    putString(out, creds.user_id());
+    putString(out, creds.auth_token());
+    putString(out, creds.pw_hash());
+}
+
+void indiepub::EntityCodec::encode(const EventByVenue &event, std::string &out)
+{
+    putString(out, event.event_id());
+    putString(out, event.venue_id());
+    putString(out, event.band_id());
+    putString(out, event.creator_id());
+    putString(out, event.name());
+    putI64(out, event.date());
+    putDouble(out, event.price());
+    putI64(out, event.capacity());
+    putI64(out, event.sold());
+}
+
+void indiepub::EntityCodec::encode(const std::vector<EventByVenue> &events, std::string &out)
+{
+    putU32(out, static_cast<std::uint32_t>(events.size()));
+    std::string item;
+    for (const auto &event : events)
+    {
+        item.clear();
+        encode(event, item);
+        putString(out, item);
+    }
+}
+
+bool indiepub::EntityCodec::decode(std::string_view in, User &user)
+{
+    Reader reader{in};
+    std::string user_id = reader.string();
+    std::string email = reader.string();
+    std::string role = reader.string();
+    std::string name = reader.string();
+    std::time_t created_at = reader.fixed<std::int64_t>();
+    std::string bio = reader.string();
+    std::string profile_picture = reader.string();
+    std::uint32_t count = reader.fixed<std::uint32_t>();
+    std::vector<std::string> links;
+    for (std::uint32_t i = 0; reader.ok && i < count; ++i)
+        links.push_back(reader.string());
+    if (!reader.done())
+        return false;
+    user = User(user_id, email, role, name, created_at);
+    user.bio(bio);
+    user.profile_picture(profile_picture);
+    user.social_links(links);
+    return true;
+}
+
+bool indiepub::EntityCodec::decode(std::string_view in, Venue &venue)
+{
+    Reader reader{in};
+    std::string venue_id = reader.string();
+    std::string owner_id = reader.string();
+    std::string name = reader.string();
+    std::string location = reader.string();
+    long capacity = reader.fixed<std::int64_t>();
+    std::time_t created_at = reader.fixed<std::int64_t>();
+    if (!reader.done())
+        return false;
+    venue = Venue(venue_id, owner_id, name, location, capacity, created_at);
+    return true;
+}
+
+bool indiepub::EntityCodec::decode(std::string_view in, Credentials &creds)
+{
+    Reader reader{in};
+    std::string user_id = reader.string();
+    std::string auth_token = reader.string();
+    std::string pw_hash = reader.string();
+    if (!reader.done())
+        return false;
+    creds = Credentials(user_id, auth_token, pw_hash);
+    return true;
+}
+
+bool indiepub::EntityCodec::decode(std::string_view in, EventByVenue &event)
+{
+    Reader reader{in};
+    std::string event_id = reader.string();
+    std::string venue_id = reader.string();
+    std::string band_id = reader.string();
+    std::string creator_id = reader.string();
+    std::string name = reader.string();
+    std::time_t date = reader.fixed<std::int64_t>();
+    double price = reader.fixed<double>();
+    int capacity = static_cast<int>(reader.fixed<std::int64_t>());
+    int sold = static_cast<int>(reader.fixed<std::int64_t>());
+    if (!reader.done())
+        return false;
+    event = EventByVenue(event_id, venue_id, band_id, creator_id, name, date, price, capacity, sold);
+    return true;
+}
+
+bool indiepub::EntityCodec::decode(std::string_view in, std::vector<EventByVenue> &events)
+{
+    Reader reader{in};
+    std::uint32_t count = reader.fixed<std::uint32_t>();
+    std::vector<EventByVenue> decoded;
+    for (std::uint32_t i = 0; reader.ok && i < count; ++i)
+    {
+        std::string item = reader.string();
+        EventByVenue event;
+        if (!reader.ok || !decode(item, event))
+            return false;
+        decoded.push_back(event);
+    }
+    if (!reader.done())
+        return false;
+    events = std::move(decoded);
+    return true;
+}
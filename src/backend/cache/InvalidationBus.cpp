@@ -0,0 +1,75 @@
+#include <backend/cache/InvalidationBus.hpp>
+#include <util/logging/Log.hpp>
+#include <exception>
+
+indiepub::InvalidationBus &indiepub::InvalidationBus::instance()
+{
+    static InvalidationBus bus;
+    return bus;
+}
+
+size_t indiepub::InvalidationBus::subscribe(EntityType entity, Listener listener)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto next = std::make_shared<Subscriptions>(*subscriptions_);
+    size_t id = next_id_++;
+    next->push_back({id, entity, std::move(listener)});
+    subscriptions_ = next;
+    return id;
+}
+
+void indiepub::InvalidationBus::unsubscribe(size_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto next = std::make_shared<Subscriptions>();
+    next->reserve(subscriptions_->size());
+    for (const auto &subscription : *subscriptions_)
+    {
+        if (subscription.id != id)
+            next->push_back(subscription);
+    }
+    subscriptions_ = next;
+}
+
+std::uint64_t indiepub::InvalidationBus::publish(EntityType entity, const std::string &key)
+{
+    ChangeEvent event{entity, key, version_.fetch_add(1) + 1};
+    dispatch(event);
+    return event.version;
+}
+
+void indiepub::InvalidationBus::dispatch(const ChangeEvent &event)
+{
+    // keep the local version ahead of anything we have seen so stale loads are detectable
+    std::uint64_t current = version_.load();
+    while (current < event.version && !version_.compare_exchange_weak(current, event.version))
+    {
+    }
+
+    // listeners run without the lock so they may subscribe or unsubscribe themselves
+    auto subscriptions = snapshot();
+    for (const auto &subscription : *subscriptions)
+    {
+        if (subscription.entity != EntityType::ANY && event.entity != EntityType::ANY && subscription.entity != event.entity)
+            continue;
+        try
+        {
+            subscription.listener(event);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "Invalidation listener failed: " << e.what();
+        }
+    }
+}
+
+std::uint64_t indiepub::InvalidationBus::version() const
+{
+    return version_.load();
+}
+
+std::shared_ptr<const indiepub::InvalidationBus::Subscriptions> indiepub::InvalidationBus::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscriptions_;
+}
@@ -0,0 +1,375 @@
+#include <backend/cache/InvalidationChannel.hpp>
+#include <backend/Environment.hpp>
+#include <util/logging/Log.hpp>
+#include <config.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::uint32_t MAGIC = 0x49425631; // "IBV1"
+    constexpr size_t HEADER_SIZE = 4 + 1 + 1 + 2 + 8 + 8 + 8;
+    constexpr size_t MAX_KEY_SIZE = 1024;
+    constexpr size_t MAX_DATAGRAM = HEADER_SIZE + MAX_KEY_SIZE;
+
+    // set while a remote event is re-published locally so it is not echoed back out
+    thread_local bool applying_remote = false;
+
+    template <typename T>
+    void put(std::string &out, T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    T take(const char *&in)
+    {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+}
+
+indiepub::InvalidationChannel::Options indiepub::InvalidationChannel::Options::fromEnvironment()
+{
+    Options options;
+    std::string transport = env::text("INDIEBACK_INVALIDATION_TRANSPORT", INVALIDATION_TRANSPORT);
+    if (transport == "unix")
+        options.transport = Transport::UNIX;
+    else if (transport == "multicast")
+        options.transport = Transport::MULTICAST;
+    else if (transport == "off")
+        options.transport = Transport::OFF;
+    else
+        throw std::invalid_argument("INDIEBACK_INVALIDATION_TRANSPORT=" + transport + ": expected unix, multicast or off");
+    options.socket_dir = env::text("INDIEBACK_INVALIDATION_DIR", INVALIDATION_SOCKET_DIR);
+    options.group = env::text("INDIEBACK_INVALIDATION_GROUP", INVALIDATION_MCAST_GROUP);
+    options.port = static_cast<int>(env::number("INDIEBACK_INVALIDATION_PORT", INVALIDATION_MCAST_PORT, 1, 65535));
+    options.heartbeat = env::milliseconds("INDIEBACK_INVALIDATION_HEARTBEAT_MS", INVALIDATION_HEARTBEAT_MS);
+    return options;
+}
+
+indiepub::InvalidationChannel::InvalidationChannel(const Options &options) : options_(options)
+{
+    std::random_device rd;
+    sender_ = (static_cast<std::uint64_t>(rd()) << 32) ^ rd() ^ static_cast<std::uint64_t>(getpid());
+}
+
+indiepub::InvalidationChannel::~InvalidationChannel()
+{
+    stop();
+}
+
+bool indiepub::InvalidationChannel::start()
+{
+    if (running_ || options_.transport == Transport::OFF)
+        return running_;
+
+    bool opened = options_.transport == Transport::UNIX ? openUnix() : openMulticast();
+    if (!opened)
+    {
+        if (fd_ >= 0)
+            close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    subscription_ = InvalidationBus::instance().subscribe(EntityType::ANY, [this](const ChangeEvent &event) {
+        forward(event);
+    });
+    receiver_ = std::thread(&InvalidationChannel::receiveLoop, this);
+    LOG_INFO << "Invalidation channel started, sender " << sender_;
+    return true;
+}
+
+void indiepub::InvalidationChannel::stop()
+{
+    if (!running_.exchange(false))
+        return;
+    InvalidationBus::instance().unsubscribe(subscription_);
+    if (receiver_.joinable())
+        receiver_.join();
+    close(fd_);
+    fd_ = -1;
+    if (!socket_path_.empty())
+        unlink(socket_path_.c_str());
+}
+
+bool indiepub::InvalidationChannel::running() const
+{
+    return running_;
+}
+
+indiepub::InvalidationChannel::Stats indiepub::InvalidationChannel::stats() const
+{
+    return {sent_.load(), received_.load(), gaps_.load(), flushes_.load()};
+}
+
+std::uint64_t indiepub::InvalidationChannel::senderId() const
+{
+    return sender_;
+}
+
+std::string indiepub::InvalidationChannel::encode(const Message &message)
+{
+    // host byte order: both ends always run on the same machine
+    std::string out;
+    size_t key_len = std::min(message.event.key.size(), MAX_KEY_SIZE);
+    out.reserve(HEADER_SIZE + key_len);
+    put<std::uint32_t>(out, MAGIC);
+    put<std::uint8_t>(out, static_cast<std::uint8_t>(message.kind));
+    put<std::uint8_t>(out, static_cast<std::uint8_t>(message.event.entity));
+    put<std::uint16_t>(out, static_cast<std::uint16_t>(key_len));
+    put<std::uint64_t>(out, message.sender);
+    put<std::uint64_t>(out, message.sequence);
+    put<std::uint64_t>(out, message.event.version);
+    out.append(message.event.key, 0, key_len);
+    return out;
+}
+
+bool indiepub::InvalidationChannel::decode(const char *data, size_t length, Message &message)
+{
+    if (length < HEADER_SIZE)
+        return false;
+    const char *in = data;
+    if (take<std::uint32_t>(in) != MAGIC)
+        return false;
+    std::uint8_t kind = take<std::uint8_t>(in);
+    std::uint8_t entity = take<std::uint8_t>(in);
+    std::uint16_t key_len = take<std::uint16_t>(in);
+    if (kind < static_cast<std::uint8_t>(Kind::INVALIDATE) || kind > static_cast<std::uint8_t>(Kind::HEARTBEAT))
+        return false;
+    if (entity > static_cast<std::uint8_t>(EntityType::ANY) || HEADER_SIZE + key_len != length)
+        return false;
+    message.kind = static_cast<Kind>(kind);
+    message.event.entity = static_cast<EntityType>(entity);
+    message.sender = take<std::uint64_t>(in);
+    message.sequence = take<std::uint64_t>(in);
+    message.event.version = take<std::uint64_t>(in);
+    message.event.key.assign(in, key_len);
+    return true;
+}
+
+bool indiepub::InvalidationChannel::openUnix()
+{
+    std::error_code ec;
+    std::filesystem::create_directories(options_.socket_dir, ec);
+    socket_path_ = options_.socket_dir + "/" + std::to_string(getpid()) + ".sock";
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path_.size() >= sizeof(addr.sun_path))
+    {
+        LOG_ERROR << "Invalidation socket path too long: " << socket_path_;
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+
+    fd_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0)
+    {
+        LOG_ERROR << "Invalidation socket creation failed: " << std::strerror(errno);
+        return false;
+    }
+    unlink(socket_path_.c_str());
+    if (bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        LOG_ERROR << "Invalidation socket bind failed: " << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool indiepub::InvalidationChannel::openMulticast()
+{
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0)
+    {
+        LOG_ERROR << "Invalidation socket creation failed: " << std::strerror(errno);
+        return false;
+    }
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        LOG_ERROR << "Invalidation socket bind failed: " << std::strerror(errno);
+        return false;
+    }
+
+    ip_mreq membership{};
+    if (inet_pton(AF_INET, options_.group.c_str(), &membership.imr_multiaddr) != 1)
+    {
+        LOG_ERROR << "Invalid multicast group: " << options_.group;
+        return false;
+    }
+    membership.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+    {
+        LOG_ERROR << "Joining multicast group failed: " << std::strerror(errno);
+        return false;
+    }
+    unsigned char ttl = 0;
+    unsigned char loop = 1;
+    setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    return true;
+}
+
+void indiepub::InvalidationChannel::forward(const ChangeEvent &event)
+{
+    if (applying_remote || !running_)
+        return;
+    send(Kind::INVALIDATE, event);
+}
+
+void indiepub::InvalidationChannel::send(Kind kind, const ChangeEvent &event)
+{
+    // numbered and sent under one lock, so peers get the sequence in order and never see a
+    // heartbeat ahead of the INVALIDATE it counts
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (kind == Kind::INVALIDATE)
+        ++sequence_;
+    std::string datagram = encode({kind, sender_, sequence_, event});
+    if (options_.transport == Transport::MULTICAST)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(options_.port));
+        inet_pton(AF_INET, options_.group.c_str(), &addr.sin_addr);
+        if (sendto(fd_, datagram.data(), datagram.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+            LOG_ERROR << "Invalidation multicast send failed: " << std::strerror(errno);
+        sent_++;
+        return;
+    }
+
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(options_.socket_dir, ec))
+    {
+        std::string path = entry.path().string();
+        if (path == socket_path_ || entry.path().extension() != ".sock" || path.size() >= sizeof(sockaddr_un::sun_path))
+            continue;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (sendto(fd_, datagram.data(), datagram.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+        {
+            // nobody is bound there any more; a full buffer (EAGAIN) surfaces as a gap on the peer
+            if (errno == ECONNREFUSED || errno == ENOENT)
+                unlink(path.c_str());
+        }
+    }
+    sent_++;
+}
+
+void indiepub::InvalidationChannel::receiveLoop()
+{
+    char buffer[MAX_DATAGRAM];
+    auto started = std::chrono::steady_clock::now();
+    auto next_heartbeat = started;
+    while (running_)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_heartbeat)
+        {
+            send(Kind::HEARTBEAT, {EntityType::ANY, "", 0});
+            expirePeers();
+            next_heartbeat = now + options_.heartbeat;
+        }
+
+        pollfd pfd{fd_, POLLIN, 0};
+        int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(next_heartbeat - now).count());
+        if (poll(&pfd, 1, std::max(timeout, 1)) <= 0)
+            continue;
+
+        ssize_t length = recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+        Message message;
+        if (length <= 0 || !decode(buffer, static_cast<size_t>(length), message) || message.sender == sender_)
+            continue;
+        received_++;
+        onMessage(message);
+    }
+}
+
+void indiepub::InvalidationChannel::onMessage(const Message &message)
+{
+    bool lost = false;
+    bool apply = message.kind == Kind::INVALIDATE;
+    {
+        std::lock_guard<std::mutex> lock(peers_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        auto it = peers_.find(message.sender);
+        if (it == peers_.end())
+        {
+            peers_[message.sender] = {message.sequence, now};
+        }
+        else
+        {
+            Peer &peer = it->second;
+            peer.seen = now;
+            if (message.sequence <= peer.sequence)
+            {
+                // duplicate or reordered datagram; heartbeats simply confirm we are in sync
+                apply = false;
+            }
+            else
+            {
+                std::uint64_t expected = message.kind == Kind::INVALIDATE ? peer.sequence + 1 : peer.sequence;
+                lost = message.sequence > expected;
+                peer.sequence = message.sequence;
+            }
+        }
+    }
+
+    if (lost)
+    {
+        gaps_++;
+        LOG_ERROR << "Invalidation messages lost from sender " << message.sender << ", flushing caches";
+        flush();
+        return;
+    }
+    if (apply)
+    {
+        applying_remote = true;
+        InvalidationBus::instance().dispatch(message.event);
+        applying_remote = false;
+    }
+}
+
+void indiepub::InvalidationChannel::flush()
+{
+    flushes_++;
+    applying_remote = true;
+    InvalidationBus::instance().publish(EntityType::ANY, "");
+    applying_remote = false;
+}
+
+void indiepub::InvalidationChannel::expirePeers()
+{
+    auto deadline = std::chrono::steady_clock::now() - options_.heartbeat * 10;
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+    for (auto it = peers_.begin(); it != peers_.end();)
+    {
+        if (it->second.seen < deadline)
+            it = peers_.erase(it);
+        else
+            ++it;
+    }
+}
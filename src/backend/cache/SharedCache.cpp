@@ -0,0 +1,411 @@
+#include <backend/cache/SharedCache.hpp>
+#include <util/logging/Log.hpp>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+    constexpr std::uint32_t MAGIC = 0x53484332; // "SHC2"
+    constexpr std::uint32_t KEY_CAPACITY = 96;
+    // owner generation counters; owners that share one are invalidated together
+    constexpr std::uint32_t GENERATIONS = 4096;
+    constexpr std::uint32_t MAX_PROBE = 16;
+    constexpr int MAX_READ_RETRIES = 8;
+
+    enum SlotState : std::uint8_t
+    {
+        EMPTY = 0,
+        USED = 1,
+        DELETED = 2
+    };
+
+    std::uint64_t fnv1a(std::uint8_t entity, const std::string &key)
+    {
+        std::uint64_t hash = 1469598103934665603ULL;
+        hash = (hash ^ entity) * 1099511628211ULL;
+        for (unsigned char c : key)
+            hash = (hash ^ c) * 1099511628211ULL;
+        return hash;
+    }
+
+    std::int64_t nowNanos()
+    {
+        // CLOCK_MONOTONIC is system wide, so expiries compare across processes
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "seqlock needs address-free atomics");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared counters need address-free atomics");
+}
+
+struct indiepub::SharedCache::Header
+{
+    std::atomic<std::uint32_t> magic;
+    std::uint32_t slots;
+    std::uint32_t value_size;
+    std::uint32_t stride;
+    pthread_mutex_t writer;
+    std::atomic<std::uint64_t> hits;
+    std::atomic<std::uint64_t> misses;
+    std::atomic<std::uint64_t> writes;
+    std::atomic<std::uint64_t> evictions;
+    std::atomic<std::uint32_t> used;
+};
+
+struct indiepub::SharedCache::Slot
+{
+    std::atomic<std::uint32_t> seq;
+    std::uint8_t entity;
+    std::uint8_t state;
+    std::uint16_t key_len;
+    std::uint32_t value_len;
+    std::uint64_t key_hash;
+    std::uint64_t owner_hash;
+    std::uint32_t owner_generation;     // generation of the owner when the entry was written
+    std::int64_t expires;
+    char key[KEY_CAPACITY];
+
+    // value_size bytes follow the fixed part of the slot
+    char *value()
+    {
+        return reinterpret_cast<char *>(this) + sizeof(Slot);
+    }
+
+    void beginWrite()
+    {
+        seq.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void endWrite()
+    {
+        seq.fetch_add(1, std::memory_order_release);
+    }
+};
+
+namespace
+{
+    // the header is padded so the generation table, and the slot array after it, start
+    // cache-line aligned
+    constexpr size_t HEADER_SIZE = 256;
+    constexpr size_t GENERATIONS_SIZE = GENERATIONS * sizeof(std::atomic<std::uint32_t>);
+}
+
+std::unique_ptr<indiepub::SharedCache> indiepub::SharedCache::open(const std::string &name, std::uint32_t slots, std::uint32_t value_size)
+{
+    static_assert(sizeof(Header) <= 256, "header must fit the reserved page prefix");
+    std::uint32_t stride = static_cast<std::uint32_t>((sizeof(Slot) + value_size + 63) / 64 * 64);
+    size_t length = HEADER_SIZE + GENERATIONS_SIZE + static_cast<size_t>(slots) * stride;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        LOG_ERROR << "shm_open " << name << " failed: " << std::strerror(errno);
+        return nullptr;
+    }
+    // the first process to get here initializes the segment, everybody else validates it
+    flock(fd, LOCK_EX);
+    struct stat st;
+    fstat(fd, &st);
+    bool fresh = st.st_size == 0;
+    if (fresh && ftruncate(fd, static_cast<off_t>(length)) != 0)
+    {
+        LOG_ERROR << "Sizing shared cache " << name << " failed: " << std::strerror(errno);
+        flock(fd, LOCK_UN);
+        close(fd);
+        return nullptr;
+    }
+    if (!fresh && static_cast<size_t>(st.st_size) != length)
+    {
+        LOG_ERROR << "Shared cache " << name << " exists with a different geometry";
+        flock(fd, LOCK_UN);
+        close(fd);
+        return nullptr;
+    }
+    void *base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        LOG_ERROR << "Mapping shared cache " << name << " failed: " << std::strerror(errno);
+        flock(fd, LOCK_UN);
+        close(fd);
+        return nullptr;
+    }
+
+    Header *header = static_cast<Header *>(base);
+    if (fresh)
+    {
+        // ftruncate zero-fills, so every slot starts EMPTY with an even sequence
+        header->slots = slots;
+        header->value_size = value_size;
+        header->stride = stride;
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header->writer, &attr);
+        pthread_mutexattr_destroy(&attr);
+        header->magic.store(MAGIC, std::memory_order_release);
+    }
+    else if (header->magic.load(std::memory_order_acquire) != MAGIC || header->slots != slots || header->value_size != value_size)
+    {
+        LOG_ERROR << "Shared cache " << name << " is not compatible with this build";
+        munmap(base, length);
+        flock(fd, LOCK_UN);
+        close(fd);
+        return nullptr;
+    }
+    flock(fd, LOCK_UN);
+    return std::unique_ptr<SharedCache>(new SharedCache(fd, base, length));
+}
+
+bool indiepub::SharedCache::remove(const std::string &name)
+{
+    return shm_unlink(name.c_str()) == 0;
+}
+
+indiepub::SharedCache::SharedCache(int fd, void *base, size_t length)
+    : fd_(fd), base_(base), length_(length), header_(static_cast<Header *>(base))
+{
+}
+
+indiepub::SharedCache::~SharedCache()
+{
+    munmap(base_, length_);
+    close(fd_);
+}
+
+indiepub::SharedCache::Slot *indiepub::SharedCache::slot(std::uint32_t index) const
+{
+    char *slots = static_cast<char *>(base_) + HEADER_SIZE + GENERATIONS_SIZE;
+    return reinterpret_cast<Slot *>(slots + static_cast<size_t>(index % header_->slots) * header_->stride);
+}
+
+std::atomic<std::uint32_t> &indiepub::SharedCache::generation(std::uint64_t owner_hash) const
+{
+    auto *generations = reinterpret_cast<std::atomic<std::uint32_t> *>(static_cast<char *>(base_) + HEADER_SIZE);
+    return generations[owner_hash % GENERATIONS];
+}
+
+void indiepub::SharedCache::lockWriter()
+{
+    if (pthread_mutex_lock(&header_->writer) == EOWNERDEAD)
+    {
+        // a process died mid-write; its slot is left with an odd sequence, so drop it
+        for (std::uint32_t i = 0; i < header_->slots; ++i)
+        {
+            Slot *s = slot(i);
+            if (s->seq.load(std::memory_order_relaxed) & 1)
+            {
+                s->state = DELETED;
+                s->endWrite();
+            }
+        }
+        pthread_mutex_consistent(&header_->writer);
+    }
+}
+
+void indiepub::SharedCache::unlockWriter()
+{
+    pthread_mutex_unlock(&header_->writer);
+}
+
+std::uint32_t indiepub::SharedCache::generation(EntityType entity) const
+{
+    // the counter of entries without an owner, which depend on every key
+    return generation(fnv1a(static_cast<std::uint8_t>(entity), "")).load(std::memory_order_acquire);
+}
+
+bool indiepub::SharedCache::get(EntityType entity, const std::string &key, std::string &value)
+{
+    if (key.size() > KEY_CAPACITY)
+        return false;
+    std::uint8_t type = static_cast<std::uint8_t>(entity);
+    std::uint64_t hash = fnv1a(type, key);
+    std::int64_t now = nowNanos();
+
+    for (std::uint32_t probe = 0; probe < MAX_PROBE; ++probe)
+    {
+        Slot *s = slot(static_cast<std::uint32_t>(hash) + probe);
+        for (int attempt = 0; attempt < MAX_READ_RETRIES; ++attempt)
+        {
+            std::uint32_t before = s->seq.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+            std::uint8_t state = s->state;
+            bool match = state == USED && s->key_hash == hash && s->entity == type &&
+                         s->key_len == key.size() && std::memcmp(s->key, key.data(), key.size()) == 0;
+            std::int64_t expires = s->expires;
+            std::uint64_t owner = s->owner_hash;
+            std::uint32_t written = s->owner_generation;
+            std::uint32_t length = std::min(s->value_len, header_->value_size);
+            if (match)
+                value.assign(s->value(), length);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->seq.load(std::memory_order_relaxed) != before)
+                continue;
+
+            if (state == EMPTY)
+            {
+                header_->misses.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (!match)
+                break;
+            // an entry written before its owner last changed is as good as gone
+            if (expires <= now || written != generation(owner).load(std::memory_order_acquire))
+            {
+                header_->misses.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            header_->hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    header_->misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool indiepub::SharedCache::put(EntityType entity, const std::string &key, const std::string &value,
+                                std::chrono::milliseconds ttl, const std::string &owner, std::uint32_t since)
+{
+    if (key.size() > KEY_CAPACITY || value.size() > header_->value_size)
+        return false;
+    std::uint8_t type = static_cast<std::uint8_t>(entity);
+    std::uint64_t hash = fnv1a(type, key);
+    std::int64_t now = nowNanos();
+    std::uint64_t owner_hash = fnv1a(type, owner);
+
+    lockWriter();
+    // eraseOwnedBy advances the type's generation before the owner's, so an owner generation
+    // read here that is already new fails the check below
+    std::uint32_t owner_generation = generation(owner_hash).load(std::memory_order_acquire);
+    if (generation(entity) != since)
+    {
+        unlockWriter();
+        return false;
+    }
+    Slot *target = nullptr;
+    Slot *victim = nullptr;
+    for (std::uint32_t probe = 0; probe < MAX_PROBE; ++probe)
+    {
+        Slot *s = slot(static_cast<std::uint32_t>(hash) + probe);
+        if (s->state == USED && s->key_hash == hash && s->entity == type &&
+            s->key_len == key.size() && std::memcmp(s->key, key.data(), key.size()) == 0)
+        {
+            target = s;
+            break;
+        }
+        if (target == nullptr && (s->state != USED || s->expires <= now ||
+                                  s->owner_generation != generation(s->owner_hash).load(std::memory_order_relaxed)))
+            target = s;
+        if (victim == nullptr || s->expires < victim->expires)
+            victim = s;
+        if (s->state == EMPTY)
+            break;
+    }
+    if (target == nullptr)
+    {
+        target = victim;
+        header_->evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool was_used = target->state == USED;
+    target->beginWrite();
+    target->entity = type;
+    target->state = USED;
+    target->key_len = static_cast<std::uint16_t>(key.size());
+    target->value_len = static_cast<std::uint32_t>(value.size());
+    target->key_hash = hash;
+    target->owner_hash = owner_hash;
+    target->owner_generation = owner_generation;
+    target->expires = now + std::chrono::duration_cast<std::chrono::nanoseconds>(ttl).count();
+    std::memcpy(target->key, key.data(), key.size());
+    std::memcpy(target->value(), value.data(), value.size());
+    target->endWrite();
+    if (!was_used)
+        header_->used.fetch_add(1, std::memory_order_relaxed);
+    header_->writes.fetch_add(1, std::memory_order_relaxed);
+    unlockWriter();
+    return true;
+}
+
+void indiepub::SharedCache::erase(EntityType entity, const std::string &key)
+{
+    if (key.size() > KEY_CAPACITY)
+        return;
+    std::uint8_t type = static_cast<std::uint8_t>(entity);
+    std::uint64_t hash = fnv1a(type, key);
+
+    lockWriter();
+    // a put of a value loaded before this erase is dropped
+    generation(fnv1a(type, "")).fetch_add(1, std::memory_order_acq_rel);
+    for (std::uint32_t probe = 0; probe < MAX_PROBE; ++probe)
+    {
+        Slot *s = slot(static_cast<std::uint32_t>(hash) + probe);
+        if (s->state == EMPTY)
+            break;
+        if (s->state == USED && s->key_hash == hash && s->entity == type &&
+            s->key_len == key.size() && std::memcmp(s->key, key.data(), key.size()) == 0)
+        {
+            s->beginWrite();
+            s->state = DELETED;
+            s->endWrite();
+            header_->used.fetch_sub(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+    unlockWriter();
+}
+
+void indiepub::SharedCache::eraseOwnedBy(EntityType entity, const std::string &owner)
+{
+    // no scan and no writer lock: readers compare each entry with its owner's generation, and
+    // put() reuses the slots left behind. Entries without an owner depend on every key.
+    // the type's generation first, which put() relies on
+    std::uint8_t type = static_cast<std::uint8_t>(entity);
+    generation(fnv1a(type, "")).fetch_add(1, std::memory_order_acq_rel);
+    if (!owner.empty())
+        generation(fnv1a(type, owner)).fetch_add(1, std::memory_order_acq_rel);
+}
+
+void indiepub::SharedCache::clear(EntityType entity)
+{
+    std::uint8_t type = static_cast<std::uint8_t>(entity);
+
+    lockWriter();
+    for (std::uint8_t other = 0; other < static_cast<std::uint8_t>(EntityType::ANY); ++other)
+    {
+        if (entity == EntityType::ANY || other == type)
+            generation(fnv1a(other, "")).fetch_add(1, std::memory_order_acq_rel);
+    }
+    for (std::uint32_t i = 0; i < header_->slots; ++i)
+    {
+        Slot *s = slot(i);
+        if (s->state == EMPTY || (entity != EntityType::ANY && s->entity != type))
+            continue;
+        bool was_used = s->state == USED;
+        s->beginWrite();
+        // a whole-segment clear can reset probe chains, a per-entity one must keep them intact
+        s->state = entity == EntityType::ANY ? EMPTY : DELETED;
+        s->endWrite();
+        if (was_used)
+            header_->used.fetch_sub(1, std::memory_order_relaxed);
+    }
+    unlockWriter();
+}
+
+indiepub::SharedCache::Stats indiepub::SharedCache::stats() const
+{
+    return {header_->hits.load(), header_->misses.load(), header_->writes.load(),
+            header_->evictions.load(), header_->slots, header_->used.load()};
+}
+
+std::uint32_t indiepub::SharedCache::valueCapacity() const
+{
+    return header_->value_size;
+}
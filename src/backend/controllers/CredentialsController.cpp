@@ -1,6 +1,18 @@
 #include <backend/controllers/CredentialsController.hpp>
+#include <backend/cache/InvalidationBus.hpp>
 #include <util/logging/Log.hpp>
 
+namespace
+{
+    indiepub::Credentials firstCredentials(const std::shared_ptr<const CassResult> &result)
+    {
+        indiepub::Credentials creds;
+        if (cass_result_row_count(result.get()) > 0)
+            creds = indiepub::Credentials::from_row(cass_result_first_row(result.get()));
+        return creds;
+    }
+}
+
 indiepub::CredentialsController::CredentialsController(const std::string &contact_points, const std::string &username, const std::string &password, const std::string &keyspace)
     : CassandraConnection(contact_points, username, password, keyspace)
 {   
@@ -41,12 +53,40 @@ bool indiepub::CredentialsController::insertCredentials(const indiepub::Credenti
     {
         isExecuted = true;
         LOG_DEBUG << "Query executed successfully.";
+        InvalidationBus::instance().publish(EntityType::CREDENTIALS, creds.user_id());
     }
     cass_statement_free(statement);
     cass_future_free(query_future);
     return isExecuted;
 }
 
+indiepub::Task<bool> indiepub::CredentialsController::insertCredentialsAsync(indiepub::Credentials creds)
+{
+    CassUuid uuid;
+    if (creds.user_id().empty() || cass_uuid_from_string(creds.user_id().c_str(), &uuid) != CASS_OK)
+    {
+        LOG_ERROR << "Invalid UUID string: " + creds.user_id();
+        co_return false;
+    }
+    std::string query = "INSERT INTO " + keyspace_ + "." + indiepub::Credentials::COLUMN_FAMILY + 
+    "(user_id, auth_token, pw_hash) VALUES (?, ?, ?)";
+    CassStatement *statement = cass_statement_new(query.c_str(), 3);
+    cass_statement_bind_uuid(statement, 0, uuid);
+    cass_statement_bind_string(statement, 1, creds.auth_token().c_str());
+    cass_statement_bind_string(statement, 2, creds.pw_hash().c_str());
+    try
+    {
+        co_await executeAsync(statement);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+        co_return false;
+    }
+    InvalidationBus::instance().publish(EntityType::CREDENTIALS, creds.user_id());
+    co_return true;
+}
+
 indiepub::Credentials indiepub::CredentialsController::getCredentialsByUserId(const std::string &user_id)
 {
     std::string query = "SELECT * FROM " + keyspace_ + "." + indiepub::Credentials::COLUMN_FAMILY
@@ -118,6 +158,29 @@ indiepub::Credentials indiepub::CredentialsController::getCredentialsByAuthToken
     return creds;
 }
 
+indiepub::Async<indiepub::Credentials> indiepub::CredentialsController::getCredentialsByUserIdAsync(const std::string &user_id)
+{
+    CassUuid uuid;
+    if (cass_uuid_from_string(user_id.c_str(), &uuid) != CASS_OK)
+    {
+        return Async<Credentials>::failure(std::make_exception_ptr(std::runtime_error("Invalid UUID string: " + user_id)));
+    }
+    std::string query = "SELECT * FROM " + keyspace_ + "." + indiepub::Credentials::COLUMN_FAMILY
+        + " WHERE " + indiepub::Credentials::PK_CREDENTIAL_ID + "=?";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_uuid(statement, 0, uuid);
+    return executeAsync(statement).then(firstCredentials);
+}
+
+indiepub::Async<indiepub::Credentials> indiepub::CredentialsController::getCredentialsByAuthTokenAsync(const std::string &auth_token)
+{
+    std::string query = "SELECT * FROM " + keyspace_ + "." + indiepub::Credentials::COLUMN_FAMILY
+        + " WHERE " + indiepub::Credentials::IDX_CREDENTIAL_AUTH_TOKEN + "=? ALLOW FILTERING";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_string(statement, 0, auth_token.c_str());
+    return executeAsync(statement).then(firstCredentials);
+}
+
 indiepub::Credentials indiepub::CredentialsController::getCredentialsByPwHash(const std::string &pw_hash)
 {
     std::string query = "SELECT * FROM " + keyspace_ + "." + indiepub::Credentials::COLUMN_FAMILY
@@ -1,4 +1,5 @@
 #include <backend/controllers/EventController.hpp>
+#include <backend/cache/InvalidationBus.hpp>
 #include <backend/models/EventByVenue.hpp>
 #include <iostream>
 #include <stdexcept>
@@ -107,6 +108,7 @@ bool indiepub::EventController::insertEvent(const indiepub::EventByVenue &event)
     } else {
         std::cout << "Query executed successfully." << std::endl;
         isValid = true;
+        InvalidationBus::instance().publish(EntityType::EVENT, event.event_id());
     }
     
     cass_statement_free(statement);
@@ -178,6 +180,63 @@ std::vector<indiepub::EventByVenue> indiepub::EventController::getOneWeekEvents(
 
 
 
+namespace
+{
+    std::vector<indiepub::EventByVenue> allEvents(const std::shared_ptr<const CassResult> &result)
+    {
+        std::vector<indiepub::EventByVenue> events;
+        events.reserve(cass_result_row_count(result.get()));
+        CassIterator *iterator = cass_iterator_from_result(result.get());
+        while (cass_iterator_next(iterator)) {
+            events.emplace_back(indiepub::EventByVenue::from_row(cass_iterator_get_row(iterator)));
+        }
+        cass_iterator_free(iterator);
+        return events;
+    }
+}
+
+indiepub::Async<std::vector<indiepub::EventByVenue>> indiepub::EventController::getAllEventsAsync() {
+    std::string query = "SELECT * FROM " + this->keyspace_ + "." + EventByVenue::COLUMN_FAMILY;
+    return executeAsync(cass_statement_new(query.c_str(), 0)).then(allEvents);
+}
+
+indiepub::Async<std::vector<indiepub::EventByVenue>> indiepub::EventController::getOneWeekEventsAsync(const time_t &start_date) {
+    time_t end_date = start_date + 7 * 24 * 60 * 60; // One week later
+    std::string query = "SELECT * FROM " + this->keyspace_ + "." + EventByVenue::COLUMN_FAMILY + 
+                        " WHERE date >= ? AND date <= ? ALLOW FILTERING";
+    CassStatement *statement = cass_statement_new(query.c_str(), 2);
+    cass_statement_bind_int64(statement, 0, start_date);
+    cass_statement_bind_int64(statement, 1, end_date);
+    return executeAsync(statement).then(allEvents);
+}
+
+indiepub::Async<indiepub::EventByVenue> indiepub::EventController::getEventByIdAsync(const std::string &event_id) {
+    CassUuid uuid;
+    if (cass_uuid_from_string(event_id.c_str(), &uuid) != CASS_OK) {
+        return Async<EventByVenue>::failure(std::make_exception_ptr(std::runtime_error("Invalid UUID string: " + event_id)));
+    }
+    std::string query = "SELECT * FROM " + this->keyspace_ + "." + EventByVenue::COLUMN_FAMILY + " WHERE event_id = ? ALLOW FILTERING";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_uuid(statement, 0, uuid);
+    return executeAsync(statement).then([](const std::shared_ptr<const CassResult> &result) {
+        indiepub::EventByVenue event;
+        if (cass_result_row_count(result.get()) > 0)
+            event = indiepub::EventByVenue::from_row(cass_result_first_row(result.get()));
+        return event;
+    });
+}
+
+indiepub::Async<std::vector<indiepub::EventByVenue>> indiepub::EventController::getEventsByVenueAsync(const std::string &venue_id) {
+    CassUuid uuid;
+    if (cass_uuid_from_string(venue_id.c_str(), &uuid) != CASS_OK) {
+        return Async<std::vector<EventByVenue>>::failure(std::make_exception_ptr(std::runtime_error("Invalid UUID string: " + venue_id)));
+    }
+    std::string query = "SELECT * FROM " + this->keyspace_ + "." + EventByVenue::COLUMN_FAMILY + " WHERE venue_id = ?";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_uuid(statement, 0, uuid);
+    return executeAsync(statement).then(allEvents);
+}
+
 indiepub::EventByVenue indiepub::EventController::getEventById(const std::string &event_id) {
     std::string query = "SELECT * FROM " + this->keyspace_ + "." + EventByVenue::COLUMN_FAMILY + " WHERE event_id = ? ALLOW FILTERING";
     CassStatement *statement = cass_statement_new(query.c_str(), 1);
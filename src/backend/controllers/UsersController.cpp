@@ -1,5 +1,6 @@
 #include <backend/controllers/UsersController.hpp>
 #include <backend/models/User.hpp>
+#include <backend/cache/InvalidationBus.hpp>
 #include <util/logging/Log.hpp>
 #include <iostream>
 #include <stdexcept>
@@ -84,6 +85,7 @@ bool indiepub::UsersController::insertUser(const indiepub::User &user)
     {
         isValid = true;
         std::cout << "Query executed successfully.";
+        InvalidationBus::instance().publish(EntityType::USER, user.user_id());
     }
     cass_statement_free(statement);
     cass_future_free(query_future);
@@ -158,6 +160,7 @@ bool indiepub::UsersController::updateUser(const indiepub::User &user)
     {
         isValid = true;
         std::cout << "Query executed successfully.";
+        InvalidationBus::instance().publish(EntityType::USER, user.user_id());
     }
     cass_collection_free(collection);
     cass_statement_free(statement);
@@ -235,6 +238,86 @@ indiepub::User indiepub::UsersController::getUserById(const std::string &user_id
     return user;
 }
 
+namespace
+{
+    indiepub::User firstUser(const std::shared_ptr<const CassResult> &result)
+    {
+        indiepub::User user;
+        if (cass_result_row_count(result.get()) > 0)
+            user = indiepub::User::from_row(cass_result_first_row(result.get()));
+        return user;
+    }
+}
+
+indiepub::Async<indiepub::User> indiepub::UsersController::getUserByIdAsync(const std::string &user_id)
+{
+    CassUuid uuid;
+    if (cass_uuid_from_string(user_id.c_str(), &uuid) != CASS_OK)
+    {
+        return Async<User>::failure(std::make_exception_ptr(std::runtime_error("Invalid UUID string: " + user_id)));
+    }
+    std::string query = "SELECT * FROM " + keyspace_ + ".users WHERE user_id = ?";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_uuid(statement, 0, uuid);
+    return executeAsync(statement).then(firstUser);
+}
+
+indiepub::Async<indiepub::User> indiepub::UsersController::getUserByEmailAsync(const std::string &email)
+{
+    std::string query = "SELECT * FROM " + keyspace_ + ".users WHERE email = ? ALLOW FILTERING";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_string(statement, 0, email.c_str());
+    return executeAsync(statement).then(firstUser);
+}
+
+indiepub::Async<indiepub::User> indiepub::UsersController::getUserByAsync(const std::string &name, const std::string &email)
+{
+    std::string query = "SELECT * FROM " + keyspace_ + "." + User::COLUMN_FAMILY + " WHERE name = ? AND email = ? ALLOW FILTERING";
+    CassStatement *statement = cass_statement_new(query.c_str(), 2);
+    cass_statement_bind_string(statement, 0, name.c_str());
+    cass_statement_bind_string(statement, 1, email.c_str());
+    return executeAsync(statement).then(firstUser);
+}
+
+indiepub::Task<bool> indiepub::UsersController::insertUserAsync(indiepub::User user)
+{
+    if (user.user_id().empty() || user.email().empty() || user.role().empty() || user.created_at() <= 0)
+    {
+        LOG_ERROR << "User ID, email, role and a positive created at timestamp are required";
+        co_return false;
+    }
+    CassUuid uuid;
+    if (cass_uuid_from_string(user.user_id().c_str(), &uuid) != CASS_OK)
+    {
+        LOG_ERROR << "Invalid UUID string: " + user.user_id();
+        co_return false;
+    }
+    try
+    {
+        User existing = co_await getUserByAsync(user.name(), user.email());
+        if (existing.name() == user.name() && existing.email() == user.email())
+        {
+            LOG_ERROR << "User with this name and email already exists";
+            co_return false;
+        }
+        std::string query = "INSERT INTO " + keyspace_ + "." + indiepub::User::COLUMN_FAMILY + " (user_id, email, role, name, created_at) VALUES (?, ?, ?, ?, ?)";
+        CassStatement *statement = cass_statement_new(query.c_str(), 5);
+        cass_statement_bind_uuid(statement, 0, uuid);
+        cass_statement_bind_string(statement, 1, user.email().c_str());
+        cass_statement_bind_string(statement, 2, user.role().c_str());
+        cass_statement_bind_string(statement, 3, user.name().c_str());
+        cass_statement_bind_int64(statement, 4, user.created_at());
+        co_await executeAsync(statement);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << e.what();
+        co_return false;
+    }
+    InvalidationBus::instance().publish(EntityType::USER, user.user_id());
+    co_return true;
+}
+
 indiepub::User indiepub::UsersController::getUserByEmail(const std::string &email)
 {
     std::string query = "SELECT * FROM " + keyspace_ + ".users WHERE email = ? ALLOW FILTERING";
@@ -1,4 +1,5 @@
 #include <backend/controllers/VenueMembersController.hpp>
+#include <backend/cache/InvalidationBus.hpp>
 #include <backend/models/VenueMembers.hpp>
 #include <util/logging/Log.hpp>
 #include <iostream>
@@ -65,6 +66,7 @@ bool indiepub::VenueMembersController::insertVenueMember(const indiepub::VenueMe
     {
         isValid = true;
         LOG_INFO << "Inserted Venue Member: " << member.to_json();
+        InvalidationBus::instance().publish(EntityType::VENUE_MEMBER, member.user_id());
     }
     else
     {
@@ -124,6 +126,7 @@ bool indiepub::VenueMembersController::updateVenueMember(const indiepub::VenueMe
     {
         isValid = true;
         LOG_INFO << "Updated Venue Member: " << member.to_json();
+        InvalidationBus::instance().publish(EntityType::VENUE_MEMBER, member.user_id());
     }
     else
     {
@@ -263,6 +266,25 @@ indiepub::VenueMembers indiepub::VenueMembersController::getVenueMemberByUserId(
     return member;
 }
 
+indiepub::Async<indiepub::VenueMembers> indiepub::VenueMembersController::getVenueMemberByUserIdAsync(const std::string &user_id)
+{
+    CassUuid user_uuid;
+    if (user_id.empty() || cass_uuid_from_string(user_id.c_str(), &user_uuid) != CASS_OK)
+    {
+        LOG_ERROR << "Invalid user ID: " << user_id;
+        return Async<VenueMembers>::value(VenueMembers());
+    }
+    std::string query = "SELECT * FROM " + keyspace_ + "." + indiepub::VenueMembers::COLUMN_FAMILY + " WHERE user_id=? ALLOW FILTERING";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_uuid(statement, 0, user_uuid);
+    return executeAsync(statement).then([](const std::shared_ptr<const CassResult> &result) {
+        indiepub::VenueMembers member;
+        if (cass_result_row_count(result.get()) > 0)
+            member = indiepub::VenueMembers::from_row(cass_result_first_row(result.get()));
+        return member;
+    });
+}
+
 
 std::vector<indiepub::VenueMembers> indiepub::VenueMembersController::getVenueMembersByRole(const std::string &role)
 {
@@ -1,4 +1,5 @@
 #include <backend/controllers/VenuesController.hpp>
+#include <backend/cache/InvalidationBus.hpp>
 #include <backend/models/Venue.hpp>
 #include <util/logging/Log.hpp>
 #include <iostream>
@@ -93,6 +94,7 @@ bool indiepub::VenuesController::insertVenue(const indiepub::Venue &venue)
     {
         isValid = true;
         std::cout << "Query executed successfully.";
+        InvalidationBus::instance().publish(EntityType::VENUE, venue.venue_id());
     }
     cass_statement_free(statement);
     cass_future_free(query_future);
@@ -163,6 +165,7 @@ bool indiepub::VenuesController::updateVenue(const indiepub::Venue &venue)
     {
         isValid = true;
         std::cout << "Query executed successfully.";
+        InvalidationBus::instance().publish(EntityType::VENUE, venue.venue_id());
     }
     cass_statement_free(statement);
     cass_future_free(query_future);
@@ -240,6 +243,24 @@ indiepub::Venue indiepub::VenuesController::getVenueById(const std::string &venu
     return venue;
 }
 
+indiepub::Async<indiepub::Venue> indiepub::VenuesController::getVenueByIdAsync(const std::string &venue_id)
+{
+    CassUuid uuid;
+    if (cass_uuid_from_string(venue_id.c_str(), &uuid) != CASS_OK)
+    {
+        return Async<Venue>::failure(std::make_exception_ptr(std::runtime_error("Invalid UUID string: " + venue_id)));
+    }
+    std::string query = "SELECT * FROM " + keyspace_ + "." + indiepub::Venue::COLUMN_FAMILY + " WHERE venue_id = ?";
+    CassStatement *statement = cass_statement_new(query.c_str(), 1);
+    cass_statement_bind_uuid(statement, 0, uuid);
+    return executeAsync(statement).then([](const std::shared_ptr<const CassResult> &result) {
+        indiepub::Venue venue;
+        if (cass_result_row_count(result.get()) > 0)
+            venue = indiepub::Venue::from_row(cass_result_first_row(result.get()));
+        return venue;
+    });
+}
+
 indiepub::Venue indiepub::VenuesController::getVenueBy(const std::string &name, const std::string &location)
 {
     std::string query = "SELECT * FROM " + keyspace_ + "." + indiepub::Venue::COLUMN_FAMILY + " WHERE name = ? AND location = ? ALLOW FILTERING";
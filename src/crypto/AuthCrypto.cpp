@@ -1,4 +1,6 @@
 #include <crypto/AuthCrypto.hpp>
+#include <crypto/CryptoContexts.hpp>
+#include <crypto/KeyRing.hpp>
 #include "Exception.hpp"
 #include "util/String.hpp"
 #include "util/Util.hpp"
@@ -18,6 +20,17 @@ AuthCrypto::AuthCrypto(const char *filename) : filename(filename)
     init();
 }
 
+AuthCrypto::AuthCrypto(const char *filename, const std::shared_ptr<const KeyPair> &keys) : filename(filename), pinned(true)
+{
+    if (this->filename == nullptr)
+        throw std::invalid_argument("File name is NULL");
+    initFileNames();
+    if (keys != nullptr && keys->publicKey() != nullptr && EVP_PKEY_up_ref(keys->publicKey()) == 1)
+        this->public_key = keys->publicKey();
+    if (keys != nullptr && keys->privateKey() != nullptr && EVP_PKEY_up_ref(keys->privateKey()) == 1)
+        this->private_key = keys->privateKey();
+}
+
 bool AuthCrypto::doesPrivateKeyExists()
 {
     std::ifstream f(this->private_key_file.c_str());
@@ -32,6 +45,7 @@ bool AuthCrypto::doesPublicKeyExists()
 
 AuthCrypto::~AuthCrypto()
 {
+    pinned = false;
     destroy();
 }
 
@@ -50,6 +64,8 @@ void AuthCrypto::destroy()
 
 void AuthCrypto::unloadPublicKey()
 {
+    if (pinned)
+        return;
     if (public_key != nullptr)
     {
         EVP_PKEY_free(public_key);
@@ -59,6 +75,8 @@ void AuthCrypto::unloadPublicKey()
 
 void AuthCrypto::unloadPrivateKey()
 {
+    if (pinned)
+        return;
     if (private_key != nullptr)
     {
         EVP_PKEY_free(private_key);
@@ -140,6 +158,11 @@ void AuthCrypto::init()
         std::filesystem::create_directories(PUB_KEY_ARCHIVE);
     if (!std::filesystem::exists(PRV_KEY_ARCHIVE))
         std::filesystem::create_directories(PRV_KEY_ARCHIVE);
+    initFileNames();
+}
+
+void AuthCrypto::initFileNames()
+{
     this->public_key_file = PUB_KEY_ARCHIVE;
     this->public_key_file.append("/");
     this->public_key_file.append(this->filename);
@@ -192,28 +215,19 @@ size_t AuthCrypto::encrypt(unsigned char *src, unsigned char *&out)
     if (public_key == nullptr)
         if (!loadPublicKey())
             return -1;
-    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(public_key, nullptr);
-
-    if (EVP_PKEY_encrypt_init(ctx) <= 0)
+    EVP_PKEY_CTX *ctx = CryptoContexts::encryptContext(public_key);
+    if (ctx == nullptr)
     {
         LOG_ERROR << "encryption init failed";
-        EVP_PKEY_CTX_free(ctx);
         destroy();
         return -1;
     }
-    if (EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0)
-    {
-        EVP_PKEY_CTX_free(ctx);
-        destroy();
-        LOG_ERROR << "padding failed";
-        return -1;
-    }
     size_t out_len;
     size_t src_len = std::strlen((char *)src);
     if (EVP_PKEY_encrypt(ctx, nullptr, &out_len, src, src_len) <= 0)
     {
         LOG_ERROR << "encryption length computation error";
-        EVP_PKEY_CTX_free(ctx);
+        CryptoContexts::discard(public_key);
         destroy();
         return -1;
     }
@@ -221,41 +235,31 @@ size_t AuthCrypto::encrypt(unsigned char *src, unsigned char *&out)
     if (EVP_PKEY_encrypt(ctx, out, &out_len, src, src_len) <= 0)
     {
         LOG_ERROR << "encryption error";
-        EVP_PKEY_CTX_free(ctx);
+        CryptoContexts::discard(public_key);
         destroy();
         return -1;
     }
-    EVP_PKEY_CTX_free(ctx);
     destroy();
     return out_len;
 }
 
-size_t AuthCrypto::decrypt(unsigned char *src, size_t src_len, unsigned char *&out, const char *password)
+size_t AuthCrypto::decrypt(unsigned char *src, size_t src_len, unsigned char *&out, const char *password, bool explicitRejection)
 {
     if (private_key == nullptr)
         if (!loadPrivateKey(password))
             return -1;
-    
-    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(private_key, nullptr);
 
-    if (EVP_PKEY_decrypt_init(ctx) <= 0)
+    EVP_PKEY_CTX *ctx = CryptoContexts::decryptContext(private_key, explicitRejection);
+    if (ctx == nullptr)
     {
-        EVP_PKEY_CTX_free(ctx);
         destroy();
         LOG_ERROR << "decryption init error";
         return -1;
     }
-    if (EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0)
-    {
-        EVP_PKEY_CTX_free(ctx);
-        destroy();
-        LOG_ERROR << "padding failed";
-        return -1;
-    }
     size_t out_len;
     if (EVP_PKEY_decrypt(ctx, nullptr, &out_len, src, src_len) <= 0)
     {
-        EVP_PKEY_CTX_free(ctx);
+        CryptoContexts::discard(private_key);
         destroy();
         LOG_ERROR << "decryption length computation error";
         return -1;
@@ -263,9 +267,11 @@ size_t AuthCrypto::decrypt(unsigned char *src, size_t src_len, unsigned char *&o
     out = (unsigned char *)OPENSSL_zalloc(out_len);
     if (EVP_PKEY_decrypt(ctx, out, &out_len, src, src_len) <= 0)
     {
-        EVP_PKEY_CTX_free(ctx);
+        OPENSSL_free(out);
+        out = nullptr;
+        CryptoContexts::discard(private_key);
         destroy();
-        LOG_ERROR << "decryption init error";
+        LOG_ERROR << "decryption error";
         return -1;
     }
     destroy();
@@ -283,27 +289,25 @@ bool AuthCrypto::isPublicKeyRsa()
 
 size_t AuthCrypto::hashing(unsigned char *msg, unsigned char *&md_value)
 {
-    md_value = static_cast<unsigned char *>(malloc(EVP_MAX_MD_SIZE));
-
-    const EVP_MD *md = EVP_MD_fetch(nullptr, RSA_HASH_ALGO, nullptr);
+    const EVP_MD *md = CryptoContexts::digest();
     if (md == nullptr)
     {
         destroy();
         LOG_ERROR << "Unsupported algorithm: " << RSA_HASH_ALGO;
         return -1;
     }
-    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    EVP_MD_CTX *mdctx = CryptoContexts::digestContext();
     if (mdctx == nullptr)
     {
         destroy();
         LOG_ERROR << "Message Digestion context initialization failed";
         return -1;
     }
+    md_value = static_cast<unsigned char *>(malloc(EVP_MAX_MD_SIZE));
     EVP_DigestInit_ex2(mdctx, md, nullptr);
     EVP_DigestUpdate(mdctx, msg, strlen((char *)msg));
     unsigned int md_length = 0;
     EVP_DigestFinal(mdctx, md_value, &md_length);
-    EVP_MD_CTX_free(mdctx);
     return md_length;
 }
 
@@ -314,21 +318,14 @@ size_t AuthCrypto::sign(const char *msg, unsigned char *&sig, const char *passwo
         if (!loadPrivateKey(password))
             return -1;
     }
-    EVP_MD_CTX *md_ctx = EVP_MD_CTX_new();
+    EVP_MD_CTX *md_ctx = CryptoContexts::signContext(private_key);
     if (md_ctx == nullptr)
-    {
-        unloadPrivateKey();
-        LOG_ERROR << "Message Digest init failed.";
-        return -1;
-    }
-    OSSL_LIB_CTX *lib_ctx = OSSL_LIB_CTX_new();
-    if (EVP_DigestSignInit_ex(md_ctx, nullptr, RSA_HASH_ALGO, lib_ctx, nullptr, private_key, nullptr) < 1)
     {
         unloadPrivateKey();
         LOG_ERROR << "Message Digest Signing init failed.";
         return -1;
     }
-    if (EVP_DigestUpdate(md_ctx, msg, strlen(msg)) < 1)
+    if (EVP_DigestSignUpdate(md_ctx, msg, strlen(msg)) < 1)
     {
         unloadPrivateKey();
         LOG_ERROR << "Message Digest Signing Update failed.";
@@ -358,10 +355,10 @@ size_t AuthCrypto::sign(const char *msg, unsigned char *&sig, const char *passwo
     {
         unloadPrivateKey();
         OPENSSL_free(sig);
+        sig = nullptr;
         LOG_ERROR << "Signing failed.";
         return -1;
     }
-    EVP_MD_CTX_free(md_ctx);
     unloadPrivateKey();
     return sig_len;
 }
@@ -372,16 +369,8 @@ bool AuthCrypto::verify(const char *msg, unsigned char *sig, size_t sig_len)
         if (!loadPublicKey())
             return false;
 
-    EVP_MD_CTX *md_ctx = EVP_MD_CTX_new();
+    EVP_MD_CTX *md_ctx = CryptoContexts::verifyContext(public_key);
     if (md_ctx == nullptr)
-    {
-        unloadPublicKey();
-        LOG_ERROR << "Message Digest init failed.";
-        return false;
-    }
-
-    OSSL_LIB_CTX *lib_ctx = OSSL_LIB_CTX_new();
-    if (EVP_DigestVerifyInit_ex(md_ctx, nullptr, RSA_HASH_ALGO, lib_ctx, nullptr, public_key, nullptr) < 1)
     {
         unloadPublicKey();
         LOG_ERROR << "Message Digest Signing init failed.";
@@ -401,7 +390,6 @@ bool AuthCrypto::verify(const char *msg, unsigned char *sig, size_t sig_len)
         LOG_ERROR << "Verifying failed.";
         return false;
     }
-    EVP_MD_CTX_free(md_ctx);
     unloadPublicKey();
     return true;
 }
@@ -426,4 +414,12 @@ void AuthCrypto::loadPrivateKey(std::string filename, const char *passphrase)
 {
     this->private_key_file = filename;
     this->loadPrivateKey(passphrase);
-}
\ No newline at end of file
+}
+
+std::shared_ptr<const KeyPair> AuthCrypto::releaseKeys()
+{
+    std::shared_ptr<const KeyPair> keys = std::make_shared<KeyPair>(public_key, private_key);
+    public_key = nullptr;
+    private_key = nullptr;
+    return keys;
+}
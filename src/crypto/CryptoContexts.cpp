@@ -0,0 +1,211 @@
+#include <crypto/CryptoContexts.hpp>
+#include <openssl/rsa.h>
+#include "util/logging/Log.hpp"
+#include "config.h"
+#include <vector>
+
+namespace
+{
+    // keys are rotated rarely; older templates are dropped beyond this many per thread
+    constexpr size_t MAX_KEYS_PER_THREAD = 8;
+
+    enum class Kind
+    {
+        ENCRYPT,
+        DECRYPT,
+        DECRYPT_EXPLICIT,
+        SIGN,
+        VERIFY
+    };
+
+    struct Template
+    {
+        EVP_PKEY *key;
+        Kind kind;
+        EVP_PKEY_CTX *pkey_ctx;
+        EVP_MD_CTX *md_ctx;
+    };
+
+    void freeTemplate(Template &entry)
+    {
+        if (entry.pkey_ctx != nullptr)
+            EVP_PKEY_CTX_free(entry.pkey_ctx);
+        if (entry.md_ctx != nullptr)
+            EVP_MD_CTX_free(entry.md_ctx);
+        // the key was referenced when the template was built
+        EVP_PKEY_free(entry.key);
+    }
+
+    struct ThreadContexts
+    {
+        EVP_MD_CTX *work = nullptr;
+        EVP_CIPHER_CTX *cipher = nullptr;
+        std::vector<Template> templates;
+
+        ~ThreadContexts()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            for (auto &entry : templates)
+                freeTemplate(entry);
+            templates.clear();
+            if (work != nullptr)
+            {
+                EVP_MD_CTX_free(work);
+                work = nullptr;
+            }
+            if (cipher != nullptr)
+            {
+                EVP_CIPHER_CTX_free(cipher);
+                cipher = nullptr;
+            }
+        }
+
+        Template *find(EVP_PKEY *key, Kind kind)
+        {
+            for (auto &entry : templates)
+            {
+                if (entry.key == key && entry.kind == kind)
+                    return &entry;
+            }
+            return nullptr;
+        }
+
+        Template *add(Template entry)
+        {
+            if (templates.size() >= MAX_KEYS_PER_THREAD * 4)
+            {
+                freeTemplate(templates.front());
+                templates.erase(templates.begin());
+            }
+            templates.push_back(entry);
+            return &templates.back();
+        }
+    };
+
+    thread_local ThreadContexts contexts;
+
+    Template *pkeyTemplate(EVP_PKEY *key, Kind kind)
+    {
+        if (Template *cached = contexts.find(key, kind))
+            return cached;
+        EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_pkey(nullptr, key, nullptr);
+        if (ctx == nullptr)
+            return nullptr;
+        int init = kind == Kind::ENCRYPT ? EVP_PKEY_encrypt_init(ctx) : EVP_PKEY_decrypt_init(ctx);
+        if (init <= 0 || EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0)
+        {
+            LOG_ERROR << "RSA context initialization failed";
+            EVP_PKEY_CTX_free(ctx);
+            return nullptr;
+        }
+        // OpenSSL before 3.2 has no implicit rejection and does not know the parameter
+        if (kind == Kind::DECRYPT_EXPLICIT)
+            EVP_PKEY_CTX_ctrl_str(ctx, "rsa_pkcs1_implicit_rejection", "0");
+        EVP_PKEY_up_ref(key);
+        return contexts.add({key, kind, ctx, nullptr});
+    }
+
+    EVP_MD_CTX *digestTemplate(EVP_PKEY *key, Kind kind)
+    {
+        Template *entry = contexts.find(key, kind);
+        if (entry == nullptr)
+        {
+            EVP_MD_CTX *md_ctx = EVP_MD_CTX_new();
+            if (md_ctx == nullptr)
+                return nullptr;
+            int init = kind == Kind::SIGN
+                           ? EVP_DigestSignInit_ex(md_ctx, nullptr, RSA_HASH_ALGO, nullptr, nullptr, key, nullptr)
+                           : EVP_DigestVerifyInit_ex(md_ctx, nullptr, RSA_HASH_ALGO, nullptr, nullptr, key, nullptr);
+            if (init < 1)
+            {
+                LOG_ERROR << "Message Digest Signing init failed.";
+                EVP_MD_CTX_free(md_ctx);
+                return nullptr;
+            }
+            EVP_PKEY_up_ref(key);
+            entry = contexts.add({key, kind, nullptr, md_ctx});
+        }
+        // copying the primed template skips the algorithm fetch and key setup of a fresh init
+        EVP_MD_CTX *work = CryptoContexts::digestContext();
+        if (work == nullptr || EVP_MD_CTX_copy_ex(work, entry->md_ctx) != 1)
+            return nullptr;
+        return work;
+    }
+}
+
+const EVP_MD *CryptoContexts::digest()
+{
+    static EVP_MD *md = EVP_MD_fetch(nullptr, RSA_HASH_ALGO, nullptr);
+    return md;
+}
+
+EVP_MD_CTX *CryptoContexts::digestContext()
+{
+    if (contexts.work == nullptr)
+        contexts.work = EVP_MD_CTX_new();
+    else
+        EVP_MD_CTX_reset(contexts.work);
+    return contexts.work;
+}
+
+const EVP_CIPHER *CryptoContexts::aead()
+{
+    static EVP_CIPHER *cipher = EVP_CIPHER_fetch(nullptr, "AES-256-GCM", nullptr);
+    return cipher;
+}
+
+EVP_CIPHER_CTX *CryptoContexts::cipherContext()
+{
+    if (contexts.cipher == nullptr)
+        contexts.cipher = EVP_CIPHER_CTX_new();
+    else
+        EVP_CIPHER_CTX_reset(contexts.cipher);
+    return contexts.cipher;
+}
+
+EVP_PKEY_CTX *CryptoContexts::encryptContext(EVP_PKEY *key)
+{
+    Template *entry = pkeyTemplate(key, Kind::ENCRYPT);
+    return entry != nullptr ? entry->pkey_ctx : nullptr;
+}
+
+EVP_PKEY_CTX *CryptoContexts::decryptContext(EVP_PKEY *key, bool explicitRejection)
+{
+    Template *entry = pkeyTemplate(key, explicitRejection ? Kind::DECRYPT_EXPLICIT : Kind::DECRYPT);
+    return entry != nullptr ? entry->pkey_ctx : nullptr;
+}
+
+EVP_MD_CTX *CryptoContexts::signContext(EVP_PKEY *key)
+{
+    return digestTemplate(key, Kind::SIGN);
+}
+
+EVP_MD_CTX *CryptoContexts::verifyContext(EVP_PKEY *key)
+{
+    return digestTemplate(key, Kind::VERIFY);
+}
+
+void CryptoContexts::discard(EVP_PKEY *key)
+{
+    for (auto it = contexts.templates.begin(); it != contexts.templates.end();)
+    {
+        if (it->key == key)
+        {
+            freeTemplate(*it);
+            it = contexts.templates.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void CryptoContexts::release()
+{
+    contexts.clear();
+}
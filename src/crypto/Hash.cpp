@@ -1,51 +1,127 @@
 #include "crypto/Hash.hpp"
+#include "util/logging/Log.hpp"
 #include <openssl/evp.h>
-#include <openssl/md5.h>
-#include <openssl/sha.h>
-#include <cstring>
+#include <stdexcept>
 
-byte* Hash::md5(const byte* text) 
+namespace
 {
-    // MD5(text, strlen((char*)text), hash);
-    static byte hash[EVP_MAX_MD_SIZE];
-    unsigned int hash_len;
-
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-        if (mdctx == NULL) {
-            return nullptr; // Error handling for memory allocation
+    // fetched once; the EVP_md5()-style getters look the algorithm up on every init
+    const EVP_MD *algorithm(Hash::Algorithm algorithm)
+    {
+        static EVP_MD *md5 = EVP_MD_fetch(nullptr, "MD5", nullptr);
+        static EVP_MD *sha1 = EVP_MD_fetch(nullptr, "SHA1", nullptr);
+        static EVP_MD *sha256 = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+        switch (algorithm)
+        {
+        case Hash::Algorithm::MD5:
+            return md5;
+        case Hash::Algorithm::SHA1:
+            return sha1;
+        default:
+            return sha256;
         }
+    }
 
-        if (1 != EVP_DigestInit_ex(mdctx, EVP_md5(), NULL)) {
-            EVP_MD_CTX_free(mdctx);
-            return nullptr; // Error initializing digest context
-        }
+    struct ThreadContext
+    {
+        EVP_MD_CTX *ctx = EVP_MD_CTX_new();
 
-        if (1 != EVP_DigestUpdate(mdctx, text, strlen((char*)text))) {
-            EVP_MD_CTX_free(mdctx);
-            return nullptr; // Error updating digest
+        ~ThreadContext()
+        {
+            EVP_MD_CTX_free(ctx);
         }
+    };
 
-        if (1 != EVP_DigestFinal_ex(mdctx, hash, &hash_len)) {
-            EVP_MD_CTX_free(mdctx);
-            return nullptr; // Error finalizing digest
+    thread_local ThreadContext context;
+
+    template <Hash::Algorithm A>
+    Hash::Digest<A> oneShot(const byte *data, size_t length)
+    {
+        Hash::Digest<A> digest{};
+        unsigned int digest_len = 0;
+        if (context.ctx == nullptr ||
+            EVP_DigestInit_ex2(context.ctx, algorithm(A), nullptr) != 1 ||
+            EVP_DigestUpdate(context.ctx, data, length) != 1 ||
+            EVP_DigestFinal_ex(context.ctx, digest.data(), &digest_len) != 1)
+        {
+            LOG_ERROR << "Message digest failed";
+            throw std::runtime_error("Message digest failed");
         }
+        return digest;
+    }
+}
 
-        EVP_MD_CTX_free(mdctx); // Free the context
-        return hash;
-    return hash;
+Hash::Digest<Hash::Algorithm::MD5> Hash::md5(const byte *data, size_t length)
+{
+    return oneShot<Algorithm::MD5>(data, length);
 }
 
+Hash::Digest<Hash::Algorithm::MD5> Hash::md5(std::string_view data)
+{
+    return md5(reinterpret_cast<const byte *>(data.data()), data.size());
+}
 
-byte *Hash::sha1(const byte *text)
+Hash::Digest<Hash::Algorithm::SHA1> Hash::sha1(const byte *data, size_t length)
 {
-    static byte hash[SHA_DIGEST_LENGTH];
-    SHA1(text, strlen((char*)text), hash);
-    return hash;
+    return oneShot<Algorithm::SHA1>(data, length);
 }
 
-byte *Hash::sha256(const byte *text)
+Hash::Digest<Hash::Algorithm::SHA1> Hash::sha1(std::string_view data)
 {
-    static byte hash[SHA256_DIGEST_LENGTH];
-    SHA256(text, strlen((char*)text), hash);
-    return hash;
+    return sha1(reinterpret_cast<const byte *>(data.data()), data.size());
 }
+
+Hash::Digest<Hash::Algorithm::SHA256> Hash::sha256(const byte *data, size_t length)
+{
+    return oneShot<Algorithm::SHA256>(data, length);
+}
+
+Hash::Digest<Hash::Algorithm::SHA256> Hash::sha256(std::string_view data)
+{
+    return sha256(reinterpret_cast<const byte *>(data.data()), data.size());
+}
+
+template <Hash::Algorithm A>
+Hash::Stream<A>::Stream() : ctx(EVP_MD_CTX_new())
+{
+    if (ctx == nullptr || EVP_DigestInit_ex2(ctx, algorithm(A), nullptr) != 1)
+    {
+        EVP_MD_CTX_free(ctx);
+        throw std::runtime_error("Message digest initialization failed");
+    }
+}
+
+template <Hash::Algorithm A>
+Hash::Stream<A>::~Stream()
+{
+    EVP_MD_CTX_free(ctx);
+}
+
+template <Hash::Algorithm A>
+Hash::Stream<A> &Hash::Stream<A>::update(const byte *data, size_t length)
+{
+    if (EVP_DigestUpdate(ctx, data, length) != 1)
+        throw std::runtime_error("Message digest update failed");
+    return *this;
+}
+
+template <Hash::Algorithm A>
+Hash::Stream<A> &Hash::Stream<A>::update(std::string_view data)
+{
+    return update(reinterpret_cast<const byte *>(data.data()), data.size());
+}
+
+template <Hash::Algorithm A>
+Hash::Digest<A> Hash::Stream<A>::finish()
+{
+    Digest<A> digest{};
+    unsigned int digest_len = 0;
+    if (EVP_DigestFinal_ex(ctx, digest.data(), &digest_len) != 1 ||
+        EVP_DigestInit_ex2(ctx, nullptr, nullptr) != 1)
+        throw std::runtime_error("Message digest finalization failed");
+    return digest;
+}
+
+template class Hash::Stream<Hash::Algorithm::MD5>;
+template class Hash::Stream<Hash::Algorithm::SHA1>;
+template class Hash::Stream<Hash::Algorithm::SHA256>;
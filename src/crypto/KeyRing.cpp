@@ -0,0 +1,194 @@
+#include <crypto/KeyRing.hpp>
+#include <crypto/AuthCrypto.hpp>
+#include <crypto/Hash.hpp>
+#include <crypto/StringEncoder.hpp>
+#include "util/logging/Log.hpp"
+#include "config.h"
+#include <openssl/x509.h>
+#include <algorithm>
+#include <filesystem>
+#include <set>
+
+namespace
+{
+    constexpr size_t KEY_ID_BYTES = 8;
+
+    bool endsWith(const std::string &text, const std::string &suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // tags of the `<name>.<tag>` pairs present in either archive
+    void retiredTags(const std::string &directory, const std::string &name, const std::string &postfix, std::set<std::string> &tags)
+    {
+        std::error_code error;
+        std::string prefix = name + ".";
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+        {
+            std::string file = entry.path().filename().string();
+            if (file.size() > prefix.size() + postfix.size() && file.compare(0, prefix.size(), prefix) == 0 && endsWith(file, postfix))
+                tags.insert(file.substr(prefix.size(), file.size() - prefix.size() - postfix.size()));
+        }
+    }
+
+    std::shared_ptr<const KeyPair> readPair(const std::string &name, const char *password)
+    {
+        AuthCrypto loader(name.c_str());
+        if (loader.doesPublicKeyExists() && !loader.loadPublicKey())
+            LOG_ERROR << "Failed to parse public key " << loader.getPublicKeyFilename();
+        if (loader.doesPrivateKeyExists() && !loader.loadPrivateKey(password))
+            LOG_ERROR << "Failed to parse private key " << loader.getPrivateKeyFilename();
+        return loader.releaseKeys();
+    }
+}
+
+KeyPair::KeyPair(EVP_PKEY *public_key, EVP_PKEY *private_key) : public_key(public_key), private_key(private_key)
+{
+    EVP_PKEY *key = public_key != nullptr ? public_key : private_key;
+    unsigned char *der = nullptr;
+    int length = key != nullptr ? i2d_PUBKEY(key, &der) : 0;
+    if (length > 0)
+    {
+        auto digest = Hash::sha256(der, static_cast<size_t>(length));
+        key_id = StringEncoder::bytesToHex(digest.data(), KEY_ID_BYTES);
+    }
+    OPENSSL_free(der);
+}
+
+KeyPair::~KeyPair()
+{
+    if (public_key != nullptr)
+        EVP_PKEY_free(public_key);
+    if (private_key != nullptr)
+        EVP_PKEY_free(private_key);
+}
+
+EVP_PKEY *KeyPair::publicKey() const
+{
+    return public_key;
+}
+
+EVP_PKEY *KeyPair::privateKey() const
+{
+    return private_key;
+}
+
+const std::string &KeyPair::id() const
+{
+    return key_id;
+}
+
+KeySet::KeySet(std::shared_ptr<const KeyPair> current, std::vector<std::shared_ptr<const KeyPair>> retired)
+{
+    pairs.push_back(std::move(current));
+    for (auto &pair : retired)
+    {
+        if (pair == nullptr || pair->id().empty() || find(pair->id()) != nullptr)
+            continue;
+        pairs.push_back(std::move(pair));
+    }
+}
+
+const std::shared_ptr<const KeyPair> &KeySet::current() const
+{
+    return pairs.front();
+}
+
+std::shared_ptr<const KeyPair> KeySet::find(const std::string &id) const
+{
+    if (id.empty())
+        return nullptr;
+    for (const auto &pair : pairs)
+    {
+        if (pair != nullptr && pair->id() == id)
+            return pair;
+    }
+    return nullptr;
+}
+
+const std::vector<std::shared_ptr<const KeyPair>> &KeySet::all() const
+{
+    return pairs;
+}
+
+KeyRing &KeyRing::instance()
+{
+    static KeyRing ring;
+    return ring;
+}
+
+KeyRing::KeyRing() : sets(std::make_shared<const Sets>())
+{
+}
+
+std::shared_ptr<const KeySet> KeyRing::read(const std::string &name, const char *password)
+{
+    std::set<std::string> tags;
+    retiredTags(PRV_KEY_ARCHIVE, name, PRV_KEY_POSTFIX, tags);
+    retiredTags(PUB_KEY_ARCHIVE, name, PUB_KEY_POSTFIX, tags);
+    std::vector<std::shared_ptr<const KeyPair>> retired;
+    // newest tag first when tags are dates or counters
+    for (auto tag = tags.rbegin(); tag != tags.rend(); ++tag)
+        retired.push_back(readPair(name + "." + *tag, password));
+    return std::make_shared<const KeySet>(readPair(name, password), std::move(retired));
+}
+
+void KeyRing::publish(const std::string &name, std::shared_ptr<const KeySet> set)
+{
+    // copy-on-write: readers holding the previous map keep it alive until they let go
+    auto next = std::make_shared<Sets>(*std::atomic_load(&sets));
+    (*next)[name] = std::move(set);
+    std::atomic_store(&sets, std::shared_ptr<const Sets>(std::move(next)));
+}
+
+std::shared_ptr<const KeySet> KeyRing::loadSet(const std::string &name, const char *password)
+{
+    std::shared_ptr<const KeySet> set = read(name, password);
+    std::lock_guard<std::mutex> lock(mutex);
+    publish(name, set);
+    return set;
+}
+
+std::shared_ptr<const KeyPair> KeyRing::load(const std::string &name, const char *password)
+{
+    return loadSet(name, password)->current();
+}
+
+bool KeyRing::reload(const std::string &name, const char *password)
+{
+    std::shared_ptr<const KeySet> set = read(name, password);
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const Sets> published = std::atomic_load(&sets);
+    auto it = published->find(name);
+    if (it != published->end() && it->second->current()->privateKey() != nullptr && set->current()->privateKey() == nullptr)
+    {
+        LOG_ERROR << "Keeping keys " << it->second->current()->id() << " for " << name << ": new private key is unreadable";
+        return false;
+    }
+    if (it == published->end() || it->second->current()->id() != set->current()->id())
+        LOG_INFO << "Key " << name << " now " << set->current()->id() << " with " << set->all().size() - 1 << " retired";
+    publish(name, set);
+    return true;
+}
+
+std::shared_ptr<const KeyPair> KeyRing::get(const std::string &name)
+{
+    return keys(name)->current();
+}
+
+std::shared_ptr<const KeySet> KeyRing::keys(const std::string &name)
+{
+    {
+        std::shared_ptr<const Sets> published = std::atomic_load(&sets);
+        auto it = published->find(name);
+        if (it != published->end())
+            return it->second;
+    }
+    return loadSet(name, "");
+}
+
+void KeyRing::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::atomic_store(&sets, std::make_shared<const Sets>());
+}
@@ -1,16 +1,23 @@
 #include <crypto/RsaClient.hpp>
 #include "config.h"
+#include <stdexcept>
 
 std::unique_ptr<AuthCrypto> RsaClient::getInstance()
 {
-    std::unique_ptr<AuthCrypto> instance = std::make_unique<AuthCrypto>(FRONTEND_RSA_FILE_NAME);
-    if (instance->doesPublicKeyExists())
-    {
-        instance->loadPublicKey();
-    }
-    if (instance->doesPrivateKeyExists())
+    return std::make_unique<AuthCrypto>(FRONTEND_RSA_FILE_NAME, KeyRing::instance().get(FRONTEND_RSA_FILE_NAME));
+}
+
+std::unique_ptr<AuthCrypto> RsaClient::getInstance(const std::string &keyId)
+{
+    std::shared_ptr<const KeyPair> pair = keys()->find(keyId);
+    if (pair == nullptr)
     {
-        instance->loadPrivateKey("");
+        throw std::runtime_error("Unknown frontend key id " + keyId);
     }
-    return instance;
+    return std::make_unique<AuthCrypto>(FRONTEND_RSA_FILE_NAME, pair);
+}
+
+std::shared_ptr<const KeySet> RsaClient::keys()
+{
+    return KeyRing::instance().keys(FRONTEND_RSA_FILE_NAME);
 }
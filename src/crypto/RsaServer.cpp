@@ -1,25 +1,28 @@
 #include <crypto/RsaServer.hpp>
 #include "config.h"
+#include <stdexcept>
 
 std::unique_ptr<AuthCrypto> RsaServer::getInstance()
 {
-    std::unique_ptr<AuthCrypto> instance = std::make_unique<AuthCrypto>(BACKEND_RSA_FILE_NAME);
-    if (instance->doesPublicKeyExists())
-    {
-        instance->loadPublicKey();
-    }
-    else
+    std::shared_ptr<const KeyPair> keys = KeyRing::instance().get(BACKEND_RSA_FILE_NAME);
+    if (keys->publicKey() == nullptr || keys->privateKey() == nullptr)
     {
         throw std::exception();
     }
-    if (instance->doesPrivateKeyExists())
-    {
-        instance->loadPrivateKey("");
-    }
-    else
+    return std::make_unique<AuthCrypto>(BACKEND_RSA_FILE_NAME, keys);
+}
+
+std::unique_ptr<AuthCrypto> RsaServer::getInstance(const std::string &keyId)
+{
+    std::shared_ptr<const KeyPair> pair = keys()->find(keyId);
+    if (pair == nullptr || pair->privateKey() == nullptr)
     {
-        throw std::exception();
+        throw std::runtime_error("Unknown backend key id " + keyId);
     }
+    return std::make_unique<AuthCrypto>(BACKEND_RSA_FILE_NAME, pair);
+}
 
-    return instance;
+std::shared_ptr<const KeySet> RsaServer::keys()
+{
+    return KeyRing::instance().keys(BACKEND_RSA_FILE_NAME);
 }
@@ -0,0 +1,73 @@
+#include <crypto/SessionCipher.hpp>
+#include <crypto/CryptoContexts.hpp>
+#include "util/logging/Log.hpp"
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <stdexcept>
+
+SessionCipher::SessionCipher(const byte *key, size_t length)
+{
+    if (key == nullptr || length != KEY_SIZE)
+        throw std::invalid_argument("Session key must be 32 bytes");
+    this->key.assign(key, key + length);
+}
+
+SessionCipher::~SessionCipher()
+{
+    OPENSSL_cleanse(key.data(), key.size());
+}
+
+std::string SessionCipher::seal(const std::string &plaintext, const std::string &aad) const
+{
+    std::string sealed(IV_SIZE + plaintext.size() + TAG_SIZE, '\0');
+    byte *iv = reinterpret_cast<byte *>(&sealed[0]);
+    byte *out = iv + IV_SIZE;
+    if (RAND_bytes(iv, IV_SIZE) != 1)
+    {
+        LOG_ERROR << "Session IV generation failed";
+        return "";
+    }
+    EVP_CIPHER_CTX *ctx = CryptoContexts::cipherContext();
+    int length = 0;
+    int final_length = 0;
+    if (ctx == nullptr ||
+        EVP_EncryptInit_ex2(ctx, CryptoContexts::aead(), key.data(), iv, nullptr) != 1 ||
+        (!aad.empty() && EVP_EncryptUpdate(ctx, nullptr, &length, reinterpret_cast<const byte *>(aad.data()), static_cast<int>(aad.size())) != 1) ||
+        EVP_EncryptUpdate(ctx, out, &length, reinterpret_cast<const byte *>(plaintext.data()), static_cast<int>(plaintext.size())) != 1 ||
+        EVP_EncryptFinal_ex(ctx, out + length, &final_length) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, TAG_SIZE, out + plaintext.size()) != 1)
+    {
+        LOG_ERROR << "Session encryption failed";
+        return "";
+    }
+    return sealed;
+}
+
+bool SessionCipher::open(const std::string &sealed, std::string &plaintext, const std::string &aad) const
+{
+    if (sealed.size() < IV_SIZE + TAG_SIZE)
+        return false;
+    const byte *iv = reinterpret_cast<const byte *>(sealed.data());
+    const byte *in = iv + IV_SIZE;
+    size_t in_length = sealed.size() - IV_SIZE - TAG_SIZE;
+    std::string tag = sealed.substr(sealed.size() - TAG_SIZE);
+
+    std::string out(in_length, '\0');
+    EVP_CIPHER_CTX *ctx = CryptoContexts::cipherContext();
+    int length = 0;
+    int final_length = 0;
+    if (ctx == nullptr ||
+        EVP_DecryptInit_ex2(ctx, CryptoContexts::aead(), key.data(), iv, nullptr) != 1 ||
+        (!aad.empty() && EVP_DecryptUpdate(ctx, nullptr, &length, reinterpret_cast<const byte *>(aad.data()), static_cast<int>(aad.size())) != 1) ||
+        EVP_DecryptUpdate(ctx, reinterpret_cast<byte *>(&out[0]), &length, in, static_cast<int>(in_length)) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, TAG_SIZE, &tag[0]) != 1)
+        return false;
+    // the tag is only checked here; nothing decrypted is returned unless it matches
+    if (EVP_DecryptFinal_ex(ctx, reinterpret_cast<byte *>(&out[0]) + length, &final_length) != 1)
+    {
+        OPENSSL_cleanse(&out[0], out.size());
+        return false;
+    }
+    plaintext.swap(out);
+    return true;
+}
@@ -1,9 +1,270 @@
 #include "crypto/StringEncoder.hpp"
 #include <sstream>
 #include <iomanip>
-#include <openssl/evp.h>
-#include <openssl/buffer.h>
-#include <openssl/bio.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define INDIE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    constexpr char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    constexpr std::uint8_t INVALID = 0xff;
+    constexpr std::uint8_t SKIP = 0xfe;
+    constexpr std::uint8_t PAD = 0xfd;
+
+    struct Tables
+    {
+        std::uint8_t hex[256];
+        std::uint8_t base64[256];
+        // two hex characters per byte value, so encoding is one 16-bit store per byte
+        char hex_pairs[512];
+
+        Tables()
+        {
+            std::memset(hex, INVALID, sizeof(hex));
+            for (int i = 0; i < 10; ++i)
+                hex['0' + i] = static_cast<std::uint8_t>(i);
+            for (int i = 0; i < 6; ++i)
+            {
+                hex['a' + i] = static_cast<std::uint8_t>(10 + i);
+                hex['A' + i] = static_cast<std::uint8_t>(10 + i);
+            }
+            std::memset(base64, INVALID, sizeof(base64));
+            for (int i = 0; i < 64; ++i)
+                base64[static_cast<std::uint8_t>(BASE64_ALPHABET[i])] = static_cast<std::uint8_t>(i);
+            base64['\n'] = SKIP;
+            base64['\r'] = SKIP;
+            base64['='] = PAD;
+            for (int i = 0; i < 256; ++i)
+            {
+                hex_pairs[2 * i] = HEX_DIGITS[i >> 4];
+                hex_pairs[2 * i + 1] = HEX_DIGITS[i & 0x0f];
+            }
+        }
+    };
+
+    const Tables tables;
+
+    void hexEncodeScalar(const byte *in, size_t length, char *out)
+    {
+        for (size_t i = 0; i < length; ++i)
+            std::memcpy(out + 2 * i, tables.hex_pairs + 2 * in[i], 2);
+    }
+
+    size_t base64EncodeScalar(const byte *in, size_t length, char *out)
+    {
+        char *start = out;
+        size_t i = 0;
+        for (; i + 3 <= length; i += 3)
+        {
+            std::uint32_t triple = (std::uint32_t(in[i]) << 16) | (std::uint32_t(in[i + 1]) << 8) | in[i + 2];
+            out[0] = BASE64_ALPHABET[(triple >> 18) & 0x3f];
+            out[1] = BASE64_ALPHABET[(triple >> 12) & 0x3f];
+            out[2] = BASE64_ALPHABET[(triple >> 6) & 0x3f];
+            out[3] = BASE64_ALPHABET[triple & 0x3f];
+            out += 4;
+        }
+        if (i < length)
+        {
+            std::uint32_t triple = std::uint32_t(in[i]) << 16;
+            if (i + 1 < length)
+                triple |= std::uint32_t(in[i + 1]) << 8;
+            out[0] = BASE64_ALPHABET[(triple >> 18) & 0x3f];
+            out[1] = BASE64_ALPHABET[(triple >> 12) & 0x3f];
+            out[2] = i + 1 < length ? BASE64_ALPHABET[(triple >> 6) & 0x3f] : '=';
+            out[3] = '=';
+            out += 4;
+        }
+        return static_cast<size_t>(out - start);
+    }
+
+    size_t base64DecodeScalar(const char *text, size_t length, byte *out)
+    {
+        byte *start = out;
+        std::uint32_t accumulator = 0;
+        int bits = 0;
+        size_t symbols = 0;
+        size_t padding = 0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            std::uint8_t value = tables.base64[static_cast<std::uint8_t>(text[i])];
+            if (value == SKIP)
+                continue;
+            if (value == PAD)
+            {
+                ++padding;
+                continue;
+            }
+            if (value == INVALID || padding > 0)
+                return SIZE_MAX;
+            accumulator = (accumulator << 6) | value;
+            bits += 6;
+            ++symbols;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                *out++ = static_cast<byte>(accumulator >> bits);
+                accumulator &= (1u << bits) - 1;
+            }
+        }
+        // a single trailing symbol cannot hold a byte; padding, when present, must complete the quartet
+        if (symbols % 4 == 1 || padding > 2 || (padding > 0 && (symbols + padding) % 4 != 0))
+            return SIZE_MAX;
+        return static_cast<size_t>(out - start);
+    }
+
+#ifdef INDIE_X86_SIMD
+    __attribute__((target("ssse3"))) void hexEncodeSse(const byte *in, size_t length, char *out)
+    {
+        const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+            __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+            __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, nibble));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+        }
+        hexEncodeScalar(in + i, length - i, out + 2 * i);
+    }
+
+    __attribute__((target("avx2"))) void hexEncodeAvx2(const byte *in, size_t length, char *out)
+    {
+        const __m256i digits = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                                                '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32)
+        {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+            __m256i high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+            __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, nibble));
+            // unpack works per 128-bit lane; put the lanes back in input order
+            __m256i first = _mm256_unpacklo_epi8(high, low);
+            __m256i second = _mm256_unpackhi_epi8(high, low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+        }
+        hexEncodeSse(in + i, length - i, out + 2 * i);
+    }
+
+    // 12 input bytes -> 16 characters per step (W. Mula's multiply-shift and pshufb lookup)
+    __attribute__((target("sse4.1"))) size_t base64EncodeSse(const byte *in, size_t length, char *out)
+    {
+        const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        size_t i = 0;
+        size_t written = 0;
+        // 16-byte loads of which 12 are used: stop while 4 bytes of slack remain
+        for (; i + 16 <= length; i += 12, written += 16)
+        {
+            __m128i bytes = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), spread);
+            __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+            __m128i t1 = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+            __m128i indices = _mm_or_si128(t0, t1);
+            __m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+            __m128i lower = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+            reduced = _mm_or_si128(reduced, _mm_and_si128(lower, _mm_set1_epi8(13)));
+            __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(offsets, reduced), indices);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + written), chars);
+        }
+        return written + base64EncodeScalar(in + i, length - i, out + written);
+    }
+
+    // 16 characters -> 12 bytes per step; a block with anything but alphabet characters
+    // (padding, line breaks, garbage) is left to the scalar decoder from that point on
+    __attribute__((target("sse4.1"))) size_t base64DecodeSse(const char *text, size_t length, byte *out)
+    {
+        const __m128i shifts = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i masks = _mm_setr_epi8(static_cast<char>(0xa8), static_cast<char>(0xf8), static_cast<char>(0xf8), static_cast<char>(0xf8),
+                                            static_cast<char>(0xf8), static_cast<char>(0xf8), static_cast<char>(0xf8), static_cast<char>(0xf8),
+                                            static_cast<char>(0xf8), static_cast<char>(0xf8), static_cast<char>(0xf0), 0x54, 0x50, 0x50, 0x50, 0x54);
+        const __m128i positions = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80), 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        size_t i = 0;
+        size_t written = 0;
+        for (; i + 16 <= length; i += 16, written += 12)
+        {
+            __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+            __m128i high = _mm_and_si128(_mm_srli_epi32(input, 4), nibble);
+            __m128i low = _mm_and_si128(input, nibble);
+            __m128i valid = _mm_and_si128(_mm_shuffle_epi8(masks, low), _mm_shuffle_epi8(positions, high));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(valid, _mm_setzero_si128())) != 0)
+                break;
+            __m128i shift = _mm_blendv_epi8(_mm_shuffle_epi8(shifts, high), _mm_set1_epi8(16),
+                                            _mm_cmpeq_epi8(input, _mm_set1_epi8('/')));
+            __m128i values = _mm_add_epi8(input, shift);
+            __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            alignas(16) byte block[16];
+            _mm_store_si128(reinterpret_cast<__m128i *>(block), _mm_shuffle_epi8(words, pack));
+            std::memcpy(out + written, block, 12);
+        }
+        size_t rest = base64DecodeScalar(text + i, length - i, out + written);
+        return rest == SIZE_MAX ? SIZE_MAX : written + rest;
+    }
+#endif
+
+    enum class Level
+    {
+        SCALAR,
+        SSE41,
+        AVX2
+    };
+
+    Level detect()
+    {
+        const char *forced = std::getenv("INDIEBACK_SIMD");
+        if (forced != nullptr && std::strcmp(forced, "off") == 0)
+            return Level::SCALAR;
+#ifdef INDIE_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return Level::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return Level::SSE41;
+#endif
+        return Level::SCALAR;
+    }
+
+    struct Kernels
+    {
+        Level level;
+        void (*hexEncode)(const byte *, size_t, char *);
+        size_t (*base64Encode)(const byte *, size_t, char *);
+        size_t (*base64Decode)(const char *, size_t, byte *);
+
+        Kernels() : level(detect()), hexEncode(hexEncodeScalar), base64Encode(base64EncodeScalar), base64Decode(base64DecodeScalar)
+        {
+#ifdef INDIE_X86_SIMD
+            if (level != Level::SCALAR)
+            {
+                hexEncode = level == Level::AVX2 ? hexEncodeAvx2 : hexEncodeSse;
+                base64Encode = base64EncodeSse;
+                base64Decode = base64DecodeSse;
+            }
+#endif
+        }
+    };
+
+    const Kernels &kernels()
+    {
+        static const Kernels selected;
+        return selected;
+    }
+}
 
 std::vector<byte> StringEncoder::stringToBytes(const std::string& str) {
     return std::vector<unsigned char>(str.begin(), str.end());
@@ -11,28 +272,14 @@ std::vector<byte> StringEncoder::stringToBytes(const std::string& str) {
 
 std::string StringEncoder::bytesToString(const byte *bytes, size_t length)
 {
-    
+
     return std::string(reinterpret_cast<const char*>(bytes), length);
 }
 
 std::string StringEncoder::base64Encode(const byte *bytes, size_t length)
 {
-    BIO *bio, *b64;
-    BUF_MEM *bufferPtr;
-    
-    b64 = BIO_new(BIO_f_base64());
-    bio = BIO_new(BIO_s_mem());
-    bio = BIO_push(b64, bio);
-
-    BIO_write(bio, bytes, length);
-    BIO_flush(bio);
-    BIO_get_mem_ptr(bio, &bufferPtr);
-    BIO_set_close(bio, BIO_NOCLOSE);
-    BIO_free_all(bio);
-
-    std::string encodedData(bufferPtr->data, bufferPtr->length);
-    BUF_MEM_free(bufferPtr);
-
+    std::string encodedData(base64EncodedSize(length), '\0');
+    base64Encode(bytes, length, &encodedData[0]);
     return encodedData;
 }
 
@@ -41,58 +288,28 @@ std::vector<byte> StringEncoder::base64Decode(const std::string &encodedData)
     if (encodedData.empty()) {
         return {};
     }
-    /*
-    BIO *bio, *b64;
-    int decodeLen = encodedData.length();
-    std::vector<byte> decodedData(decodeLen);
-
-    b64 = BIO_new(BIO_f_base64());
-    bio = BIO_new_mem_buf(encodedData.data(), decodeLen);
-    bio = BIO_push(b64, bio);
-
-    decodeLen = BIO_read(bio, decodedData.data(), decodeLen);
-    decodedData.resize(decodeLen);
-
-    BIO_free_all(bio);
-
-    return decodedData;
-    */
-    BIO* bio = BIO_new_mem_buf(encodedData.c_str(), encodedData.size());
-    BIO* b64 = BIO_new(BIO_f_base64());
-    BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL); // Handle base64 without newlines
-    bio = BIO_push(b64, bio);
-    std::vector<unsigned char> decoded((encodedData.size() * 3) / 4); // Approximate size
-    int len = BIO_read(bio, decoded.data(), decoded.size());
-    BIO_free_all(bio);
-    if (len > 0) {
-        decoded.resize(len); // Adjust to actual size
-    } else {
+    std::vector<byte> decoded(base64DecodedMaxSize(encodedData.size()));
+    size_t len = base64Decode(encodedData.data(), encodedData.size(), decoded.data());
+    if (len == SIZE_MAX) {
         decoded.clear(); // Decoding failed
+    } else {
+        decoded.resize(len); // Adjust to actual size
     }
     return decoded;
 }
 
 std::string StringEncoder::bytesToHex(const byte *bytes, size_t length)
 {
-    std::ostringstream oss;
-    for (size_t i = 0; i < length; ++i) {
-        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(bytes[i]);
-    }
-    return oss.str();
+    std::string hex(2 * length, '\0');
+    hexEncode(bytes, length, &hex[0]);
+    return hex;
 }
 
 std::vector<byte> StringEncoder::hexToBytes(const std::string &hexStr)
 {
-    std::vector<byte> bytes;
-    size_t len = hexStr.length();
-    bytes.reserve(len / 2);
-    
-    for (size_t i = 0; i < len; i += 2) {
-        std::string byteStr = hexStr.substr(i, 2);
-        unsigned char byte = static_cast<unsigned char>(std::stoul(byteStr, nullptr, 16));
-        bytes.push_back(byte);
-    }
-    
+    std::vector<byte> bytes(hexStr.length() / 2);
+    if (!hexDecode(hexStr.data(), hexStr.length(), bytes.data()))
+        throw std::invalid_argument("Invalid hex string");
     return bytes;
 }
 
@@ -103,3 +320,57 @@ unsigned long long StringEncoder::hexToInteger(const std::string &hexStr)
     iss >> std::hex >> value;
     return value;
 }
+
+void StringEncoder::hexEncode(const byte *bytes, size_t length, char *out)
+{
+    kernels().hexEncode(bytes, length, out);
+}
+
+bool StringEncoder::hexDecode(const char *hex, size_t length, byte *out)
+{
+    if (length % 2 != 0)
+        return false;
+    // table lookups; hex input is short (ids, digests), so there is no vector kernel
+    std::uint8_t invalid = 0;
+    for (size_t i = 0; i < length; i += 2)
+    {
+        std::uint8_t high = tables.hex[static_cast<std::uint8_t>(hex[i])];
+        std::uint8_t low = tables.hex[static_cast<std::uint8_t>(hex[i + 1])];
+        invalid |= (high | low) & 0xf0;
+        out[i / 2] = static_cast<byte>((high << 4) | (low & 0x0f));
+    }
+    return invalid == 0;
+}
+
+size_t StringEncoder::base64EncodedSize(size_t length)
+{
+    return 4 * ((length + 2) / 3);
+}
+
+size_t StringEncoder::base64Encode(const byte *bytes, size_t length, char *out)
+{
+    return kernels().base64Encode(bytes, length, out);
+}
+
+size_t StringEncoder::base64DecodedMaxSize(size_t length)
+{
+    return 3 * (length / 4) + 3;
+}
+
+size_t StringEncoder::base64Decode(const char *text, size_t length, byte *out)
+{
+    return kernels().base64Decode(text, length, out);
+}
+
+const char *StringEncoder::simdLevel()
+{
+    switch (kernels().level)
+    {
+    case Level::AVX2:
+        return "avx2";
+    case Level::SSE41:
+        return "sse4.1";
+    default:
+        return "scalar";
+    }
+}
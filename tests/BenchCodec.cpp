@@ -0,0 +1,102 @@
+#include <crypto/StringEncoder.hpp>
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Hex and base64 throughput of StringEncoder against the ostringstream / BIO versions it replaced.
+//
+// usage: indieback_codec_bench [iterations]
+
+namespace
+{
+    std::string legacyHex(const byte *bytes, size_t length)
+    {
+        std::ostringstream oss;
+        for (size_t i = 0; i < length; ++i)
+            oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(bytes[i]);
+        return oss.str();
+    }
+
+    std::string legacyBase64Encode(const byte *bytes, size_t length)
+    {
+        BIO *b64 = BIO_new(BIO_f_base64());
+        BIO *bio = BIO_push(b64, BIO_new(BIO_s_mem()));
+        BUF_MEM *buffer;
+        BIO_write(bio, bytes, static_cast<int>(length));
+        BIO_flush(bio);
+        BIO_get_mem_ptr(bio, &buffer);
+        BIO_set_close(bio, BIO_NOCLOSE);
+        BIO_free_all(bio);
+        std::string encoded(buffer->data, buffer->length);
+        BUF_MEM_free(buffer);
+        return encoded;
+    }
+
+    std::vector<byte> legacyBase64Decode(const std::string &encoded)
+    {
+        BIO *bio = BIO_new_mem_buf(encoded.c_str(), static_cast<int>(encoded.size()));
+        BIO *b64 = BIO_new(BIO_f_base64());
+        BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
+        bio = BIO_push(b64, bio);
+        std::vector<byte> decoded((encoded.size() * 3) / 4);
+        int len = BIO_read(bio, decoded.data(), static_cast<int>(decoded.size()));
+        BIO_free_all(bio);
+        decoded.resize(len > 0 ? len : 0);
+        return decoded;
+    }
+
+    template <typename Job>
+    void run(const std::string &name, size_t payload, int iterations, Job job)
+    {
+        size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            sink += job();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << std::left << std::setw(24) << name
+                  << " ns_per_op=" << std::setw(10) << seconds * 1e9 / iterations
+                  << " mb_per_sec=" << payload * static_cast<double>(iterations) / seconds / (1024 * 1024)
+                  << " (" << sink % 7 << ")" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::cout << "kernels: " << StringEncoder::simdLevel() << std::endl;
+
+    // 32: digest / token, 512: RSA-4096 ciphertext or signature, 4096: sealed request body
+    for (size_t payload : {32, 512, 4096})
+    {
+        std::vector<byte> data(payload);
+        for (size_t i = 0; i < payload; ++i)
+            data[i] = static_cast<byte>(i * 131 + 7);
+        std::string encoded = StringEncoder::base64Encode(data.data(), data.size());
+        std::string buffer(StringEncoder::base64EncodedSize(payload) + 2 * payload, '\0');
+        std::vector<byte> decoded(StringEncoder::base64DecodedMaxSize(encoded.size()));
+
+        std::cout << "payload " << payload << " bytes" << std::endl;
+        run("hex legacy", payload, iterations, [&]() { return legacyHex(data.data(), data.size()).size(); });
+        run("hex string", payload, iterations, [&]() { return StringEncoder::bytesToHex(data.data(), data.size()).size(); });
+        run("hex buffer", payload, iterations, [&]() {
+            StringEncoder::hexEncode(data.data(), data.size(), &buffer[0]);
+            return static_cast<size_t>(buffer[0]);
+        });
+        run("base64 encode legacy", payload, iterations, [&]() { return legacyBase64Encode(data.data(), data.size()).size(); });
+        run("base64 encode string", payload, iterations, [&]() { return StringEncoder::base64Encode(data.data(), data.size()).size(); });
+        run("base64 encode buffer", payload, iterations, [&]() { return StringEncoder::base64Encode(data.data(), data.size(), &buffer[0]); });
+        run("base64 decode legacy", payload, iterations, [&]() { return legacyBase64Decode(encoded).size(); });
+        run("base64 decode vector", payload, iterations, [&]() { return StringEncoder::base64Decode(encoded).size(); });
+        run("base64 decode buffer", payload, iterations, [&]() {
+            return StringEncoder::base64Decode(encoded.data(), encoded.size(), decoded.data());
+        });
+    }
+    return 0;
+}
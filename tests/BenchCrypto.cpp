@@ -0,0 +1,316 @@
+#include <crypto/AuthCrypto.hpp>
+#include <crypto/Hash.hpp>
+#include <crypto/KeyRing.hpp>
+#include <crypto/StringEncoder.hpp>
+#include <openssl/crypto.h>
+#include <openssl/opensslv.h>
+#include <openssl/rsa.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput and latency of the request-path crypto at 1..N threads: AuthCrypto encrypt,
+// decrypt, sign and verify per key size, Hash::sha256 and the StringEncoder codecs. RSA
+// operations run twice per thread count, once with every thread sharing one AuthCrypto (the
+// way rest_api shares a KeyRing pair) and once with an AuthCrypto and key copy per thread;
+// the "contention" section is the ratio of the two. Progress goes to stderr, JSON to stdout
+// or to `json-file`.
+//
+// usage: indieback_crypto_bench [max-threads] [seconds-per-case] [bits,bits,...] [json-file]
+
+namespace
+{
+    // a sealed session key or a short token, the typical RSA payload
+    const char *PAYLOAD = "0123456789abcdef0123456789abcdef";
+
+    struct Result
+    {
+        std::string group;
+        std::string op;
+        int bits = 0;
+        std::string mode;
+        int threads = 0;
+        std::uint64_t ops = 0;
+        std::uint64_t errors = 0;
+        double ops_per_sec = 0;
+        double p50_us = 0;
+        double p90_us = 0;
+        double p99_us = 0;
+        double max_us = 0;
+    };
+
+    // Job(thread index) returns false on a failed operation.
+    using Job = std::function<bool(int)>;
+
+    Result measure(int threads, double seconds, const Job &job)
+    {
+        std::vector<std::vector<double>> samples(threads);
+        std::vector<std::uint64_t> errors(threads, 0);
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        auto budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                samples[t].reserve(1 << 16);
+                ++ready;
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                auto deadline = std::chrono::steady_clock::now() + budget;
+                for (;;)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    if (start >= deadline)
+                        break;
+                    if (!job(t))
+                        ++errors[t];
+                    samples[t].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+                }
+            });
+        }
+        while (ready.load() < threads)
+            std::this_thread::yield();
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &worker : workers)
+            worker.join();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Result result;
+        result.threads = threads;
+        std::vector<double> all;
+        for (int t = 0; t < threads; ++t)
+        {
+            all.insert(all.end(), samples[t].begin(), samples[t].end());
+            result.errors += errors[t];
+        }
+        result.ops = all.size();
+        result.ops_per_sec = all.size() / elapsed;
+        if (all.empty())
+            return result;
+        std::sort(all.begin(), all.end());
+        auto percentile = [&all](double q) { return all[std::min(all.size() - 1, static_cast<size_t>(q * all.size()))]; };
+        result.p50_us = percentile(0.50);
+        result.p90_us = percentile(0.90);
+        result.p99_us = percentile(0.99);
+        result.max_us = all.back();
+        return result;
+    }
+
+    std::shared_ptr<const KeyPair> generate(int bits)
+    {
+        EVP_PKEY *pkey = EVP_RSA_gen(bits);
+        if (pkey == nullptr)
+            return nullptr;
+        // KeyPair frees each half, so the private half holds its own reference
+        EVP_PKEY_up_ref(pkey);
+        return std::make_shared<KeyPair>(pkey, pkey);
+    }
+
+    // A separately allocated copy of the same key material, so threads share no OpenSSL state.
+    std::shared_ptr<const KeyPair> copy(const std::shared_ptr<const KeyPair> &keys)
+    {
+        EVP_PKEY *pkey = EVP_PKEY_dup(keys->privateKey());
+        if (pkey == nullptr)
+            return nullptr;
+        EVP_PKEY_up_ref(pkey);
+        return std::make_shared<KeyPair>(pkey, pkey);
+    }
+
+    std::vector<int> threadCounts(int max)
+    {
+        std::vector<int> counts;
+        for (int t = 1; t < max; t *= 2)
+            counts.push_back(t);
+        counts.push_back(max);
+        return counts;
+    }
+
+    std::vector<int> parseBits(const std::string &list)
+    {
+        std::vector<int> bits;
+        std::istringstream in(list);
+        std::string item;
+        while (std::getline(in, item, ','))
+            if (std::atoi(item.c_str()) > 0)
+                bits.push_back(std::atoi(item.c_str()));
+        return bits;
+    }
+
+    void report(const Result &result)
+    {
+        std::cerr << "  " << result.group << " " << result.op;
+        if (result.bits > 0)
+            std::cerr << " " << result.bits;
+        std::cerr << " " << result.mode << " threads=" << result.threads
+                  << " ops_per_sec=" << result.ops_per_sec << " p50_us=" << result.p50_us
+                  << " p99_us=" << result.p99_us << (result.errors > 0 ? " ERRORS" : "") << std::endl;
+    }
+
+    std::string quoted(const std::string &text)
+    {
+        return "\"" + text + "\"";
+    }
+
+    void writeJson(std::ostream &out, int maxThreads, double seconds, const std::vector<Result> &results)
+    {
+        out << "{\n  \"openssl\": " << quoted(OPENSSL_VERSION_TEXT)
+            << ",\n  \"simd\": " << quoted(StringEncoder::simdLevel())
+            << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+            << ",\n  \"max_threads\": " << maxThreads
+            << ",\n  \"seconds_per_case\": " << seconds
+            << ",\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"group\": " << quoted(r.group) << ", \"op\": " << quoted(r.op)
+                << ", \"bits\": " << r.bits << ", \"mode\": " << quoted(r.mode) << ", \"threads\": " << r.threads
+                << ", \"ops\": " << r.ops << ", \"errors\": " << r.errors << ", \"ops_per_sec\": " << r.ops_per_sec
+                << ", \"p50_us\": " << r.p50_us << ", \"p90_us\": " << r.p90_us << ", \"p99_us\": " << r.p99_us
+                << ", \"max_us\": " << r.max_us << "}";
+        }
+        out << "\n  ],\n  \"contention\": [";
+        bool first = true;
+        for (const Result &shared : results)
+        {
+            if (shared.mode != "shared" || shared.threads == 1)
+                continue;
+            for (const Result &owned : results)
+            {
+                if (owned.mode != "per_thread" || owned.op != shared.op || owned.bits != shared.bits ||
+                    owned.threads != shared.threads || owned.ops_per_sec <= 0)
+                    continue;
+                out << (first ? "\n" : ",\n") << "    {\"op\": " << quoted(shared.op) << ", \"bits\": " << shared.bits
+                    << ", \"threads\": " << shared.threads
+                    << ", \"shared_over_per_thread\": " << shared.ops_per_sec / owned.ops_per_sec << "}";
+                first = false;
+            }
+        }
+        out << "\n  ]\n}" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    double seconds = argc > 2 ? std::atof(argv[2]) : 0.5;
+    std::vector<int> keySizes = parseBits(argc > 3 ? argv[3] : "2048,3072,4096");
+    std::string jsonFile = argc > 4 ? argv[4] : "";
+    if (maxThreads < 1)
+        maxThreads = 1;
+    if (seconds <= 0)
+        seconds = 0.5;
+    std::vector<int> counts = threadCounts(maxThreads);
+    std::vector<Result> results;
+    auto record = [&results](Result result, const std::string &group, const std::string &op, int bits, const std::string &mode) {
+        result.group = group;
+        result.op = op;
+        result.bits = bits;
+        result.mode = mode;
+        report(result);
+        results.push_back(result);
+    };
+
+    for (int bits : keySizes)
+    {
+        std::cerr << "rsa " << bits << ": generating keys" << std::endl;
+        std::shared_ptr<const KeyPair> keys = generate(bits);
+        if (keys == nullptr)
+        {
+            std::cerr << "key generation failed for " << bits << " bits" << std::endl;
+            return 1;
+        }
+        std::vector<std::unique_ptr<AuthCrypto>> owned;
+        std::vector<std::shared_ptr<const KeyPair>> copies;
+        for (int t = 0; t < maxThreads; ++t)
+        {
+            copies.push_back(copy(keys));
+            owned.emplace_back(new AuthCrypto("bench", copies.back()));
+        }
+        AuthCrypto shared("bench", keys);
+
+        // inputs for decrypt and verify, made once with the shared instance
+        unsigned char *sealed = nullptr;
+        size_t sealedLength = shared.encrypt((unsigned char *)PAYLOAD, sealed);
+        unsigned char *signature = nullptr;
+        size_t signatureLength = shared.sign(PAYLOAD, signature, "");
+        if (sealedLength == static_cast<size_t>(-1) || signatureLength == static_cast<size_t>(-1))
+        {
+            std::cerr << "setup failed for " << bits << " bits" << std::endl;
+            return 1;
+        }
+
+        std::vector<std::pair<std::string, std::function<bool(AuthCrypto &)>>> ops = {
+            {"encrypt", [](AuthCrypto &crypto) {
+                 unsigned char *out = nullptr;
+                 size_t length = crypto.encrypt((unsigned char *)PAYLOAD, out);
+                 OPENSSL_free(out);
+                 return length != static_cast<size_t>(-1);
+             }},
+            {"decrypt", [&](AuthCrypto &crypto) {
+                 unsigned char *out = nullptr;
+                 size_t length = crypto.decrypt(sealed, sealedLength, out);
+                 OPENSSL_free(out);
+                 return length != static_cast<size_t>(-1);
+             }},
+            {"sign", [](AuthCrypto &crypto) {
+                 unsigned char *out = nullptr;
+                 size_t length = crypto.sign(PAYLOAD, out, "");
+                 OPENSSL_free(out);
+                 return length != static_cast<size_t>(-1);
+             }},
+            {"verify", [&](AuthCrypto &crypto) { return crypto.verify(PAYLOAD, signature, signatureLength); }},
+        };
+        for (auto &op : ops)
+        {
+            for (int threads : counts)
+            {
+                auto &run = op.second;
+                record(measure(threads, seconds, [&](int) { return run(shared); }), "rsa", op.first, bits, "shared");
+                if (threads > 1)
+                    record(measure(threads, seconds, [&](int t) { return run(*owned[t]); }), "rsa", op.first, bits, "per_thread");
+            }
+        }
+        OPENSSL_free(sealed);
+        OPENSSL_free(signature);
+    }
+
+    // 512 bytes: an RSA-4096 ciphertext or signature, the largest blob the handlers encode
+    std::string text(512, '\0');
+    for (size_t i = 0; i < text.size(); ++i)
+        text[i] = static_cast<char>(i * 131 + 7);
+    const byte *bytes = reinterpret_cast<const byte *>(text.data());
+    std::string encoded = StringEncoder::base64Encode(bytes, text.size());
+    std::string hex = StringEncoder::bytesToHex(bytes, text.size());
+    std::vector<std::pair<std::string, Job>> codecs = {
+        {"sha256", [&](int) { Hash::sha256(text); return true; }},
+        {"base64_encode", [&](int) { return !StringEncoder::base64Encode(bytes, text.size()).empty(); }},
+        {"base64_decode", [&](int) { return StringEncoder::base64Decode(encoded).size() == text.size(); }},
+        {"hex_encode", [&](int) { return !StringEncoder::bytesToHex(bytes, text.size()).empty(); }},
+        {"hex_decode", [&](int) { return StringEncoder::hexToBytes(hex).size() == text.size(); }},
+    };
+    std::cerr << "digest and codecs, " << text.size() << " byte payload" << std::endl;
+    for (auto &codec : codecs)
+        for (int threads : counts)
+            record(measure(threads, seconds, codec.second), codec.first == "sha256" ? "hash" : "codec", codec.first, 0, "stateless");
+
+    if (jsonFile.empty())
+    {
+        writeJson(std::cout, maxThreads, seconds, results);
+        return 0;
+    }
+    std::ofstream out(jsonFile);
+    writeJson(out, maxThreads, seconds, results);
+    std::cerr << "wrote " << jsonFile << std::endl;
+    return out.good() ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include <crypto/Hash.hpp>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput of the by-value Hash API against the static-buffer implementation it replaced.
+//
+// usage: indieback_hash_bench [threads] [iterations-per-thread]
+
+namespace
+{
+    // the previous Hash::sha256: strlen on the input, a fresh EVP_MD_CTX per call
+    // through SHA256(), and a function-level static result buffer
+    byte *legacySha256(const byte *text)
+    {
+        static byte hash[SHA256_DIGEST_LENGTH];
+        SHA256(text, strlen((const char *)text), hash);
+        return hash;
+    }
+
+    template <typename Job>
+    void run(const std::string &name, size_t payload, int threads, int iterations, Job job)
+    {
+        std::string input(payload, 'x');
+        std::atomic<std::uint64_t> sink{0};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&]() {
+                std::uint64_t local = 0;
+                for (int i = 0; i < iterations; ++i)
+                    local += job(input);
+                sink += local;
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double calls = static_cast<double>(threads) * iterations;
+        std::cout << name << ": payload=" << payload << " threads=" << threads
+                  << " ops_per_sec=" << static_cast<std::uint64_t>(calls / seconds)
+                  << " mb_per_sec=" << calls * payload / seconds / (1024 * 1024)
+                  << " (checksum " << sink % 251 << ")" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 200000;
+
+    for (size_t payload : {16, 64, 1024, 16384})
+    {
+        // the legacy result is read right away; with several threads it may already be another thread's digest
+        run("legacy", payload, threads, iterations, [](const std::string &input) {
+            return legacySha256(reinterpret_cast<const byte *>(input.c_str()))[0];
+        });
+        run("hash", payload, threads, iterations, [](const std::string &input) {
+            return Hash::sha256(input)[0];
+        });
+        run("stream", payload, threads, iterations, [](const std::string &input) {
+            thread_local Hash::Stream<Hash::Algorithm::SHA256> stream;
+            return stream.update(input).finish()[0];
+        });
+    }
+    return 0;
+}
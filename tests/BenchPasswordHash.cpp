@@ -0,0 +1,100 @@
+#include <backend/auth/PasswordHasher.hpp>
+#include <config.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Picks scrypt costs for PASSWORD_SCRYPT_LN. Each candidate is run as a login burst of
+// `concurrency` clients sharing a pool of `threads` hashing threads, the way
+// PasswordHasher::executor() serves rest_api. Latency includes the time queued behind other logins.
+//
+// usage: indieback_password_bench [p99-budget-ms] [concurrency] [threads] [logins-per-client]
+
+namespace
+{
+    struct Outcome
+    {
+        double p50_ms;
+        double p99_ms;
+        std::uint64_t rejected;
+    };
+
+    Outcome measure(const indiepub::PasswordHasher::Params &params, int concurrency, int threads, int logins)
+    {
+        indiepub::PasswordHasher hasher(params);
+        indiepub::CryptoExecutor pool(threads, concurrency);
+        std::string stored = hasher.hash("Secr3t!Passw0rd");
+
+        std::vector<std::vector<double>> samples(concurrency);
+        std::vector<std::uint64_t> rejected(concurrency, 0);
+        std::vector<std::thread> clients;
+        for (int c = 0; c < concurrency; ++c)
+        {
+            clients.emplace_back([&, c]() {
+                for (int i = 0; i < logins; ++i)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    try
+                    {
+                        bool rehash = false;
+                        pool.run([&]() { return hasher.verify("Secr3t!Passw0rd", stored, rehash); });
+                    }
+                    catch (const indiepub::CryptoOverloaded &)
+                    {
+                        ++rejected[c];
+                        continue;
+                    }
+                    samples[c].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                }
+            });
+        }
+        for (auto &client : clients)
+            client.join();
+
+        std::vector<double> all;
+        std::uint64_t rejections = 0;
+        for (int c = 0; c < concurrency; ++c)
+        {
+            all.insert(all.end(), samples[c].begin(), samples[c].end());
+            rejections += rejected[c];
+        }
+        if (all.empty())
+            return {0, 0, rejections};
+        std::sort(all.begin(), all.end());
+        auto percentile = [&all](double q) { return all[std::min(all.size() - 1, static_cast<size_t>(q * all.size()))]; };
+        return {percentile(0.50), percentile(0.99), rejections};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    double budget = argc > 1 ? std::atof(argv[1]) : 250.0;
+    int concurrency = argc > 2 ? std::atoi(argv[2]) : 16;
+    int threads = argc > 3 ? std::atoi(argv[3]) : PASSWORD_HASH_THREADS;
+    int logins = argc > 4 ? std::atoi(argv[4]) : 8;
+
+    std::cout << "p99 budget " << budget << " ms, " << concurrency << " concurrent logins on "
+              << threads << " hashing threads" << std::endl;
+    indiepub::PasswordHasher::Params chosen{0, 8, 1};
+    for (std::uint32_t log_n = 12; log_n <= 18; ++log_n)
+    {
+        indiepub::PasswordHasher::Params params{log_n, 8, 1};
+        Outcome outcome = measure(params, concurrency, threads, logins);
+        bool fits = outcome.p99_ms <= budget;
+        std::cout << "ln=" << log_n << " r=8 p=1 mem_mb=" << indiepub::PasswordHasher::memory(params) / (1024 * 1024)
+                  << " p50_ms=" << outcome.p50_ms << " p99_ms=" << outcome.p99_ms
+                  << " rejected=" << outcome.rejected << (fits ? "" : "  over budget") << std::endl;
+        if (!fits)
+            break;
+        chosen = params;
+    }
+    if (chosen.log_n == 0)
+        std::cout << "no candidate fits the budget; add hashing threads or shed load earlier" << std::endl;
+    else
+        std::cout << "suggested: PASSWORD_SCRYPT_LN " << chosen.log_n << std::endl;
+    return 0;
+}
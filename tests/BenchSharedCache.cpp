@@ -0,0 +1,151 @@
+#include <backend/cache/EntityCache.hpp>
+#include <backend/cache/SharedCache.hpp>
+#include <backend/models/User.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Compares N rest_api-like processes each holding a private user cache against the same
+// processes sharing one segment. The loader stands in for a Cassandra read.
+//
+// usage: indieback_shared_cache_bench [processes] [keys] [lookups-per-process]
+
+namespace
+{
+    struct Result
+    {
+        std::uint64_t lookups;
+        std::uint64_t loads;
+        long rss_kb;
+        long pss_kb;
+    };
+
+    long readKb(const std::string &path, const std::string &field)
+    {
+        std::ifstream in(path);
+        std::string name;
+        long value = 0;
+        while (in >> name)
+        {
+            if (name == field)
+            {
+                in >> value;
+                return value;
+            }
+        }
+        return -1;
+    }
+
+    long rssKb()
+    {
+        std::ifstream in("/proc/self/statm");
+        long size = 0, resident = 0;
+        in >> size >> resident;
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    indiepub::User makeUser(const std::string &id)
+    {
+        indiepub::User user(id, id + "@indie.com", "fan", "user " + id, 1700000000);
+        user.bio(std::string(200, 'b'));
+        return user;
+    }
+
+    Result runWorker(indiepub::SharedCache *shared, size_t localCapacity, int keys, int lookups, unsigned seed)
+    {
+        indiepub::EntityCache<indiepub::User> users(indiepub::EntityType::USER, localCapacity, std::chrono::seconds(300));
+        if (shared != nullptr)
+            users.attachShared(shared);
+
+        // skewed access: most traffic goes to a small set of popular users
+        std::mt19937 rng(seed);
+        std::geometric_distribution<int> popular(8.0 / keys);
+        std::uint64_t loads = 0;
+        for (int i = 0; i < lookups; ++i)
+        {
+            std::string id = std::to_string(popular(rng) % keys);
+            users.getOrLoad(id, [&loads, &id]() -> std::optional<indiepub::User> {
+                ++loads;
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                return makeUser(id);
+            });
+        }
+        return {static_cast<std::uint64_t>(lookups), loads, rssKb(), readKb("/proc/self/smaps_rollup", "Pss:")};
+    }
+
+    void runMode(const std::string &mode, int processes, int keys, int lookups)
+    {
+        std::string name = "/indieback-bench-" + std::to_string(getpid());
+        std::unique_ptr<indiepub::SharedCache> shared;
+        size_t localCapacity = keys;
+        if (mode == "shared")
+        {
+            indiepub::SharedCache::remove(name);
+            shared = indiepub::SharedCache::open(name, static_cast<std::uint32_t>(keys * 2), 512);
+            if (!shared)
+            {
+                std::cerr << "Could not open shared segment" << std::endl;
+                return;
+            }
+            // the process-local tier only holds the hottest entries
+            localCapacity = keys / 16;
+        }
+
+        auto *results = static_cast<Result *>(mmap(nullptr, sizeof(Result) * processes, PROT_READ | PROT_WRITE,
+                                                   MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+        auto start = std::chrono::steady_clock::now();
+        for (int p = 0; p < processes; ++p)
+        {
+            if (fork() == 0)
+            {
+                results[p] = runWorker(shared.get(), localCapacity, keys, lookups, 1234 + p);
+                _exit(0);
+            }
+        }
+        for (int p = 0; p < processes; ++p)
+            wait(nullptr);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Result total{0, 0, 0, 0};
+        for (int p = 0; p < processes; ++p)
+        {
+            total.lookups += results[p].lookups;
+            total.loads += results[p].loads;
+            total.rss_kb += results[p].rss_kb;
+            total.pss_kb += results[p].pss_kb;
+        }
+        std::cout << mode << ": processes=" << processes
+                  << " hit_rate=" << 1.0 - static_cast<double>(total.loads) / total.lookups
+                  << " backend_loads=" << total.loads
+                  << " rss_kb=" << total.rss_kb
+                  << " pss_kb=" << total.pss_kb
+                  << " seconds=" << seconds << std::endl;
+        if (shared)
+        {
+            auto stats = shared->stats();
+            std::cout << "  segment: used=" << stats.used << "/" << stats.slots << " hits=" << stats.hits
+                      << " misses=" << stats.misses << " evictions=" << stats.evictions << std::endl;
+            indiepub::SharedCache::remove(name);
+        }
+        munmap(results, sizeof(Result) * processes);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int processes = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    int keys = argc > 2 ? std::atoi(argv[2]) : 20000;
+    int lookups = argc > 3 ? std::atoi(argv[3]) : 200000;
+
+    runMode("private", processes, keys, lookups);
+    runMode("shared", processes, keys, lookups);
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <backend/CassandraConnection.hpp>
+#include <backend/Environment.hpp>
 #include <backend/IndieBackModels.hpp>
 #include <backend/models/BandMember.hpp>
 #include <backend/models/Band.hpp>
@@ -18,6 +19,28 @@
 #include <backend/controllers/EventController.hpp>
 #include <backend/controllers/UsersController.hpp>
 #include <backend/controllers/DailyTicketSalesController.hpp>
+#include <backend/cache/InvalidationBus.hpp>
+#include <backend/cache/EntityCache.hpp>
+#include <backend/cache/InvalidationChannel.hpp>
+#include <backend/cache/EntityCodec.hpp>
+#include <backend/cache/SharedCache.hpp>
+#include <backend/cache/CacheSnapshot.hpp>
+#include <backend/cache/Caches.hpp>
+#include <backend/cache/CacheBudget.hpp>
+#include <backend/models/Credentials.hpp>
+#include <backend/auth/CryptoExecutor.hpp>
+#include <backend/auth/PasswordHasher.hpp>
+#include <backend/auth/SessionKeys.hpp>
+#include <backend/auth/SessionToken.hpp>
+#include <backend/api/Admission.hpp>
+#include <backend/api/Compression.hpp>
+#include <backend/api/HttpListeners.hpp>
+#include <backend/api/Lifecycle.hpp>
+#include <backend/api/RateLimiter.hpp>
+#include <backend/api/Router.hpp>
+#include <backend/async/Async.hpp>
+#include <backend/async/Task.hpp>
+#include <http/Status.hpp>
 #include <string>
 #include <iostream>
 #include <stdexcept>
@@ -27,6 +50,21 @@
 #include <util/UUID.hpp>
 #include <cassert>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <filesystem>
+#include <cstring>
+#include <fstream>
+#include <atomic>
+#include <optional>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
 
 std::string contact_points = "172.18.0.2";
 std::string username = "cassandra";
@@ -654,6 +692,1182 @@ void testControllers()
     testDailyTicketSalesControllers();
 }
 
+void testInvalidationBus()
+{
+    std::vector<indiepub::ChangeEvent> received;
+    size_t id = indiepub::InvalidationBus::instance().subscribe(indiepub::EntityType::USER, [&received](const indiepub::ChangeEvent &event) {
+        received.push_back(event);
+    });
+    std::uint64_t version = indiepub::InvalidationBus::instance().publish(indiepub::EntityType::USER, "user-1");
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::VENUE, "venue-1");
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::ANY, "");
+    indiepub::InvalidationBus::instance().unsubscribe(id);
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::USER, "user-2");
+
+    assert(received.size() == 2);
+    assert(received[0].key == "user-1" && received[0].version == version);
+    assert(received[1].entity == indiepub::EntityType::ANY && received[1].key.empty());
+    assert(indiepub::InvalidationBus::instance().version() > version);
+}
+
+void testEntityCache()
+{
+    indiepub::EntityCache<indiepub::User> users(indiepub::EntityType::USER, 2, std::chrono::seconds(60));
+    indiepub::User a("a", "a@indie.com", "fan", "A", std::time(nullptr));
+    indiepub::User b("b", "b@indie.com", "fan", "B", std::time(nullptr));
+    indiepub::User c("c", "c@indie.com", "fan", "C", std::time(nullptr));
+    users.put("a", a);
+    users.put("b", b);
+    assert(users.get("a").has_value());
+    users.put("c", c); // evicts the least recently used entry
+    assert(!users.get("b").has_value());
+    assert(users.size() == 2);
+
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::USER, "a");
+    assert(!users.get("a").has_value());
+    assert(users.get("c").has_value());
+
+    int loads = 0;
+    auto loader = [&loads, &b]() -> std::optional<indiepub::User> { ++loads; return b; };
+    users.getOrLoad("b", loader);
+    users.getOrLoad("b", loader);
+    assert(loads == 1);
+
+    // a write that lands while a load is in flight must not leave the stale value behind
+    auto racingLoader = [&a]() -> std::optional<indiepub::User> {
+        indiepub::InvalidationBus::instance().publish(indiepub::EntityType::USER, "a");
+        return a;
+    };
+    assert(users.getOrLoad("a", racingLoader).has_value());
+    assert(!users.get("a").has_value());
+
+    indiepub::EntityCache<indiepub::Credentials> auth(
+        indiepub::EntityType::CREDENTIALS, 8, std::chrono::seconds(60),
+        [](const indiepub::Credentials &creds, const std::string &user_id) { return creds.user_id() == user_id; });
+    auth.put("token-a", indiepub::Credentials("a", "token-a", "hash"));
+    auth.put("token-b", indiepub::Credentials("b", "token-b", "hash"));
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::CREDENTIALS, "a");
+    assert(!auth.get("token-a").has_value());
+    assert(auth.get("token-b").has_value());
+
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::ANY, "");
+    assert(auth.size() == 0 && users.size() == 0);
+}
+
+sockaddr_un unixAddress(const std::string &path)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+void testInvalidationChannel()
+{
+    std::string dir = "/tmp/indieback-test-" + std::to_string(getpid());
+    indiepub::InvalidationChannel::Options options{
+        indiepub::InvalidationChannel::Transport::UNIX, dir, "", 0, std::chrono::milliseconds(50)};
+    indiepub::InvalidationChannel channel(options);
+    assert(channel.start());
+
+    std::mutex mutex;
+    std::vector<indiepub::ChangeEvent> received;
+    size_t id = indiepub::InvalidationBus::instance().subscribe(indiepub::EntityType::ANY, [&](const indiepub::ChangeEvent &event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(event);
+    });
+    auto waitFor = [&](size_t count) {
+        for (int i = 0; i < 200; ++i)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (received.size() >= count)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+
+    // a fake peer process talking to the channel's socket
+    std::string peerPath = dir + "/peer.sock";
+    int peer = socket(AF_UNIX, SOCK_DGRAM, 0);
+    sockaddr_un peerAddr = unixAddress(peerPath);
+    unlink(peerPath.c_str());
+    assert(bind(peer, reinterpret_cast<sockaddr *>(&peerAddr), sizeof(peerAddr)) == 0);
+    sockaddr_un channelAddr = unixAddress(dir + "/" + std::to_string(getpid()) + ".sock");
+    auto sendFromPeer = [&](std::uint64_t sequence, const std::string &key) {
+        indiepub::InvalidationChannel::Message message{
+            indiepub::InvalidationChannel::Kind::INVALIDATE, 42, sequence, {indiepub::EntityType::USER, key, sequence}};
+        std::string datagram = indiepub::InvalidationChannel::encode(message);
+        sendto(peer, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr *>(&channelAddr), sizeof(channelAddr));
+    };
+
+    sendFromPeer(1, "remote-user");
+    assert(waitFor(1));
+    sendFromPeer(3, "lost-one-before-me");
+    assert(waitFor(2));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(received[0].entity == indiepub::EntityType::USER && received[0].key == "remote-user");
+        assert(received[1].entity == indiepub::EntityType::ANY && received[1].key.empty());
+    }
+    assert(channel.stats().gaps == 1);
+
+    // local writes go out to every peer socket in the directory
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::VENUE, "local-venue");
+    bool forwarded = false;
+    char buffer[2048];
+    for (int i = 0; i < 20 && !forwarded; ++i)
+    {
+        ssize_t length = recv(peer, buffer, sizeof(buffer), 0);
+        indiepub::InvalidationChannel::Message message;
+        if (length > 0 && indiepub::InvalidationChannel::decode(buffer, length, message) &&
+            message.kind == indiepub::InvalidationChannel::Kind::INVALIDATE)
+        {
+            forwarded = message.sender == channel.senderId() && message.event.key == "local-venue";
+        }
+    }
+    assert(forwarded);
+
+    // concurrent writers and the heartbeat: numbers arrive in order, heartbeats never ahead
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 4; ++w)
+    {
+        writers.emplace_back([w]() {
+            for (int i = 0; i < 50; ++i)
+                indiepub::InvalidationBus::instance().publish(indiepub::EntityType::EVENT, std::to_string(w * 100 + i));
+        });
+    }
+    std::uint64_t last = 0;
+    bool ordered = true;
+    timeval wait{0, 100000};
+    setsockopt(peer, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+    // datagrams the peer could not take in time are dropped, which only leaves gaps
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < until)
+    {
+        ssize_t length = recv(peer, buffer, sizeof(buffer), 0);
+        indiepub::InvalidationChannel::Message message;
+        if (length <= 0 || !indiepub::InvalidationChannel::decode(buffer, length, message) || message.sender != channel.senderId())
+            continue;
+        if (message.kind == indiepub::InvalidationChannel::Kind::INVALIDATE)
+            ordered = ordered && message.sequence > last;
+        else
+            ordered = ordered && message.sequence >= last;
+        last = std::max(last, message.sequence);
+    }
+    for (auto &writer : writers)
+        writer.join();
+    assert(ordered && last > 0);
+
+    indiepub::InvalidationBus::instance().unsubscribe(id);
+    channel.stop();
+    close(peer);
+    std::filesystem::remove_all(dir);
+}
+
+void testEntityCodec()
+{
+    indiepub::User user("u", "u@indie.com", "band", "U", 1700000000);
+    user.bio("bio");
+    user.social_links({"https://a", "https://b"});
+    std::string bytes;
+    indiepub::EntityCodec::encode(user, bytes);
+    indiepub::User decodedUser;
+    assert(indiepub::EntityCodec::decode(bytes, decodedUser));
+    assert(decodedUser.user_id() == "u" && decodedUser.bio() == "bio" && decodedUser.social_links().size() == 2);
+    assert(!indiepub::EntityCodec::decode(std::string_view(bytes).substr(0, bytes.size() - 1), decodedUser));
+
+    std::vector<indiepub::EventByVenue> events{
+        indiepub::EventByVenue("e1", "v", "b", "c", "Gig", 1700000000, 12.5, 100, 3),
+        indiepub::EventByVenue("e2", "v", "b", "c", "Encore", 1700003600, 15.0, 50, 0)};
+    bytes.clear();
+    indiepub::EntityCodec::encode(events, bytes);
+    std::vector<indiepub::EventByVenue> decodedEvents;
+    assert(indiepub::EntityCodec::decode(bytes, decodedEvents));
+    assert(decodedEvents.size() == 2 && decodedEvents[1].name() == "Encore" && decodedEvents[0].price() == 12.5);
+}
+
+void testSharedCache()
+{
+    std::string name = "/indieback-test-" + std::to_string(getpid());
+    indiepub::SharedCache::remove(name);
+    auto shared = indiepub::SharedCache::open(name, 64, 256);
+    assert(shared);
+    assert(!indiepub::SharedCache::open(name, 128, 256)); // geometry mismatch is refused
+
+    std::string value;
+    assert(shared->put(indiepub::EntityType::USER, "a", "alpha", std::chrono::seconds(60), "a", shared->generation(indiepub::EntityType::USER)));
+    assert(shared->get(indiepub::EntityType::USER, "a", value) && value == "alpha");
+    assert(!shared->get(indiepub::EntityType::VENUE, "a", value));
+    assert(!shared->put(indiepub::EntityType::USER, "big", std::string(257, 'x'), std::chrono::seconds(60), "", shared->generation(indiepub::EntityType::USER)));
+    shared->put(indiepub::EntityType::USER, "short", "lived", std::chrono::milliseconds(0), "short", shared->generation(indiepub::EntityType::USER));
+    assert(!shared->get(indiepub::EntityType::USER, "short", value));
+
+    // a second process sees the first one's writes and its own writes are seen back
+    pid_t child = fork();
+    if (child == 0)
+    {
+        auto attached = indiepub::SharedCache::open(name, 64, 256);
+        std::string seen;
+        bool ok = attached && attached->get(indiepub::EntityType::USER, "a", seen) && seen == "alpha";
+        ok = ok && attached->put(indiepub::EntityType::USER, "from-child", "hello", std::chrono::seconds(60), "from-child", attached->generation(indiepub::EntityType::USER));
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(shared->get(indiepub::EntityType::USER, "from-child", value) && value == "hello");
+
+    shared->put(indiepub::EntityType::CREDENTIALS, "token-a", "creds", std::chrono::seconds(60), "a", shared->generation(indiepub::EntityType::CREDENTIALS));
+    shared->put(indiepub::EntityType::CREDENTIALS, "token-b", "creds", std::chrono::seconds(60), "b", shared->generation(indiepub::EntityType::CREDENTIALS));
+    shared->put(indiepub::EntityType::CREDENTIALS, "all-tokens", "creds", std::chrono::seconds(60), "", shared->generation(indiepub::EntityType::CREDENTIALS));
+    shared->eraseOwnedBy(indiepub::EntityType::CREDENTIALS, "a");
+    assert(!shared->get(indiepub::EntityType::CREDENTIALS, "token-a", value));
+    assert(shared->get(indiepub::EntityType::CREDENTIALS, "token-b", value));
+    assert(!shared->get(indiepub::EntityType::CREDENTIALS, "all-tokens", value));
+    // written after the owner changed, the entry is current again and takes the old slot
+    std::uint32_t used = shared->stats().used;
+    shared->put(indiepub::EntityType::CREDENTIALS, "token-a", "fresh", std::chrono::seconds(60), "a", shared->generation(indiepub::EntityType::CREDENTIALS));
+    assert(shared->get(indiepub::EntityType::CREDENTIALS, "token-a", value) && value == "fresh");
+    assert(shared->stats().used == used);
+
+    // a value loaded before an invalidation is not written after it
+    std::uint32_t before = shared->generation(indiepub::EntityType::CREDENTIALS);
+    shared->eraseOwnedBy(indiepub::EntityType::CREDENTIALS, "b");
+    assert(!shared->put(indiepub::EntityType::CREDENTIALS, "token-b", "stale", std::chrono::seconds(60), "b", before));
+    assert(!shared->get(indiepub::EntityType::CREDENTIALS, "token-b", value));
+    before = shared->generation(indiepub::EntityType::USER);
+    shared->erase(indiepub::EntityType::USER, "a");
+    assert(!shared->put(indiepub::EntityType::USER, "a", "stale", std::chrono::seconds(60), "a", before));
+
+    // an EntityCache backed by the segment fills from it and drops it on invalidation
+    indiepub::EntityCache<indiepub::User> writer(indiepub::EntityType::USER, 8, std::chrono::seconds(60));
+    indiepub::EntityCache<indiepub::User> reader(indiepub::EntityType::USER, 8, std::chrono::seconds(60));
+    writer.attachShared(shared.get());
+    reader.attachShared(shared.get());
+    writer.put("u", indiepub::User("u", "u@indie.com", "fan", "U", 1700000000));
+    auto warm = reader.get("u");
+    assert(warm.has_value() && warm->email() == "u@indie.com");
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::USER, "u");
+    assert(!shared->get(indiepub::EntityType::USER, "u", value));
+    // nor does a load the invalidation overtakes reach the segment
+    writer.getOrLoad("u", []() -> std::optional<indiepub::User> {
+        indiepub::InvalidationBus::instance().publish(indiepub::EntityType::USER, "u");
+        return indiepub::User("u", "old@indie.com", "fan", "U", 1700000000);
+    });
+    assert(!shared->get(indiepub::EntityType::USER, "u", value));
+
+    shared->clear(indiepub::EntityType::ANY);
+    assert(shared->stats().used == 0);
+    indiepub::SharedCache::remove(name);
+}
+
+void testCacheSnapshot()
+{
+    std::string path = "/tmp/indieback-test-" + std::to_string(getpid()) + ".snap";
+    indiepub::CacheSnapshot::Section venues{indiepub::EntityType::VENUE, {{"v1", "one"}, {"v2", "two"}}};
+    indiepub::CacheSnapshot::Section auth{indiepub::EntityType::CREDENTIALS, {{"token", "creds"}}};
+    assert(indiepub::CacheSnapshot::write(path, {venues, auth}));
+
+    auto snapshot = indiepub::CacheSnapshot::open(path, std::chrono::seconds(60));
+    assert(snapshot);
+    std::vector<std::string> seen;
+    assert(snapshot->forEach(indiepub::EntityType::VENUE, [&](std::string_view key, std::string_view value) {
+        seen.push_back(std::string(key) + "=" + std::string(value));
+    }) == 2);
+    assert(seen[0] == "v1=one" && seen[1] == "v2=two");
+    assert(snapshot->forEach(indiepub::EntityType::EVENT, [](std::string_view, std::string_view) {}) == 0);
+    snapshot.reset();
+
+    auto patch = [&path](std::streamoff offset, const void *data, size_t length) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offset);
+        file.write(static_cast<const char *>(data), static_cast<std::streamsize>(length));
+    };
+    // created_at lives at offset 8; an old snapshot is refused
+    std::int64_t old = std::time(nullptr) - 3600;
+    patch(8, &old, sizeof(old));
+    assert(!indiepub::CacheSnapshot::open(path, std::chrono::seconds(60)));
+    assert(indiepub::CacheSnapshot::open(path, std::chrono::seconds(7200)));
+    // a flipped body byte fails the checksum
+    char flipped = 'X';
+    patch(32 + 10, &flipped, 1);
+    assert(!indiepub::CacheSnapshot::open(path, std::chrono::seconds(7200)));
+
+    // caches round trip through a snapshot and restored entries can be revalidated away
+    indiepub::Caches::venues().put("venue-1", indiepub::Venue("venue-1", "owner", "Club", "Town", 200, 1700000000));
+    indiepub::Caches::auth().put("token-1", indiepub::Credentials("user-1", "token-1", "hash"));
+    assert(indiepub::Caches::saveSnapshot(path));
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::ANY, "");
+    assert(!indiepub::Caches::venues().get("venue-1").has_value());
+    auto restored = indiepub::Caches::loadSnapshot(path, std::chrono::seconds(60));
+    assert(restored.venues.size() == 1 && restored.auth.size() == 1);
+    assert(indiepub::Caches::venues().get("venue-1")->name() == "Club");
+    indiepub::Caches::auth().refresh("token-1", []() -> std::optional<indiepub::Credentials> { return std::nullopt; });
+    assert(!indiepub::Caches::auth().get("token-1").has_value());
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::ANY, "");
+    std::remove(path.c_str());
+}
+
+void testCacheBudget()
+{
+    indiepub::CacheBudget budget(100 * 1024);
+    indiepub::EntityCache<indiepub::User> profiles(indiepub::EntityType::USER, 1000, std::chrono::seconds(60));
+    indiepub::EntityCache<indiepub::Credentials> tokens(indiepub::EntityType::CREDENTIALS, 1000, std::chrono::seconds(60));
+    profiles.enroll(budget, "profiles", 1);
+    tokens.enroll(budget, "tokens", 1);
+    assert(profiles.account()->limit == 50 * 1024 && tokens.account()->limit == 50 * 1024);
+
+    // long bios make a few entries expensive: the byte limit bites long before the entry count
+    for (int i = 0; i < 40; ++i)
+    {
+        indiepub::User user(std::to_string(i), "u@indie.com", "band", "U", 1700000000);
+        user.bio(std::string(2048, 'b'));
+        profiles.put(std::to_string(i), user);
+    }
+    assert(profiles.bytes() <= 50 * 1024 && profiles.size() < 40);
+    assert(profiles.account()->evictions > 0);
+    tokens.put("token", indiepub::Credentials("user", "token", "hash"));
+    assert(tokens.bytes() < 1024);
+
+    for (int i = 0; i < 100; ++i)
+        profiles.get("39");
+    tokens.get("missing");
+    // memory moves from the idle cache to the busy, evicting one
+    assert(budget.rebalance());
+    assert(profiles.account()->limit > 50 * 1024 && tokens.account()->limit < 50 * 1024);
+    // no new hits since the last window: nothing to gain from moving more
+    assert(!budget.rebalance());
+
+    std::string exposition = budget.exposition();
+    assert(exposition.find("indieback_cache_bytes{cache=\"profiles\"}") != std::string::npos);
+    assert(exposition.find("indieback_cache_misses_total{cache=\"tokens\"} 1") != std::string::npos);
+
+    profiles.clear();
+    assert(profiles.bytes() == 0 && profiles.account()->bytes == 0);
+}
+
+void testSessionToken()
+{
+    std::vector<unsigned char> key(32, 0x2a);
+    indiepub::SessionToken tokens(key, std::chrono::seconds(3600));
+    std::string token = tokens.issue("user-1", 1700000000);
+    assert(indiepub::SessionToken::isSessionToken(token));
+    assert(!indiepub::SessionToken::isSessionToken("2b7e151628aed2a6abf7158809cf4f3c"));
+
+    indiepub::SessionToken::Claims claims;
+    assert(tokens.verify(token, claims, 1700000001));
+    assert(claims.user_id == "user-1" && claims.expires_at == 1700003600 && claims.key_id == tokens.keyId());
+    assert(!tokens.verify(token, claims, 1700003600));
+
+    // any change to the signed part or to the MAC is rejected
+    std::string forged = token;
+    forged.replace(3, 6, "user-2");
+    assert(!tokens.verify(forged, claims, 1700000001));
+    std::string tampered = token;
+    tampered.back() = tampered.back() == '0' ? '1' : '0';
+    assert(!tokens.verify(tampered, claims, 1700000001));
+
+    indiepub::SessionToken other(std::vector<unsigned char>(32, 0x17), std::chrono::seconds(3600));
+    assert(!other.verify(token, claims, 1700000001));
+
+    std::string live = tokens.issue("user-1");
+    assert(tokens.verify(live, claims));
+    tokens.revoke(claims.token_id, claims.expires_at);
+    assert(!tokens.verify(live, claims));
+
+    // a logout outlives a restart: the next process loads it from the revocation file
+    std::string revokedPath = "/tmp/indieback-test-session-" + std::to_string(getpid()) + ".revoked";
+    unlink(revokedPath.c_str());
+    assert(tokens.persistRevocations(revokedPath) == 0);
+    std::string loggedOut = tokens.issue("user-4");
+    assert(tokens.verify(loggedOut, claims));
+    tokens.logout(claims);
+    assert(!tokens.verify(loggedOut, claims));
+    std::ofstream(revokedPath, std::ios::app) << "long-expired 1700000000\n";
+    indiepub::SessionToken restarted(key, std::chrono::seconds(3600));
+    assert(restarted.verify(loggedOut, claims));
+    assert(restarted.persistRevocations(revokedPath) == 1);
+    assert(!restarted.verify(loggedOut, claims));
+    std::ifstream compacted(revokedPath);
+    std::string line;
+    assert(std::getline(compacted, line) && line == claims.token_id + " " + std::to_string(claims.expires_at));
+    assert(!std::getline(compacted, line));
+    unlink(revokedPath.c_str());
+
+    // logouts published on the bus reach the process-wide instance
+    std::string path = "/tmp/indieback-test-session-" + std::to_string(getpid()) + ".key";
+    setenv("INDIEBACK_SESSION_KEY_FILE", path.c_str(), 1);
+    setenv("INDIEBACK_SESSION_REVOKED_FILE", revokedPath.c_str(), 1);
+    indiepub::SessionToken &shared = indiepub::SessionToken::instance();
+    std::string session = shared.issue("user-3");
+    assert(shared.verify(session, claims));
+    indiepub::InvalidationBus::instance().publish(indiepub::EntityType::SESSION,
+                                                  claims.token_id + ":" + std::to_string(claims.expires_at));
+    assert(!shared.verify(session, claims));
+    assert(indiepub::SessionToken::loadOrCreateKey(path).size() == 32);
+    assert(indiepub::SessionToken::loadKey(path) == indiepub::SessionToken::loadOrCreateKey(path));
+    bool missing = false;
+    try
+    {
+        indiepub::SessionToken::loadKey(path + ".missing");
+    }
+    catch (const std::runtime_error &)
+    {
+        missing = true;
+    }
+    assert(missing && !std::filesystem::exists(path + ".missing"));
+
+    // a retired key keeps its tokens valid, new tokens carry the new key id
+    std::vector<unsigned char> next(32, 0x5c);
+    std::string retiredPath = path + ".1";
+    std::ofstream(retiredPath, std::ios::binary).write(reinterpret_cast<const char *>(key.data()), key.size());
+    auto retired = indiepub::SessionToken::loadRetiredKeys(path);
+    assert(retired.size() == 1 && retired[0] == key);
+    tokens.rotate(next, retired);
+    assert(tokens.keyId() == indiepub::SessionToken::keyId(next));
+    assert(tokens.verify(token, claims, 1700000001) && claims.key_id == indiepub::SessionToken::keyId(key));
+    assert(tokens.verify(tokens.issue("user-1", 1700000000), claims, 1700000001) && claims.key_id == tokens.keyId());
+    tokens.rotate(next, {});
+    assert(!tokens.verify(token, claims, 1700000001));
+    unlink(retiredPath.c_str());
+    unlink(path.c_str());
+    unlink(revokedPath.c_str());
+}
+
+void testSessionKeys()
+{
+    indiepub::SessionKeys keys(std::vector<unsigned char>(32, 0x2a), std::chrono::seconds(3600));
+    std::string key(SessionCipher::KEY_SIZE, 'k');
+    std::time_t expiresAt = 0;
+    std::string sessionId = keys.establish(key, expiresAt, 1700000000);
+    assert(!sessionId.empty() && expiresAt == 1700003600);
+    assert(keys.establish("short", expiresAt).empty());
+
+    // the key comes back out of the id alone
+    std::optional<SessionCipher> cipher = keys.find(sessionId, 1700000001);
+    assert(cipher);
+    std::string sealed = SessionCipher(reinterpret_cast<const byte *>(key.data()), key.size()).seal("{\"name\": \"x\"}", sessionId);
+    std::string opened;
+    assert(cipher->open(sealed, opened, sessionId) && opened == "{\"name\": \"x\"}");
+
+    assert(!keys.find(sessionId, 1700003600));
+    std::string forged = sessionId;
+    forged[forged.size() - 1] = forged.back() == '0' ? '1' : '0';
+    assert(!keys.find(forged, 1700000001));
+    assert(!keys.find("zz" + sessionId.substr(2), 1700000001));
+    indiepub::SessionKeys other(std::vector<unsigned char>(32, 0x17), std::chrono::seconds(3600));
+    assert(!other.find(sessionId, 1700000001));
+
+    // ids sealed before a rotation open until the old secret is dropped
+    keys.rotate(std::vector<unsigned char>(32, 0x5c), {std::vector<unsigned char>(32, 0x2a)});
+    assert(keys.find(sessionId, 1700000001));
+    std::string rotated = keys.establish(key, expiresAt, 1700000000);
+    assert(!rotated.empty());
+    keys.rotate(std::vector<unsigned char>(32, 0x5c), {});
+    assert(!keys.find(sessionId, 1700000001) && keys.find(rotated, 1700000001));
+}
+
+void testCryptoExecutor()
+{
+    indiepub::CryptoExecutor executor(2, 4);
+    assert(executor.run([]() { return 6 * 7; }) == 42);
+
+    // fields of one request run side by side
+    std::vector<std::function<std::thread::id()>> jobs(2, []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::this_thread::get_id();
+    });
+    auto futures = executor.submitAll(std::move(jobs));
+    assert(futures[0].get() != futures[1].get());
+
+    // errors reach the caller
+    bool thrown = false;
+    try
+    {
+        executor.run([]() -> int { throw std::runtime_error("decrypt failed"); });
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // a full queue rejects the whole batch instead of queueing part of it
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::vector<std::function<void()>> blockers(2, [gate]() { gate.wait(); });
+    auto blocked = executor.submitAll(std::move(blockers));
+    while (executor.depth() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::vector<std::function<void()>> batch(5, []() {});
+    bool overloaded = false;
+    try
+    {
+        executor.submitAll(std::move(batch));
+    }
+    catch (const indiepub::CryptoOverloaded &)
+    {
+        overloaded = true;
+    }
+    assert(overloaded && executor.depth() == 0);
+    release.set_value();
+    for (auto &future : blocked)
+        future.get();
+
+    std::string exposition = executor.exposition();
+    assert(exposition.find("indieback_crypto_rejected_total 5") != std::string::npos);
+    assert(exposition.find("indieback_crypto_job_seconds_bucket{le=\"+Inf\"}") != std::string::npos);
+}
+
+void testPasswordHasher()
+{
+    // cheap costs keep the test fast; production uses PASSWORD_SCRYPT_LN
+    indiepub::PasswordHasher hasher({10, 8, 1});
+    std::string stored = hasher.hash("Secr3t!Passw0rd");
+    assert(stored.rfind("$scrypt$ln=10,r=8,p=1$", 0) == 0);
+    // salted: the same password never hashes the same twice
+    assert(hasher.hash("Secr3t!Passw0rd") != stored);
+
+    bool rehash = true;
+    assert(hasher.verify("Secr3t!Passw0rd", stored, rehash) && !rehash);
+    assert(!hasher.verify("Secr3t!Passw0rd ", stored, rehash));
+
+    // raised costs: old hashes still verify and ask to be upgraded
+    indiepub::PasswordHasher stronger({11, 8, 1});
+    assert(stronger.verify("Secr3t!Passw0rd", stored, rehash) && rehash);
+
+    // rows from before the KDF hold the truncated SHA-256 hex
+    std::string legacy = indiepub::PasswordHasher::legacyHash("Secr3t!Passw0rd");
+    assert(legacy.size() == 2 * std::string("Secr3t!Passw0rd").size());
+    assert(hasher.verify("Secr3t!Passw0rd", legacy, rehash) && rehash);
+    assert(!hasher.verify("wrong", legacy, rehash));
+    assert(!hasher.verify("", "", rehash));
+
+    assert(!hasher.verify("Secr3t!Passw0rd", "$scrypt$ln=40,r=8,p=1$AAAA$AAAA", rehash));
+    assert(!hasher.verify("Secr3t!Passw0rd", stored.substr(0, stored.size() - 4), rehash));
+    assert(indiepub::PasswordHasher::memory({15, 8, 1}) == 32 * 1024 * 1024);
+}
+
+// true when a second TCP socket can bind the port of the first
+bool bindsTwice()
+{
+    int first = socket(AF_INET, SOCK_STREAM, 0);
+    int second = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bool shared = bind(first, reinterpret_cast<sockaddr *>(&address), length) == 0 &&
+                  getsockname(first, reinterpret_cast<sockaddr *>(&address), &length) == 0 &&
+                  listen(first, 1) == 0 &&
+                  bind(second, reinterpret_cast<sockaddr *>(&address), length) == 0;
+    close(first);
+    close(second);
+    return shared;
+}
+
+void testHttpListeners()
+{
+    setenv("INDIEBACK_HTTP_HOST", "0.0.0.0", 1);
+    setenv("INDIEBACK_HTTP_PORT", "9090", 1);
+    setenv("INDIEBACK_HTTP_WORKERS", "8", 1);
+    setenv("INDIEBACK_HTTP_LISTENERS", "4", 1);
+    indiepub::HttpListeners::Options options = indiepub::HttpListeners::Options::fromEnvironment();
+    assert(options.host == "0.0.0.0" && options.port == "9090" && options.backlog == HTTP_BACKLOG);
+    assert(options.workers == 8 && options.listeners == 4 && !options.pin_cpus);
+    for (const char *name : {"INDIEBACK_HTTP_HOST", "INDIEBACK_HTTP_PORT", "INDIEBACK_HTTP_WORKERS",
+                             "INDIEBACK_HTTP_LISTENERS"})
+        unsetenv(name);
+
+    // listeners take every n-th CPU; with more listeners than CPUs they share
+    std::vector<int> cpus = {0, 1, 2, 3};
+    assert((indiepub::HttpListeners::cpusFor(0, 2, cpus) == std::vector<int>{0, 2}));
+    assert((indiepub::HttpListeners::cpusFor(1, 2, cpus) == std::vector<int>{1, 3}));
+    assert((indiepub::HttpListeners::cpusFor(5, 8, cpus) == std::vector<int>{1}));
+    assert(!indiepub::HttpListeners::availableCpus().empty());
+
+    // several listeners need a port HttpServer can share, so one is run
+    options.listeners = 3;
+    indiepub::HttpListeners single(options);
+    assert(single.options().listeners == 1);
+    // the router finds the captures of the route HttpServer matched
+    auto ignore = [](const indiepub::RequestContext &, HttpResponse &) {};
+    single.setHttpHandler(HttpMethod::GET, "/venues/{venue_id}/events", ignore);
+    single.setHttpHandler(HttpMethod::POST, "/events", ignore);
+    single.setHttpHandler(HttpMethod::GET, "/events/{event_id}", ignore);
+    assert(single.router().match(HttpMethod::GET, "/venues/abc/events").params.get("venue_id") == "abc");
+
+    options.listeners = 0;
+    indiepub::HttpListeners perCpu(options);
+    assert(perCpu.options().listeners == 1);
+    // nothing turns on port reuse for the other sockets of the process
+    assert(!bindsTwice());
+}
+
+void testAsync()
+{
+    indiepub::Promise<int> promise;
+    indiepub::Async<int> value = promise.async();
+    int seen = 0;
+    value.onComplete([&seen](const indiepub::Async<int> &done) { seen = done.get(); });
+    indiepub::Async<std::string> text = value.then([](int n) { return std::to_string(n * 2); });
+    assert(!value.ready() && !text.ready() && seen == 0);
+
+    std::thread producer([promise]() mutable { promise.set(21); });
+    producer.join();
+    assert(value.ready() && seen == 21 && text.get() == "42");
+    assert(!promise.set(7) && value.get() == 21 && "Completes once");
+
+    // failures, and exceptions thrown by a stage, reach the end of the chain
+    indiepub::Async<int> failed = indiepub::Async<int>::failure(std::make_exception_ptr(std::runtime_error("down")));
+    indiepub::Async<int> skipped = failed.then([](int n) { return n + 1; });
+    assert(skipped.failed());
+    indiepub::Async<int> thrown = indiepub::Async<int>::value(1).then([](int) -> int { throw std::runtime_error("bad row"); });
+    try
+    {
+        thrown.get();
+        assert(false && "Stage exception is rethrown");
+    }
+    catch (const std::runtime_error &e)
+    {
+        assert(std::string(e.what()) == "bad row");
+    }
+
+    indiepub::Promise<int> never;
+    assert(!never.async().waitFor(std::chrono::milliseconds(1)));
+
+    indiepub::CryptoExecutor executor(2, 8);
+    indiepub::Async<std::thread::id> worker = executor.submit([]() { return std::this_thread::get_id(); });
+    assert(worker.get() != std::this_thread::get_id());
+}
+
+indiepub::Task<int> addLater(indiepub::Async<int> value, int more)
+{
+    int base = co_await value;
+    co_return base + more;
+}
+
+indiepub::Task<std::string> describe(indiepub::Async<int> value)
+{
+    int sum = co_await addLater(value, 1);
+    if (sum < 0)
+        throw std::runtime_error("negative");
+    co_return std::to_string(sum);
+}
+
+void testTask()
+{
+    // nothing runs until start(); the result arrives from the thread that completes the input
+    indiepub::Promise<int> input;
+    indiepub::Async<std::string> text = indiepub::start(describe(input.async()));
+    assert(!text.ready());
+    std::thread producer([input]() mutable { input.set(41); });
+    producer.join();
+    assert(text.get() == "42");
+
+    assert(indiepub::start(describe(indiepub::Async<int>::value(-5))).failed());
+
+    // independent lookups run side by side and are joined in order
+    indiepub::Promise<int> slow;
+    auto joined = indiepub::whenAll(slow.async(), indiepub::Async<std::string>::value(std::string("venue")));
+    assert(!joined.ready());
+    slow.set(7);
+    assert(std::get<0>(joined.get()) == 7 && std::get<1>(joined.get()) == "venue");
+
+    std::vector<indiepub::Async<int>> parts;
+    for (int i = 0; i < 4; ++i)
+        parts.push_back(indiepub::start(addLater(indiepub::Async<int>::value(i), 10)));
+    assert((indiepub::whenAll(parts).get() == std::vector<int>{10, 11, 12, 13}));
+    parts.push_back(indiepub::Async<int>::failure(std::make_exception_ptr(std::runtime_error("timeout"))));
+    assert(indiepub::whenAll(parts).failed());
+
+    indiepub::Promise<void> signal;
+    bool after = false;
+    indiepub::Async<void> waited = indiepub::start([](indiepub::Async<void> ready, bool &flag) -> indiepub::Task<void> {
+        co_await ready;
+        flag = true;
+    }(signal.async(), after));
+    assert(!waited.ready() && !after);
+    signal.set();
+    waited.get();
+    assert(after);
+}
+
+void testAsyncResponse()
+{
+    HttpResponse response;
+    indiepub::AsyncResponse handle;
+    std::thread completer([handle]() mutable {
+        handle.setHeader("content-type", "application/json");
+        handle.complete(CODES::OK, "{}");
+    });
+    assert(handle.deliver(response, std::chrono::milliseconds(5000)));
+    completer.join();
+    assert(!handle.complete(CODES::CREATED, "{}") && "Completes once");
+
+    // nobody completes: 504 after the timeout and the late completion is dropped
+    indiepub::AsyncResponse abandoned;
+    assert(!abandoned.deliver(response, std::chrono::milliseconds(10)));
+    assert(abandoned.completed() && !abandoned.complete(CODES::OK, "{}"));
+
+    // what the request deferred waits for the handler, not for the 504
+    indiepub::HttpListeners::Options options = indiepub::HttpListeners::Options::fromEnvironment();
+    options.async_timeout = std::chrono::milliseconds(10);
+    indiepub::HttpListeners listeners(options);
+    bool released = false;
+    listeners.use([&released](indiepub::RequestContext &context, HttpResponse &) {
+        context.defer([&released]() { released = true; });
+        return true;
+    });
+    std::optional<indiepub::AsyncResponse> running;
+    listeners.setAsyncHandler(HttpMethod::GET, "/", [&running](const indiepub::RequestContext &, indiepub::AsyncResponse pending) {
+        running = pending;
+    });
+    HttpRequest request;
+    listeners.handle(HttpMethod::GET, request, response);
+    assert(running && !released);
+    assert(!running->complete(CODES::OK, "{}") && released);
+
+    setenv("INDIEBACK_HTTP_ASYNC_TIMEOUT", "250", 1);
+    assert(indiepub::HttpListeners::Options::fromEnvironment().async_timeout == std::chrono::milliseconds(250));
+    unsetenv("INDIEBACK_HTTP_ASYNC_TIMEOUT");
+}
+
+void testRouter()
+{
+    indiepub::Router router;
+    std::string ran;
+    auto handler = [&ran](const char *name) {
+        return [&ran, name](const indiepub::RequestContext &, HttpResponse &) { ran = name; };
+    };
+    router.add(HttpMethod::GET, "/events", {}, handler("list"));
+    router.add(HttpMethod::GET, "/events/{event_id}", {.cache_seconds = 60}, handler("event"));
+    router.add(HttpMethod::GET, "/events/upcoming", {}, handler("upcoming"));
+    router.add(HttpMethod::GET, "/venues/{venue_id}/events", {}, handler("venue events"));
+    router.add(HttpMethod::POST, "/events", {.auth_required = true, .route_class = indiepub::RouteClass::WRITE}, handler("create"));
+
+    indiepub::Router::Match match = router.match(HttpMethod::GET, "/events/42?fields=name");
+    assert(match && match.route->pattern == "/events/{event_id}" && match.route->meta.cache_seconds == 60);
+    assert(match.params.size() == 1 && match.params.get("event_id") == "42" && !match.params.has("venue_id"));
+
+    // a literal segment wins over a capture, and the method is part of the route
+    assert(router.match(HttpMethod::GET, "/events/upcoming/").route->pattern == "/events/upcoming");
+    assert(router.match(HttpMethod::POST, "/events").route->meta.auth_required);
+    assert(!router.match(HttpMethod::DELETE, "/events"));
+    assert(!router.match(HttpMethod::GET, "/events/42/tickets") && !router.match(HttpMethod::GET, "/"));
+
+    match = router.match(HttpMethod::GET, "/venues/abc/events");
+    assert(match && match.params.get("venue_id") == "abc");
+    HttpRequest request;
+    HttpResponse response;
+    indiepub::RequestContext context(request, match.params, match.route->meta);
+    match.route->handler(context, response);
+    assert(ran == "venue events" && context.params().get("venue_id") == "abc");
+    assert(context.bearerToken().empty() && context.header("x-user-id").empty() && !context.authenticated());
+
+    for (const char *pattern : {"/events/{event_id}", "/events/{id}/tickets", "/events/{event_id"})
+    {
+        try
+        {
+            router.add(HttpMethod::GET, pattern, {}, handler("bad"));
+            assert(false && "Duplicate, renamed or malformed routes are rejected");
+        }
+        catch (const std::invalid_argument &)
+        {
+        }
+    }
+    assert(router.routes().size() == 5);
+
+    // a path served under other methods lists them for the 405's Allow header
+    assert((router.allowed("/events/") == std::vector<HttpMethod>{HttpMethod::GET, HttpMethod::POST}));
+    assert((router.allowed("/events/42") == std::vector<HttpMethod>{HttpMethod::GET}));
+    assert(router.allowed("/events/42/tickets").empty() && router.allowed("/").empty());
+
+    // middlewares run in order, share the context with the handler, and the first to answer
+    // ends the chain
+    std::vector<std::string> chain;
+    bool admit = true;
+    indiepub::Router guarded;
+    guarded.add(HttpMethod::GET, "/", {.auth_required = true}, [&chain](const indiepub::RequestContext &context, HttpResponse &) {
+        chain.push_back(context.authenticated() ? "handler" : "anonymous");
+    });
+    guarded.use([&chain](indiepub::RequestContext &context, HttpResponse &) {
+        chain.push_back("auth");
+        context.authenticate(indiepub::Credentials(), indiepub::User());
+        return true;
+    });
+    guarded.use([&chain, &admit](indiepub::RequestContext &, HttpResponse &) {
+        chain.push_back("admit");
+        return admit;
+    });
+    guarded.dispatch(HttpMethod::GET, request, response);
+    assert((chain == std::vector<std::string>{"auth", "admit", "handler"}));
+    chain.clear();
+    admit = false;
+    guarded.dispatch(HttpMethod::GET, request, response);
+    assert((chain == std::vector<std::string>{"auth", "admit"}));
+
+    // the wrong method on a known path is a 405 that runs neither middleware nor handler
+    HttpResponse refused;
+    guarded.dispatch(HttpMethod::POST, request, refused);
+    assert(refused.getStatus() == 405 && chain.size() == 2);
+}
+
+void testCompression()
+{
+    using indiepub::Compression;
+    using indiepub::ContentEncoding;
+    assert(Compression::negotiate("") == ContentEncoding::IDENTITY);
+    assert(Compression::negotiate("gzip, deflate, br") == ContentEncoding::GZIP);
+    assert(Compression::negotiate("deflate;q=1.0, gzip;q=0.5") == ContentEncoding::DEFLATE);
+    assert(Compression::negotiate("GZIP;q=0, deflate") == ContentEncoding::DEFLATE);
+    assert(Compression::negotiate("gzip;q=0, *") == ContentEncoding::DEFLATE);
+    assert(Compression::negotiate("*;q=0, br") == ContentEncoding::IDENTITY);
+    assert(Compression::negotiate("identity") == ContentEncoding::IDENTITY);
+
+    std::string body;
+    for (int i = 0; i < 200; ++i)
+        body += "{\"event_id\": \"" + std::to_string(i) + "\", \"name\": \"Matinee\"},";
+    for (ContentEncoding encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE})
+    {
+        std::string packed = Compression::compress(body, encoding, 6);
+        assert(!packed.empty() && packed.size() < body.size());
+        // gzip carries its magic number, zlib-wrapped deflate does not
+        assert((static_cast<unsigned char>(packed[0]) == 0x1f && static_cast<unsigned char>(packed[1]) == 0x8b) == (encoding == ContentEncoding::GZIP));
+
+        z_stream stream{};
+        assert(inflateInit2(&stream, 15 + 32) == Z_OK);
+        std::string unpacked(body.size() + 1, '\0');
+        stream.next_in = reinterpret_cast<Bytef *>(&packed[0]);
+        stream.avail_in = static_cast<uInt>(packed.size());
+        stream.next_out = reinterpret_cast<Bytef *>(&unpacked[0]);
+        stream.avail_out = static_cast<uInt>(unpacked.size());
+        assert(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+        unpacked.resize(stream.total_out);
+        inflateEnd(&stream);
+        assert(unpacked == body);
+    }
+    assert(Compression::compress(body, ContentEncoding::IDENTITY, 6) == body);
+
+    // level 0 turns compression off whatever the client accepts
+    Compression off(Compression::Options{0, 0});
+    indiepub::RouteParams params;
+    indiepub::RouteMeta meta;
+    HttpRequest request;
+    indiepub::RequestContext context(request, params, meta);
+    assert(off.choose(context) == ContentEncoding::IDENTITY);
+
+    // a precompressed body marked on a rebound context is seen by the filters on the original
+    HttpRequest copy;
+    indiepub::RequestContext rebound(context, copy, params);
+    assert(context.contentEncoding() == ContentEncoding::IDENTITY);
+    rebound.setContentEncoding(ContentEncoding::GZIP);
+    assert(context.contentEncoding() == ContentEncoding::GZIP);
+
+    // the shared instance takes the options validated at startup, and only before its first use
+    Compression::configure(Compression::Options{0, 0});
+    assert(Compression::instance().choose(context) == ContentEncoding::IDENTITY);
+    bool late = false;
+    try
+    {
+        Compression::configure(Compression::Options::defaults());
+    }
+    catch (const std::logic_error &)
+    {
+        late = true;
+    }
+    assert(late);
+}
+
+void testAdmission()
+{
+    using indiepub::Admission;
+    using indiepub::RouteClass;
+    auto options = [](size_t limit, Admission::Limits limits) {
+        Admission::Options options{limit, {}, std::chrono::seconds(1)};
+        options.classes.fill(limits);
+        return options;
+    };
+
+    // one running read, one waiting until its deadline, the next shed at once
+    Admission reads(options(4, {1, 1, std::chrono::milliseconds(200)}));
+    assert(reads.admit(RouteClass::READ));
+    std::future<bool> waiter = std::async(std::launch::async, [&reads]() { return reads.admit(RouteClass::READ); });
+    while (reads.exposition().find("indieback_admission_queued{class=\"read\"} 1") == std::string::npos)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(!reads.admit(RouteClass::READ));
+    assert(reads.admit(RouteClass::WRITE));
+    assert(!waiter.get());
+    std::string metrics = reads.exposition();
+    assert(metrics.find("indieback_admission_shed_total{class=\"read\",reason=\"queue_full\"} 1") != std::string::npos);
+    assert(metrics.find("indieback_admission_shed_total{class=\"read\",reason=\"deadline\"} 1") != std::string::npos);
+    assert(metrics.find("indieback_admission_running{class=\"write\"} 1") != std::string::npos);
+    reads.release(RouteClass::READ);
+    reads.release(RouteClass::WRITE);
+    assert(reads.admit(RouteClass::READ));
+    reads.release(RouteClass::READ);
+
+    // a freed shared slot goes to the write queued after the read
+    Admission shared(options(1, {2, 4, std::chrono::seconds(5)}));
+    assert(shared.admit(RouteClass::AUTH));
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto run = [&](RouteClass routeClass) {
+        return std::async(std::launch::async, [&, routeClass]() {
+            assert(shared.admit(routeClass));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(Admission::name(routeClass));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            shared.release(routeClass);
+        });
+    };
+    std::future<void> read = run(RouteClass::READ);
+    while (shared.exposition().find("indieback_admission_queued{class=\"read\"} 1") == std::string::npos)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::future<void> write = run(RouteClass::WRITE);
+    while (shared.exposition().find("indieback_admission_queued{class=\"write\"} 1") == std::string::npos)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    shared.release(RouteClass::AUTH);
+    write.get();
+    read.get();
+    assert((order == std::vector<std::string>{"write", "read"}));
+
+    // the default shared limit leaves workers over for requests to wait in
+    assert(Admission::Options::defaults(4).limit == 3 && Admission::Options::defaults(16).limit == 12);
+    assert(Admission::Options::defaults(1).limit == 1);
+
+    // the middleware holds the slot for as long as the request's context lives
+    Admission strict(options(4, {1, 0, std::chrono::milliseconds(0)}));
+    indiepub::RouteParams params;
+    indiepub::RouteMeta meta{.route_class = RouteClass::AUTH};
+    HttpRequest request;
+    HttpResponse response;
+    {
+        indiepub::RequestContext context(request, params, meta);
+        assert(strict.admit(context, response));
+        indiepub::RequestContext other(request, params, meta);
+        assert(!strict.admit(other, response));
+    }
+    assert(strict.admit(RouteClass::AUTH));
+    strict.release(RouteClass::AUTH);
+}
+
+void testRateLimiter()
+{
+    using Clock = indiepub::RateLimiter::Clock;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+    indiepub::RateLimiter limiter(indiepub::RateLimiter::Options{1, 8, false});
+    Clock::time_point now = Clock::now();
+
+    // a burst of the full minute's allowance, then one token every 6 seconds
+    for (int i = 0; i < 10; ++i)
+        assert(limiter.take("login|ip|10.0.0.1", 10, now) == milliseconds(0));
+    milliseconds wait = limiter.take("login|ip|10.0.0.1", 10, now);
+    assert(wait > seconds(5) && wait <= seconds(6));
+    assert(limiter.take("login|ip|10.0.0.2", 10, now) == milliseconds(0));
+    assert(limiter.take("login|ip|10.0.0.1", 10, now + seconds(6)) == milliseconds(0));
+    assert(limiter.take("login|ip|10.0.0.1", 10, now + seconds(6)) > milliseconds(0));
+    assert(limiter.take("login|ip|10.0.0.1", 0, now) == milliseconds(0));
+    // 10.0.0.2 refilled its one token by now
+    assert(limiter.size() == 1);
+
+    // buckets go once they would be full again; one still in use is kept, even past the wheel's reach
+    assert(limiter.take("signup|ip|10.0.0.3", 600, now + seconds(60)) == milliseconds(0));
+    assert(limiter.size() == 2);
+    assert(limiter.take("login|ip|10.0.0.4", 10, now + seconds(63)) == milliseconds(0));
+    assert(limiter.size() == 2);
+    assert(limiter.take("login|ip|10.0.0.5", 10, now + seconds(200)) == milliseconds(0));
+    assert(limiter.size() == 1);
+    assert(limiter.exposition().find("indieback_rate_limit_buckets 1") != std::string::npos);
+
+    // clients are never pooled: without a trusted address no client is limited
+    indiepub::RateLimiter untrusted(indiepub::RateLimiter::Options{1, 8, false});
+    indiepub::RouteParams params;
+    indiepub::RouteMeta meta{.rate_limit = 2};
+    HttpRequest request;
+    HttpResponse response;
+    indiepub::RequestContext first(request, params, meta);
+    indiepub::RequestContext second(request, params, meta);
+    assert(untrusted.clientAddress(first).empty());
+    for (int i = 0; i < 5; ++i)
+        assert(untrusted.limitClient(first, response) && untrusted.limitClient(second, response));
+    assert(untrusted.size() == 0);
+    // nor when the proxy is trusted but the request came without its headers
+    indiepub::RateLimiter trusted(indiepub::RateLimiter::Options{1, 8, true});
+    for (int i = 0; i < 5; ++i)
+        assert(trusted.limitClient(first, response));
+    assert(trusted.size() == 0);
+}
+
+void testLifecycle()
+{
+    using indiepub::Lifecycle;
+    indiepub::HttpListeners::Options options = indiepub::HttpListeners::Options::fromEnvironment();
+    options.listeners = 1;
+    indiepub::HttpListeners listeners(options);
+    Lifecycle::Options timeouts{std::chrono::milliseconds(200), std::chrono::milliseconds(200)};
+
+    // without a predecessor there is nothing to wait for
+    unsetenv(Lifecycle::HANDOFF_VARIABLE);
+    Lifecycle first(listeners, timeouts);
+    assert(!first.adopt() && first.takeOver());
+
+    // only a Unix socket is taken for the channel to the predecessor
+    int pipeEnds[2];
+    assert(pipe(pipeEnds) == 0);
+    setenv(Lifecycle::HANDOFF_VARIABLE, std::to_string(pipeEnds[0]).c_str(), 1);
+    Lifecycle impostor(listeners, timeouts);
+    assert(!impostor.adopt() && getenv(Lifecycle::HANDOFF_VARIABLE) == nullptr);
+    close(pipeEnds[0]);
+    close(pipeEnds[1]);
+
+    // the successor reports ready, then waits until the predecessor is gone
+    int channel[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, channel) == 0);
+    setenv(Lifecycle::HANDOFF_VARIABLE, std::to_string(channel[1]).c_str(), 1);
+    Lifecycle successor(listeners, timeouts);
+    assert(successor.adopt());
+    std::thread predecessor([&channel]() {
+        char ready = 0;
+        assert(read(channel[0], &ready, 1) == 1 && ready == 'R');
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        close(channel[0]);
+    });
+    auto waited = std::chrono::steady_clock::now();
+    assert(successor.takeOver());
+    assert(std::chrono::steady_clock::now() - waited >= std::chrono::milliseconds(50));
+    predecessor.join();
+
+    // one that never exits is given up on after its drain and handoff timeouts
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, channel) == 0);
+    setenv(Lifecycle::HANDOFF_VARIABLE, std::to_string(channel[1]).c_str(), 1);
+    Lifecycle stale(listeners, timeouts);
+    assert(stale.adopt() && !stale.takeOver());
+    close(channel[0]);
+
+    // a request being handled holds the drain until it is answered
+    std::atomic<bool> entered{false};
+    listeners.setHttpHandler(HttpMethod::GET, "/", [&entered](const indiepub::RequestContext &, HttpResponse &) {
+        entered.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    });
+    HttpRequest request;
+    std::thread worker([&listeners, &request]() {
+        HttpResponse response;
+        listeners.handle(HttpMethod::GET, request, response);
+    });
+    while (!entered.load())
+        std::this_thread::yield();
+    auto started = std::chrono::steady_clock::now();
+    assert(listeners.inFlight() == 1 && !listeners.draining());
+    assert(listeners.drain(std::chrono::seconds(5)) && listeners.draining());
+    assert(std::chrono::steady_clock::now() - started >= std::chrono::milliseconds(50) && listeners.inFlight() == 0);
+    worker.join();
+    // later requests are refused without reaching the route
+    entered.store(false);
+    HttpResponse refused;
+    listeners.handle(HttpMethod::GET, request, refused);
+    assert(!entered.load() && listeners.inFlight() == 0);
+
+    // one never answered runs the drain out
+    indiepub::HttpListeners stuck(options);
+    std::atomic<bool> release{false};
+    stuck.setHttpHandler(HttpMethod::GET, "/", [&entered, &release](const indiepub::RequestContext &, HttpResponse &) {
+        entered.store(true);
+        while (!release.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    });
+    std::thread held([&stuck, &request]() {
+        HttpResponse response;
+        stuck.handle(HttpMethod::GET, request, response);
+    });
+    while (!entered.load())
+        std::this_thread::yield();
+    assert(!stuck.drain(std::chrono::milliseconds(50)) && stuck.inFlight() == 1);
+    release.store(true);
+    held.join();
+}
+
+void testEnvironment()
+{
+    // unset and empty both mean the default
+    unsetenv("INDIEBACK_TEST_OPTION");
+    assert(indiepub::env::number("INDIEBACK_TEST_OPTION", 7) == 7 && indiepub::env::text("INDIEBACK_TEST_OPTION", "x") == "x");
+    setenv("INDIEBACK_TEST_OPTION", "", 1);
+    assert(indiepub::env::flag("INDIEBACK_TEST_OPTION", true));
+    setenv("INDIEBACK_TEST_OPTION", "off", 1);
+    assert(!indiepub::env::flag("INDIEBACK_TEST_OPTION", true));
+    setenv("INDIEBACK_TEST_OPTION", "250", 1);
+    assert(indiepub::env::milliseconds("INDIEBACK_TEST_OPTION", 0) == std::chrono::milliseconds(250));
+
+    // a malformed or out-of-range value is refused rather than read as something else
+    for (const char *bad : {"-1", "12abc", "abc", "99999999999999999999"})
+    {
+        setenv("INDIEBACK_TEST_OPTION", bad, 1);
+        bool thrown = false;
+        try
+        {
+            indiepub::env::number("INDIEBACK_TEST_OPTION", 7);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            thrown = std::string(e.what()).find("INDIEBACK_TEST_OPTION") != std::string::npos;
+        }
+        assert(thrown);
+    }
+    setenv("INDIEBACK_TEST_OPTION", "10", 1);
+    bool thrown = false;
+    try
+    {
+        indiepub::env::number("INDIEBACK_TEST_OPTION", 7, 0, 9);
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    unsetenv("INDIEBACK_TEST_OPTION");
+}
+
+void testServer()
+{
+    testEnvironment();
+    testHttpListeners();
+    testRouter();
+    testCompression();
+    testAdmission();
+    testRateLimiter();
+    testAsync();
+    testTask();
+    testAsyncResponse();
+    testLifecycle();
+}
+
+void testAuth()
+{
+    testSessionToken();
+    testSessionKeys();
+    testCryptoExecutor();
+    testPasswordHasher();
+}
+
+void testCaches()
+{
+    testInvalidationBus();
+    testEntityCache();
+    testInvalidationChannel();
+    testEntityCodec();
+    testSharedCache();
+    testCacheSnapshot();
+    testCacheBudget();
+}
+
 int main(int argc, char *argv[])
 {
     std::string testType = "all";
@@ -667,6 +1881,9 @@ int main(int argc, char *argv[])
         testCassandraConnection();
         testModels();
         testControllers();
+        testCaches();
+        testAuth();
+        testServer();
     }
     else if (testType == "cassandra")
     {
@@ -680,6 +1897,18 @@ int main(int argc, char *argv[])
     {
         testControllers();
     }
+    else if (testType == "cache")
+    {
+        testCaches();
+    }
+    else if (testType == "auth")
+    {
+        testAuth();
+    }
+    else if (testType == "server")
+    {
+        testServer();
+    }
     else
     {
         std::time_t date = indiepub::string_to_timestamp("2025-08-01T16:16:50.744942");
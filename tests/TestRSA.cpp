@@ -1,10 +1,21 @@
 #include <algorithm>
+#include <cstdio>
+#include <atomic>
+#include <thread>
 #include <iostream>
 #include <vector>
 #include <cassert>
 #include <memory>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
 #include <crypto/AuthCrypto.hpp>
 #include <crypto/Hash.hpp>
+#include <crypto/CryptoContexts.hpp>
+#include <crypto/KeyRing.hpp>
+#include <crypto/RsaServer.hpp>
+#include <crypto/SessionCipher.hpp>
 #include <crypto/StringEncoder.hpp>
 #include <util/logging/Log.hpp>
 #include "config.h"
@@ -62,14 +73,13 @@ bool verifySignature(std::string text, std::string signature) {
 }
 
 void testHashing() {
-    std::vector<byte> data = StringEncoder::stringToBytes(originalText);
-    byte* md5Hash = Hash::md5(data.data());
-    byte* sha1Hash = Hash::sha1(data.data());
-    byte* sha256Hash = Hash::sha256(data.data());
+    auto md5Hash = Hash::md5(originalText);
+    auto sha1Hash = Hash::sha1(originalText);
+    auto sha256Hash = Hash::sha256(originalText);
 
-    std::string md5Hex = StringEncoder::bytesToHex(md5Hash, EVP_MAX_MD_SIZE);
-    std::string sha1Hex = StringEncoder::bytesToHex(sha1Hash, SHA_DIGEST_LENGTH);
-    std::string sha256Hex = StringEncoder::bytesToHex(sha256Hash, SHA256_DIGEST_LENGTH);
+    std::string md5Hex = StringEncoder::bytesToHex(md5Hash.data(), md5Hash.size());
+    std::string sha1Hex = StringEncoder::bytesToHex(sha1Hash.data(), sha1Hash.size());
+    std::string sha256Hex = StringEncoder::bytesToHex(sha256Hash.data(), sha256Hash.size());
 
     unsigned long long md5Int = StringEncoder::hexToInteger(md5Hex);
     unsigned long long sha1Int = StringEncoder::hexToInteger(sha1Hex);
@@ -83,11 +93,11 @@ void testHashing() {
     std::cout << "SHA1 hash (Integer): " << sha1Int << std::endl;
     std::cout << "SHA256 hash (Integer): " << sha256Int << std::endl;
 
-    assert("fd684e0acf69f9b0ba6ef594973b2c97000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000" 
+    assert("9ce801356ab4b60d65d0aa7312316500" 
         == md5Hex && "Md5 Hash value matches");
-    assert("44c8b2d558fb360aa9a8b41ec4ed33677e4f002b" 
+    assert("e638dbd83d7fdbf705de0a0d926c0703c86e958b" 
         == sha1Hex && "SHA1 Hash value matches");
-    assert("276b5acc956324376962a341cb0b341d4ae1b093f2f4b823b093587da31845a5" 
+    assert("33e54b828047951455be93b47738a9225e93d25b59eaf5831862fa28b463798c" 
         == sha256Hex && "SHA256 Hash value matches");
 
     std::string hashValueStr = "18446744073709551615";
@@ -95,11 +105,238 @@ void testHashing() {
     assert(hashValue == md5Int);
     assert(hashValue == sha1Int);
     assert(hashValue == sha256Int);
+
+    // pointer/length input hashes past embedded NULs
+    std::string binary("abc\0def", 7);
+    assert(Hash::sha256(binary) != Hash::sha256(std::string_view("abc")));
+    assert(Hash::sha256(reinterpret_cast<const byte *>(binary.data()), binary.size()) == Hash::sha256(binary));
+
+    // streaming in uneven pieces matches the one-shot digest, and the stream can be reused
+    Hash::Stream<Hash::Algorithm::SHA256> stream;
+    for (size_t offset = 0; offset < originalText.size(); offset += 7)
+        stream.update(std::string_view(originalText).substr(offset, 7));
+    assert(stream.finish() == sha256Hash);
+    assert(stream.update(originalText).finish() == sha256Hash);
+    Hash::Stream<Hash::Algorithm::MD5> md5Stream;
+    assert(md5Stream.update(originalText).finish() == md5Hash);
+
+    // every thread gets its own digest, never another thread's buffer
+    std::vector<std::thread> workers;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; ++t)
+    {
+        workers.emplace_back([t, &mismatches]() {
+            std::string input = "thread-" + std::to_string(t);
+            auto expected = Hash::sha256(input);
+            for (int i = 0; i < 10000; ++i)
+            {
+                if (Hash::sha256(input) != expected)
+                    ++mismatches;
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    assert(mismatches == 0);
+}
+
+void testKeyRing()
+{
+    std::shared_ptr<const KeyPair> keys = KeyRing::instance().get(BACKEND_RSA_FILE_NAME);
+    assert(keys->publicKey() != nullptr && keys->privateKey() != nullptr);
+    assert(KeyRing::instance().get(BACKEND_RSA_FILE_NAME) == keys && "Key pair is parsed once");
+
+    // borrowed keys survive the per-operation cleanup, so one instance serves repeated calls
+    std::unique_ptr<AuthCrypto> server = RsaServer::getInstance();
+    std::string secret = "key ring secret";
+    for (int i = 0; i < 2; ++i)
+    {
+        byte *encrypted = nullptr;
+        size_t encryptedSize = server->encrypt((byte *)secret.c_str(), encrypted);
+        byte *decrypted = nullptr;
+        size_t decryptedSize = server->decrypt(encrypted, encryptedSize, decrypted);
+        assert(StringEncoder::bytesToString(decrypted, decryptedSize) == secret);
+        OPENSSL_free(encrypted);
+        OPENSSL_free(decrypted);
+    }
+    server.reset();
+    assert(keys->privateKey() != nullptr && "Releasing a borrower leaves the ring intact");
+    assert(keys->id().size() == 16 && RsaServer::keys()->find(keys->id()) == keys);
+
+    // rotation: the old pair moves to `<name>.<tag>` and keeps decrypting after a reload
+    std::string name = "indieback_rotation_" + std::to_string(getpid());
+    std::string retired = name + ".1";
+    AuthCrypto(name.c_str()).generateKeyPair();
+    std::shared_ptr<const KeyPair> first = KeyRing::instance().load(name);
+    std::shared_ptr<const KeySet> before = KeyRing::instance().keys(name);
+    assert(before->all().size() == 1 && before->current() == first);
+    byte *sealed = nullptr;
+    size_t sealedSize = AuthCrypto(name.c_str(), first).encrypt((byte *)secret.c_str(), sealed);
+
+    AuthCrypto current(name.c_str());
+    std::rename(current.getPrivateKeyFilename().c_str(), AuthCrypto(retired.c_str()).getPrivateKeyFilename().c_str());
+    std::rename(current.getPublicKeyFilename().c_str(), AuthCrypto(retired.c_str()).getPublicKeyFilename().c_str());
+    AuthCrypto(name.c_str()).generateKeyPair();
+    assert(KeyRing::instance().reload(name));
+    std::shared_ptr<const KeySet> after = KeyRing::instance().keys(name);
+    assert(after->all().size() == 2 && after->current()->id() != first->id());
+    assert(before->current() == first && "Readers keep the set they took");
+    byte *opened = nullptr;
+    size_t openedSize = AuthCrypto(name.c_str(), after->find(first->id())).decrypt(sealed, sealedSize, opened);
+    assert(StringEncoder::bytesToString(opened, openedSize) == secret);
+    OPENSSL_free(opened);
+    // with explicit rejection the new pair refuses what was sealed to the old one, so a client
+    // that names no key can have each pair tried in turn
+    opened = nullptr;
+    openedSize = AuthCrypto(name.c_str(), after->current()).decrypt(sealed, sealedSize, opened, nullptr, true);
+    assert(opened == nullptr && openedSize == static_cast<size_t>(-1));
+    openedSize = AuthCrypto(name.c_str(), after->find(first->id())).decrypt(sealed, sealedSize, opened, nullptr, true);
+    assert(StringEncoder::bytesToString(opened, openedSize) == secret);
+    OPENSSL_free(sealed);
+    OPENSSL_free(opened);
+
+    // a current pair that cannot be read does not replace a working one
+    std::remove(AuthCrypto(name.c_str()).getPrivateKeyFilename().c_str());
+    assert(!KeyRing::instance().reload(name) && KeyRing::instance().keys(name) == after);
+    for (const std::string &file : {name, retired})
+    {
+        AuthCrypto pair(file.c_str());
+        std::remove(pair.getPrivateKeyFilename().c_str());
+        std::remove(pair.getPublicKeyFilename().c_str());
+    }
+}
+
+long residentKb()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void testCryptoContexts()
+{
+    std::shared_ptr<const KeyPair> keys = KeyRing::instance().get(BACKEND_RSA_FILE_NAME);
+    EVP_PKEY_CTX *decryptCtx = CryptoContexts::decryptContext(keys->privateKey());
+    assert(decryptCtx != nullptr && CryptoContexts::decryptContext(keys->privateKey()) == decryptCtx && "Template is reused");
+    assert(CryptoContexts::digest() == CryptoContexts::digest());
+
+    std::unique_ptr<AuthCrypto> server = RsaServer::getInstance();
+    std::string text = "steady state";
+    auto roundTrip = [&server, &text]() {
+        byte *signature = nullptr;
+        size_t signatureSize = server->sign(text.c_str(), signature);
+        assert(server->verify(text.c_str(), signature, signatureSize));
+        OPENSSL_free(signature);
+        byte *encrypted = nullptr;
+        size_t encryptedSize = server->encrypt((byte *)text.c_str(), encrypted);
+        byte *decrypted = nullptr;
+        size_t decryptedSize = server->decrypt(encrypted, encryptedSize, decrypted);
+        assert(StringEncoder::bytesToString(decrypted, decryptedSize) == text);
+        OPENSSL_free(encrypted);
+        OPENSSL_free(decrypted);
+    };
+    for (int i = 0; i < 20; ++i)
+        roundTrip();
+    long before = residentKb();
+    for (int i = 0; i < 200; ++i)
+        roundTrip();
+    // a leaking library context per call used to grow by tens of kilobytes each time
+    assert(residentKb() - before < 1024 && "Memory stays flat across operations");
+
+    // a mangled signature fails without disturbing the cached verify context
+    byte *signature = nullptr;
+    size_t signatureSize = server->sign(text.c_str(), signature);
+    signature[0] ^= 0xff;
+    assert(!server->verify(text.c_str(), signature, signatureSize));
+    signature[0] ^= 0xff;
+    assert(server->verify(text.c_str(), signature, signatureSize));
+    OPENSSL_free(signature);
+}
+
+void testSessionCipher()
+{
+    std::vector<byte> key(SessionCipher::KEY_SIZE, 0x5c);
+    SessionCipher cipher(key.data(), key.size());
+    std::string sealed = cipher.seal(originalText, "session-1");
+    assert(sealed.size() == SessionCipher::IV_SIZE + originalText.size() + SessionCipher::TAG_SIZE);
+    // a fresh IV per message
+    assert(cipher.seal(originalText, "session-1") != sealed);
+
+    std::string opened;
+    assert(cipher.open(sealed, opened, "session-1") && opened == originalText);
+    assert(!cipher.open(sealed, opened, "session-2"));
+    std::string tampered = sealed;
+    tampered[SessionCipher::IV_SIZE] ^= 0x01;
+    assert(!cipher.open(tampered, opened, "session-1"));
+    assert(!cipher.open(sealed.substr(0, SessionCipher::IV_SIZE), opened, "session-1"));
+
+    std::vector<byte> otherKey(SessionCipher::KEY_SIZE, 0x3a);
+    assert(!SessionCipher(otherKey.data(), otherKey.size()).open(sealed, opened, "session-1"));
+    assert(cipher.open(cipher.seal(""), opened) && opened.empty());
+}
+
+void testStringEncoder()
+{
+    std::cout << "Codec kernels: " << StringEncoder::simdLevel() << std::endl;
+    // every length around the 12/16/32-byte vector steps, against OpenSSL's encoder
+    unsigned int seed = 7;
+    for (size_t length = 0; length < 200; ++length)
+    {
+        std::vector<byte> data(length);
+        for (auto &b : data)
+            b = static_cast<byte>(rand_r(&seed));
+        std::string expected(4 * ((length + 2) / 3) + 1, '\0');
+        expected.resize(EVP_EncodeBlock(reinterpret_cast<byte *>(&expected[0]), data.data(), static_cast<int>(length)));
+        std::string encoded = StringEncoder::base64Encode(data.data(), data.size());
+        assert(encoded == expected);
+        assert(StringEncoder::base64Decode(encoded) == data);
+
+        std::string hex = StringEncoder::bytesToHex(data.data(), data.size());
+        std::ostringstream reference;
+        for (byte b : data)
+            reference << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(b);
+        assert(hex == reference.str());
+        assert(StringEncoder::hexToBytes(hex) == data);
+    }
+
+    // line-wrapped, unpadded and upper-case input still decode
+    std::string wrapped = StringEncoder::base64Encode(reinterpret_cast<const byte *>(originalText.data()), originalText.size());
+    for (size_t i = 64; i < wrapped.size(); i += 65)
+        wrapped.insert(i, "\n");
+    assert(StringEncoder::bytesToString(StringEncoder::base64Decode(wrapped + "\n").data(), originalText.size()) == originalText);
+    assert(StringEncoder::base64Decode("YWI") == StringEncoder::stringToBytes("ab"));
+    assert(StringEncoder::hexToBytes("ABcd") == std::vector<byte>({0xab, 0xcd}));
+
+    // malformed input is rejected, not partially decoded
+    assert(StringEncoder::base64Decode("YWJj*GVm").empty());
+    assert(StringEncoder::base64Decode("YQ==YQ==").empty());
+    assert(StringEncoder::base64Decode("Y").empty());
+    std::string longInvalid(40, 'A');
+    longInvalid[20] = '-';
+    assert(StringEncoder::base64Decode(longInvalid).empty());
+    bool thrown = false;
+    try
+    {
+        StringEncoder::hexToBytes("abz0");
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    char buffer[8];
+    StringEncoder::hexEncode(reinterpret_cast<const byte *>("\x01\xfe"), 2, buffer);
+    assert(std::string(buffer, 4) == "01fe");
+    byte decoded[4];
+    assert(StringEncoder::base64Decode("AQL+", 4, decoded) == 3 && decoded[2] == 0xfe);
 }
 
 int main(int argc, char* argv[]) {
     // testEncryptionDecryption();
-    // testHashing();
+    std::cout << "Testing hashing..." << std::endl;
+    testHashing();
     std::cout << "Original text: " << originalText << std::endl;
     
     std::cout << "Testing RSA encryption and decryption..." << std::endl;
@@ -118,5 +355,17 @@ int main(int argc, char* argv[]) {
     std::cout << "Signature verification: " << (isVerified ? "Success" : "Failure") << std::endl;
     assert(isVerified && "Signature verification succeeded");
 
+    std::cout << "Testing the key ring..." << std::endl;
+    testKeyRing();
+
+    std::cout << "Testing cached crypto contexts..." << std::endl;
+    testCryptoContexts();
+
+    std::cout << "Testing session encryption..." << std::endl;
+    testSessionCipher();
+
+    std::cout << "Testing hex and base64 codecs..." << std::endl;
+    testStringEncoder();
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file